@@ -0,0 +1,37 @@
+// ArchiveBench.cpp
+// Measures the cost of consolidating a snapshot into a memory-mapped MetricArchive with the default tiers.
+#include "BenchUtils.h"
+#include "MetricArchive.h"
+#include "SystemInfo.h"
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+void runArchiveBench(int iterations) {
+    SystemInfo& systemInfo = SystemInfo::getInstance();
+    SystemInfoData data;
+    systemInfo.collectSystemInfo(data);
+
+    std::string path = "/tmp/system_diagnostics_bench_" + std::to_string(::getpid()) + ".archive";
+    MetricArchive archive;
+    const std::vector<ArchiveTierConfig> tiers = { { 1, 3600 }, { 60, 1440 }, { 3600, 720 } };
+    if (!archive.open(path, systemInfo.getSnapshotSchema(), tiers)) {
+        std::printf("Skipping archive: could not create %s\n", path.c_str());
+        return;
+    }
+
+    // Ten samples per second, so every tenth append completes a row and every 600th cascades into the minute tier
+    long long timeNs = 1700000000000000000LL;
+    BenchResult append = runBenchmark(iterations, [&]() {
+        timeNs += 100000000LL;
+        data.time_stamp_ns = timeNs;
+        data.sample_lateness_ns = 0;
+        archive.append(data);
+    });
+    archive.close();
+    std::remove(path.c_str());
+
+    reportResult("archive", "append", data.cpu_num_processors, append);
+    std::printf("%-24s fields=%-5zu append: %8.1f ns/snapshot %6.1f allocs/op\n", "archive",
+                systemInfo.getSnapshotSchema().getFields().size(), append.nsPerOp, append.allocationsPerOp);
+}
@@ -0,0 +1,203 @@
+// BenchMain.cpp
+// Entry point of system_diagnostics_bench: runs every benchmark, or only the one named on the command line.
+// --json writes every measurement as JSON Lines, which --baseline compares a run against.
+#include "BenchUtils.h"
+#include <nlohmann/json.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+void runProcStatBench(int iterations);
+void runCpuUsageBench(int iterations);
+void runCollectBench(int iterations);
+void runPrinterBench(int iterations);
+void runSnapshotContentionBench(int iterations);
+void runSnapshotWriteBench(int iterations);
+void runSharedRingBench(int iterations);
+void runHistoryBench(int iterations);
+void runArchiveBench(int iterations);
+void runSinkBench(int iterations);
+void runLatencyHistogramBench(int iterations);
+void runPipelineBench(int iterations);
+void runCaptureBench(int iterations);
+
+struct Benchmark {
+    const char* name;
+    void (*run)(int iterations);
+    int defaultIterations;
+};
+
+static const Benchmark benchmarks[] = {
+    {"proc_stat", runProcStatBench, 2000},
+    {"cpu_usage", runCpuUsageBench, 2000},
+    {"collect", runCollectBench, 20000},
+    {"printer", runPrinterBench, 50},
+    {"snapshot_contention", runSnapshotContentionBench, 200000},
+    {"snapshot_write", runSnapshotWriteBench, 100000},
+    {"shared_ring", runSharedRingBench, 100000},
+    {"history", runHistoryBench, 100000},
+    {"archive", runArchiveBench, 100000},
+    {"sink", runSinkBench, 20000},
+    {"latency_histogram", runLatencyHistogramBench, 1000000},
+    {"pipeline", runPipelineBench, 20000},
+    {"capture", runCaptureBench, 20000},
+};
+
+static std::string resultKey(const std::string& benchmark, const std::string& variant, int cores) {
+    return benchmark + " | " + variant + " | cores=" + std::to_string(cores);
+}
+
+static nlohmann::json toJson(const ReportedResult& reported) {
+    nlohmann::json line;
+    line["benchmark"] = reported.benchmark;
+    line["variant"] = reported.variant;
+    line["cores"] = reported.cores;
+    line["ns_per_op"] = reported.result.nsPerOp;
+    // nlohmann writes NaN as null
+    line["allocs_per_op"] = reported.result.allocationsPerOp;
+    return line;
+}
+
+static bool writeResults(const std::string& path) {
+    std::ofstream file;
+    std::ostream* out = &std::cout;
+    if (path != "-") {
+        file.open(path.c_str());
+        if (!file) {
+            std::cerr << "Error: Could not write " << path << "\n";
+            return false;
+        }
+        out = &file;
+    }
+    for (const ReportedResult& reported : getReportedResults()) {
+        *out << toJson(reported).dump() << "\n";
+    }
+    return true;
+}
+
+// Prints every result next to the baseline's result for the same benchmark, variant and core count
+static bool compareWithBaseline(const std::string& path) {
+    std::ifstream file(path.c_str());
+    if (!file) {
+        std::cerr << "Error: Could not read " << path << "\n";
+        return false;
+    }
+    std::map<std::string, nlohmann::json> baseline;
+    std::string text;
+    while (std::getline(file, text)) {
+        if (text.empty()) {
+            continue;
+        }
+        try {
+            nlohmann::json line = nlohmann::json::parse(text);
+            baseline[resultKey(line.at("benchmark").get<std::string>(), line.at("variant").get<std::string>(), line.at("cores").get<int>())] = line;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: Invalid result in " << path << ": " << e.what() << "\n";
+            return false;
+        }
+    }
+
+    std::printf("\nCompared with %s:\n", path.c_str());
+    for (const ReportedResult& reported : getReportedResults()) {
+        std::string key = resultKey(reported.benchmark, reported.variant, reported.cores);
+        std::map<std::string, nlohmann::json>::const_iterator found = baseline.find(key);
+        if (found == baseline.end() || !found->second["ns_per_op"].is_number()) {
+            std::printf("%-80s %12.1f ns/op (new)\n", key.c_str(), reported.result.nsPerOp);
+            continue;
+        }
+        double baselineNs = found->second["ns_per_op"].get<double>();
+        double change = baselineNs > 0 ? (reported.result.nsPerOp / baselineNs - 1.0) * 100.0 : 0.0;
+        std::printf("%-80s %12.1f -> %12.1f ns/op %+7.1f%%", key.c_str(), baselineNs, reported.result.nsPerOp, change);
+        if (found->second["allocs_per_op"].is_number() && !std::isnan(reported.result.allocationsPerOp)) {
+            std::printf(" | %8.1f -> %8.1f allocs/op", found->second["allocs_per_op"].get<double>(), reported.result.allocationsPerOp);
+        }
+        std::printf("\n");
+    }
+    return true;
+}
+
+static bool parseCoreCounts(const std::string& text) {
+    std::vector<int> coreCounts;
+    std::istringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int cores = std::atoi(item.c_str());
+        if (cores <= 0) {
+            return false;
+        }
+        coreCounts.push_back(cores);
+    }
+    if (coreCounts.empty()) {
+        return false;
+    }
+    setBenchCoreCounts(coreCounts);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    const char* selected = nullptr;
+    int iterations = 0;
+    std::string resultsPath;
+    std::string baselinePath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            std::cout << "Usage: system_diagnostics_bench [options] [benchmark|all] [iterations]\n"
+                      << "Options:\n"
+                      << "  --cores <n,n,...>    Core counts of the scaling benchmarks (default 8,64,256,1024)\n"
+                      << "  --json <file>        Write every result as JSON Lines, - for standard output\n"
+                      << "  --baseline <file>    Compare the results with a previous --json file\n"
+                      << "Benchmarks:\n";
+            for (const Benchmark& benchmark : benchmarks) {
+                std::cout << "  " << benchmark.name << "\n";
+            }
+            return 0;
+        } else if (arg == "--cores" && i + 1 < argc) {
+            if (!parseCoreCounts(argv[++i])) {
+                std::cerr << "Error: Invalid core counts " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--json" && i + 1 < argc) {
+            resultsPath = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (selected == nullptr) {
+            selected = argv[i];
+        } else {
+            iterations = std::atoi(argv[i]);
+        }
+    }
+
+    bool found = false;
+    for (const Benchmark& benchmark : benchmarks) {
+        if (selected && std::strcmp(selected, "all") != 0 && std::strcmp(selected, benchmark.name) != 0) {
+            continue;
+        }
+        found = true;
+        benchmark.run(iterations > 0 ? iterations : benchmark.defaultIterations);
+    }
+
+    if (!found) {
+        std::cerr << "Error: Unknown benchmark " << selected << "\n";
+        return 1;
+    }
+    if (getNumFailures() > 0) {
+        std::cerr << "Error: " << getNumFailures() << " correctness check(s) failed\n";
+        return 1;
+    }
+    if (!baselinePath.empty() && !compareWithBaseline(baselinePath)) {
+        return 1;
+    }
+    if (!resultsPath.empty() && !writeResults(resultsPath)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+// BenchUtils.cpp
+// Replaces the global allocator so every benchmark can report allocations per operation, and keeps the
+// results of the run for the --json results file.
+#include "BenchUtils.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <unistd.h>
+
+static std::atomic<unsigned long long> allocationCount(0);
+
+unsigned long long getAllocationCount() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+static std::vector<ReportedResult> reportedResults;
+static std::vector<int> benchCoreCounts = {8, 64, 256, 1024};
+static size_t numFailures = 0;
+
+void reportResult(const std::string& benchmark, const std::string& variant, int cores, const BenchResult& result) {
+    ReportedResult reported = { benchmark, variant, cores, result };
+    reportedResults.push_back(reported);
+}
+
+const std::vector<ReportedResult>& getReportedResults() {
+    return reportedResults;
+}
+
+void reportFailure(const std::string& benchmark, const std::string& message) {
+    std::fprintf(stderr, "FAILED %s: %s\n", benchmark.c_str(), message.c_str());
+    ++numFailures;
+}
+
+size_t getNumFailures() {
+    return numFailures;
+}
+
+const std::vector<int>& getBenchCoreCounts() {
+    return benchCoreCounts;
+}
+
+void setBenchCoreCounts(const std::vector<int>& coreCounts) {
+    benchCoreCounts = coreCounts;
+}
+
+std::string writeSyntheticStatFile(int numCores) {
+    char path[] = "/tmp/system_diagnostics_stat_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return "";
+    }
+    close(fd);
+
+    std::ofstream file(path);
+    file << "cpu  4705 356 584 3699176 23060 0 277 0 0 0\n";
+    for (int core = 0; core < numCores; ++core) {
+        file << "cpu" << core << " " << 1393280 + core << " 32966 572056 " << 13343292 + core * 7 << " 6021 0 17 0 0 0\n";
+    }
+    file << "intr 114930548 113199788 3 0 5 263 0 4 [...] 0 0 0\n";
+    file << "ctxt 1990473\nbtime 1062191376\nprocesses 2915\nprocs_running 1\nprocs_blocked 0\n";
+    return path;
+}
@@ -0,0 +1,57 @@
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+struct BenchResult {
+    double nsPerOp;
+    double allocationsPerOp; // NaN when the benchmark does not count allocations
+};
+
+// One measurement of the run, as written to the --json results file
+struct ReportedResult {
+    std::string benchmark; // Name on the command line, e.g. "cpu_usage"
+    std::string variant;   // What was measured within the benchmark, e.g. "calculate"
+    int cores;             // Simulated core count, or the real one for benchmarks on the live system
+    BenchResult result;
+};
+
+// Records a measurement for the results file. Benchmarks still print their own human-readable line.
+void reportResult(const std::string& benchmark, const std::string& variant, int cores, const BenchResult& result);
+const std::vector<ReportedResult>& getReportedResults();
+
+// Records a failed correctness check of a benchmark, e.g. a decoded value that differs from the one stored.
+// The message is printed right away, and the run exits with a non-zero status once every benchmark ran.
+void reportFailure(const std::string& benchmark, const std::string& message);
+size_t getNumFailures();
+
+// Core counts the scaling benchmarks run at, 8 to 1024 unless --cores gives others
+const std::vector<int>& getBenchCoreCounts();
+void setBenchCoreCounts(const std::vector<int>& coreCounts);
+
+// Writes a /proc/stat with numCores cores to a temporary file and returns its path, empty on failure.
+// The caller removes the file.
+std::string writeSyntheticStatFile(int numCores);
+
+// Number of calls to operator new since the start of the process (counted by BenchUtils.cpp)
+unsigned long long getAllocationCount();
+
+template<typename Function>
+BenchResult runBenchmark(int iterations, Function function) {
+    function(); // Warm up, lets buffers reach their steady-state size
+
+    unsigned long long allocationsBefore = getAllocationCount();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        function();
+    }
+    auto end = std::chrono::steady_clock::now();
+    unsigned long long allocationsAfter = getAllocationCount();
+
+    double elapsedNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    return { elapsedNs / iterations, static_cast<double>(allocationsAfter - allocationsBefore) / iterations };
+}
+
+#endif // BENCH_UTILS_H
@@ -0,0 +1,152 @@
+// CaptureBench.cpp
+// Measures the cost of recording a procfs read into a capture and of replaying it, and the size of the
+// capture per read. Checks that every replayed read gives ProcFile the bytes it saw while recording, through
+// unchanged, growing, shrinking, unrelated and empty contents, so both 'R' and 'D' records are decoded.
+#include "BenchUtils.h"
+#include "ProcCapture.h"
+#include "ProcFile.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Next value of a small deterministic generator, so a failing check can be reproduced
+static unsigned long long nextRandom(unsigned long long& state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 33;
+}
+
+// Contents of the next read: a /proc/stat-like file whose counters grow, with lines that come and go and,
+// now and then, contents that have nothing to do with the previous ones
+static void nextContents(int read, unsigned long long& state, std::vector<unsigned long long>& counters, const std::string& previous,
+                         std::string& contents) {
+    if (read % 5 == 1) {
+        contents = previous;
+        return;
+    }
+    if (read % 53 == 0) {
+        counters.resize(8 + nextRandom(state) % 32, 1000);
+    }
+    for (unsigned long long& counter : counters) {
+        if (nextRandom(state) % 3 == 0) {
+            counter += nextRandom(state) % (read % 7 == 0 ? 1000000 : 100); // Sometimes a digit more
+        }
+    }
+
+    contents.clear();
+    if (read % 211 == 0) {
+        return;
+    }
+    if (read % 97 == 0) {
+        size_t size = nextRandom(state) % 8192;
+        for (size_t i = 0; i < size; ++i) {
+            contents.push_back(static_cast<char>(nextRandom(state)));
+        }
+        return;
+    }
+    char line[64];
+    for (size_t i = 0; i < counters.size(); ++i) {
+        std::snprintf(line, sizeof(line), "cpu%zu %llu 356 584 %llu 0 0 0\n", i, counters[i], counters[i] * 3);
+        contents += line;
+    }
+}
+
+// Overwrites the file in place, a ProcFile keeps it open
+static bool writeContents(int fd, const std::string& contents) {
+    return ::ftruncate(fd, 0) == 0 && ::pwrite(fd, contents.data(), contents.size(), 0) == static_cast<ssize_t>(contents.size());
+}
+
+void runCaptureBench(int iterations) {
+    ProcCapture& capture = ProcCapture::getInstance();
+    if (capture.getMode() != ProcCapture::OFF) {
+        std::printf("Skipping capture: system_info.capture is already recording or replaying\n");
+        return;
+    }
+
+    char sourcePath[] = "/tmp/system_diagnostics_capture_source_XXXXXX";
+    char capturePath[] = "/tmp/system_diagnostics_capture_XXXXXX";
+    int sourceFd = mkstemp(sourcePath);
+    int captureFd = mkstemp(capturePath);
+    if (sourceFd < 0 || captureFd < 0) {
+        std::printf("Skipping capture: could not create the files\n");
+        if (sourceFd >= 0) {
+            ::close(sourceFd);
+            ::unlink(sourcePath);
+        }
+        if (captureFd >= 0) {
+            ::close(captureFd);
+            ::unlink(capturePath);
+        }
+        return;
+    }
+    ::close(captureFd);
+
+    // Every read is followed by a tick, so the replay applies one read per tick
+    int numReads = iterations + 1;
+    std::vector<std::string> recorded(numReads);
+    unsigned long long state = 1;
+    std::vector<unsigned long long> counters;
+    bool writeFailed = false;
+    if (capture.reopen(ProcCapture::RECORD, capturePath)) {
+        ProcFile file(sourcePath);
+        int read = 0;
+        BenchResult record = runBenchmark(iterations, [&]() {
+            nextContents(read, state, counters, read > 0 ? recorded[read - 1] : std::string(), recorded[read]);
+            writeFailed = !writeContents(sourceFd, recorded[read]) || writeFailed;
+            file.read();
+            TickInfo tick = { static_cast<long long>(read) * 1000000, 0, 0 };
+            capture.recordTick(tick, tick.deadlineNs);
+            ++read;
+        });
+        reportResult("capture", "record", 1, record);
+        std::printf("%-24s %8.1f ns/op %6.1f allocs/op (write + read + record)\n", "capture record", record.nsPerOp, record.allocationsPerOp);
+    }
+    ::close(sourceFd);
+
+    if (capture.getMode() != ProcCapture::RECORD || writeFailed) {
+        std::printf("Skipping capture: could not record\n");
+        capture.reopen(ProcCapture::OFF, "");
+        ::unlink(sourcePath);
+        ::unlink(capturePath);
+        return;
+    }
+
+    // Reopening closes the recording, after that the replay no longer needs the source file
+    if (capture.reopen(ProcCapture::REPLAY, capturePath)) {
+        ::unlink(sourcePath);
+        struct stat captureStat;
+        captureStat.st_size = 0;
+        ::stat(capturePath, &captureStat);
+        ProcFile file(sourcePath);
+        int read = 0;
+        bool failed = false;
+        BenchResult replay = runBenchmark(iterations, [&]() {
+            TickInfo tick;
+            long long timeStampNs;
+            if (failed) {
+                return;
+            }
+            if (!file.read() || std::string(file.data(), file.size()) != recorded[read]) {
+                reportFailure("capture", "read " + std::to_string(read) + " replayed as " + std::to_string(file.size()) + " bytes that differ from the " +
+                              std::to_string(recorded[read].size()) + " recorded");
+                failed = true;
+            } else if (!capture.nextTick(tick, timeStampNs) || tick.deadlineNs != static_cast<long long>(read) * 1000000) {
+                reportFailure("capture", "tick " + std::to_string(read) + " was not replayed");
+                failed = true;
+            }
+            ++read;
+        });
+        std::printf("capture round trip of %d reads: %s\n", read, failed ? "FAILED" : "ok");
+        reportResult("capture", "replay", 1, replay);
+        std::printf("%-24s %8.1f ns/op %6.1f allocs/op | %.1f bytes of capture per read\n", "capture replay", replay.nsPerOp,
+                    replay.allocationsPerOp, static_cast<double>(captureStat.st_size) / numReads);
+    } else {
+        reportFailure("capture", "could not replay the capture just recorded");
+    }
+
+    capture.reopen(ProcCapture::OFF, "");
+    ::unlink(sourcePath);
+    ::unlink(capturePath);
+}
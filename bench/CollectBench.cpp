@@ -0,0 +1,78 @@
+// CollectBench.cpp
+// Measures what a reader pays for the latest snapshot at every benchmarked core count: the seqlock copy behind
+// collectSystemInfo(), packageSystemInfoForMIDAS() and serializing with the snapshot schema. Snapshots of
+// other core counts are the live snapshot with its per-core fields resized.
+#include "BenchUtils.h"
+#include "SeqLock.h"
+#include "SnapshotSchema.h"
+#include "SystemInfo.h"
+#include <cstdio>
+#include <vector>
+
+static void resizeCores(SystemInfoData& data, int numCores) {
+    data.cpu_num_processors = numCores;
+    data.cpu_usage_percent_per_core.assign(numCores, 42.0);
+    data.cpu_real_time_step_per_core.assign(numCores, 0.2);
+    data.cpu_usage_percent_per_window_per_core.assign(data.cpu_window_jiffies.size() * numCores, 42.0);
+}
+
+static void benchCores(const SystemInfoData& live, int numCores, int iterations) {
+    SystemInfoData published;
+    copySystemInfoData(live, published);
+    resizeCores(published, numCores);
+    SeqLock lock;
+
+    // Same as SystemInfo::collectSystemInfo(data), which is not tied to the live core count this way
+    SystemInfoData data;
+    BenchResult collect = runBenchmark(iterations, [&]() {
+        unsigned long long sequence;
+        do {
+            sequence = lock.readBegin();
+            copySystemInfoData(published, data);
+        } while (lock.readRetry(sequence));
+    });
+
+    double packagedSink = 0;
+    BenchResult package = runBenchmark(iterations, [&]() {
+        std::vector<double> packaged = SystemInfo::packageSystemInfoForMIDAS(published);
+        packagedSink += packaged[0];
+    });
+
+    SnapshotSchema schema;
+    schema.build(published);
+    std::vector<char> buffer(schema.getSize());
+    size_t written = 0;
+    BenchResult write = runBenchmark(iterations, [&]() {
+        written += schema.write(published, buffer.data(), buffer.size());
+    });
+
+    reportResult("collect", "collectSystemInfo", numCores, collect);
+    reportResult("collect", "packageSystemInfoForMIDAS", numCores, package);
+    reportResult("collect", "writeSnapshot", numCores, write);
+    std::printf("%-24s cores=%-5d collectSystemInfo: %9.1f ns/op %6.1f allocs/op | packageSystemInfoForMIDAS: %9.1f ns/op %6.1f allocs/op | "
+                "writeSnapshot: %9.1f ns/op %6.1f allocs/op\n",
+                "collect", numCores, collect.nsPerOp, collect.allocationsPerOp, package.nsPerOp, package.allocationsPerOp,
+                write.nsPerOp, write.allocationsPerOp);
+    if (packagedSink < 0 || written == 0 || data.cpu_num_processors != numCores) {
+        std::printf("Unexpected result\n");
+    }
+}
+
+void runCollectBench(int iterations) {
+    SystemInfo& systemInfo = SystemInfo::getInstance();
+    SystemInfoData live;
+    systemInfo.collectSystemInfo(live);
+
+    // The real thing, at the live core count
+    SystemInfoData data;
+    BenchResult collect = runBenchmark(iterations, [&]() {
+        systemInfo.collectSystemInfo(data);
+    });
+    reportResult("collect", "SystemInfo::collectSystemInfo live", live.cpu_num_processors, collect);
+    std::printf("%-24s cores=%-5d SystemInfo::collectSystemInfo: %9.1f ns/op %6.1f allocs/op\n",
+                "collect live", live.cpu_num_processors, collect.nsPerOp, collect.allocationsPerOp);
+
+    for (int numCores : getBenchCoreCounts()) {
+        benchCores(live, numCores, iterations);
+    }
+}
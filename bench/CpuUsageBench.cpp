@@ -0,0 +1,87 @@
+// CpuUsageBench.cpp
+// Measures CpuUsageCalculator at every benchmarked core count: adding a /proc/stat data point to the
+// counter history, and computing the usage of every core per core or in one pass over all windows.
+#include "BenchUtils.h"
+#include "CpuUsageCalculator.h"
+#include "ProcStatReader.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static const unsigned long long UPDATE_PERIOD_JIFFIES = 20;
+
+// Fills the whole history with counters that advance differently on every core, so usages are not trivially zero
+static void fillHistory(CpuUsageCalculator& calculator, unsigned long long& jiffies, size_t dataPoints) {
+    size_t numRows = calculator.getNumRows();
+    for (size_t point = 0; point < dataPoints; ++point) {
+        jiffies += UPDATE_PERIOD_JIFFIES;
+        for (size_t row = 0; row < numRows; ++row) {
+            unsigned long long busy = jiffies * (row % 7 + 1) / 8;
+            calculator.getPendingColumn(CpuUsageCalculator::USER_COLUMN)[row] = busy / 2;
+            calculator.getPendingColumn(CpuUsageCalculator::USER_LOW_COLUMN)[row] = busy / 8;
+            calculator.getPendingColumn(CpuUsageCalculator::SYS_COLUMN)[row] = busy - busy / 2 - busy / 8;
+            calculator.getPendingColumn(CpuUsageCalculator::IDLE_COLUMN)[row] = jiffies - busy;
+        }
+        calculator.commitDataPoint(jiffies, numRows);
+    }
+}
+
+static void benchCores(int numCores, int iterations) {
+    std::string statPath = writeSyntheticStatFile(numCores);
+    if (statPath.empty()) {
+        std::printf("Skipping cpu_usage: could not write a stat file for %d cores\n", numCores);
+        return;
+    }
+    ProcStatReader reader(statPath);
+    CpuUsageCalculator calculator;
+    calculator.reset(numCores, UPDATE_PERIOD_JIFFIES);
+    int numRows = static_cast<int>(calculator.getNumRows());
+
+    // What CpuCollector does per sample before computing usages: parse straight into the history and commit
+    unsigned long long jiffies = 0;
+    BenchResult add = runBenchmark(iterations, [&]() {
+        int rowsRead = reader.read(calculator.getPendingColumn(CpuUsageCalculator::USER_COLUMN),
+                                   calculator.getPendingColumn(CpuUsageCalculator::USER_LOW_COLUMN),
+                                   calculator.getPendingColumn(CpuUsageCalculator::SYS_COLUMN),
+                                   calculator.getPendingColumn(CpuUsageCalculator::IDLE_COLUMN), numRows);
+        jiffies += UPDATE_PERIOD_JIFFIES;
+        calculator.commitDataPoint(jiffies, static_cast<size_t>(rowsRead > 0 ? rowsRead : 0));
+    });
+    std::remove(statPath.c_str());
+
+    fillHistory(calculator, jiffies, 4096);
+
+    // Previous per-core API, one call per core and the total
+    double usageSink = 0;
+    BenchResult perCore = runBenchmark(iterations, [&]() {
+        for (int core = CpuUsageCalculator::TOTAL_CPU_USAGE_INDEX; core < numCores; ++core) {
+            usageSink += calculator.calculateCpuUsagePercentForCore(core).usagePercent;
+        }
+    });
+
+    // What CpuCollector does: one pass over every row per averaging window
+    std::vector<double> usagePercent(calculator.getNumRows());
+    BenchResult allWindows = runBenchmark(iterations, [&]() {
+        for (size_t window = 0; window < calculator.getNumWindows(); ++window) {
+            calculator.calculateCpuUsagePercentForWindow(window, usagePercent.data());
+        }
+        usageSink += usagePercent[0];
+    });
+
+    reportResult("cpu_usage", "addDataPoint", numCores, add);
+    reportResult("cpu_usage", "calculateCpuUsagePercentForCore", numCores, perCore);
+    reportResult("cpu_usage", "calculateCpuUsagePercentForWindow", numCores, allWindows);
+    std::printf("%-24s cores=%-5d addDataPoint: %10.1f ns/op %6.1f allocs/op | per core: %10.1f ns/op %6.1f allocs/op | "
+                "%zu windows: %10.1f ns/op %6.1f allocs/op\n",
+                "cpu_usage", numCores, add.nsPerOp, add.allocationsPerOp, perCore.nsPerOp, perCore.allocationsPerOp,
+                calculator.getNumWindows(), allWindows.nsPerOp, allWindows.allocationsPerOp);
+    if (usageSink < 0) {
+        std::printf("Unexpected result\n");
+    }
+}
+
+void runCpuUsageBench(int iterations) {
+    for (int numCores : getBenchCoreCounts()) {
+        benchCores(numCores, iterations);
+    }
+}
@@ -0,0 +1,176 @@
+// HistoryBench.cpp
+// Measures the cost of recording a snapshot into the compressed HistoryStore, the compression reached on
+// real samples, and the cost of a range query. Checks first that every encoding of the store decodes to the
+// values and times that were appended.
+#include "BenchUtils.h"
+#include "CollectorScheduler.h"
+#include "CpuCollector.h"
+#include "HistoryStore.h"
+#include "LoadAverageCollector.h"
+#include "MemoryCollector.h"
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Next value of a small deterministic generator, so a failing check can be reproduced
+static unsigned long long nextRandom(unsigned long long& state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 33;
+}
+
+struct ExpectedPoint {
+    long long timeNs;
+    double value;
+};
+
+// Compares what a query returns with the newest appended points, which are all that is kept once blocks roll over
+static bool checkSeries(const HistoryStore& history, const std::string& metric, const std::vector<ExpectedPoint>& expected) {
+    std::vector<HistoryPoint> points;
+    history.query(history.findSeries(metric), LLONG_MIN, LLONG_MAX, points);
+    if (points.empty() || points.size() >= expected.size()) {
+        reportFailure("history", metric + ": " + std::to_string(points.size()) + " points kept of " + std::to_string(expected.size()) +
+                      " appended, expected some and fewer after the blocks rolled over");
+        return false;
+    }
+
+    size_t offset = expected.size() - points.size();
+    for (size_t i = 0; i < points.size(); ++i) {
+        const ExpectedPoint& want = expected[offset + i];
+        // Bitwise, so -0.0 and every NaN payload have to survive the XOR encoding as well
+        if (points[i].timeNs != want.timeNs || std::memcmp(&points[i].value, &want.value, sizeof(double)) != 0) {
+            reportFailure("history", metric + ": point " + std::to_string(offset + i) + " decoded as (" + std::to_string(points[i].timeNs) +
+                          ", " + std::to_string(points[i].value) + "), appended (" + std::to_string(want.timeNs) + ", " +
+                          std::to_string(want.value) + ")");
+            return false;
+        }
+    }
+    return true;
+}
+
+// Appends points that take every path of the encoder (each delta-of-delta bucket including the 32-bit one, a time
+// jump that needs a new block, repeated, close and unrelated values) into a store small enough to roll over
+static void checkHistoryRoundTrip(const SystemInfoData& shape) {
+    SnapshotSchema schema;
+    schema.build(shape);
+    HistoryStore history;
+    history.init(schema, schema.getFields().size() * 1024 * 4, 1024); // Four blocks per series
+
+    static const long long deltaRangesMs[] = { 0, 60, 250, 2000, 1000000 };
+    unsigned long long state = 12345;
+    long long timeMs = 1700000000000LL;
+    long long deltaMs = 10;
+    double usage = 50.0;
+    std::vector<ExpectedPoint> usagePoints;
+    std::vector<ExpectedPoint> loadPoints;
+    std::vector<ExpectedPoint> availablePoints;
+    SystemInfoData data = shape;
+    for (int i = 0; i < 20000; ++i) {
+        // Mostly regular deltas, with runs in each bucket of the encoding
+        long long range = deltaRangesMs[(i / 50) % 5];
+        if (range > 0) {
+            deltaMs = 10 + static_cast<long long>(nextRandom(state) % static_cast<unsigned long long>(2 * range)) - range / 2;
+            deltaMs = deltaMs > 1 ? deltaMs : 1;
+        } else {
+            deltaMs = 10;
+        }
+        if (i % 5000 == 4999) {
+            deltaMs = static_cast<long long>(INT32_MAX) + 1000; // Beyond 32 bits, starts a new block
+        }
+        timeMs += deltaMs;
+
+        switch (nextRandom(state) % 4) {
+        case 0:
+            break; // Unchanged
+        case 1:
+            usage += static_cast<double>(nextRandom(state) % 100) / 1000.0;
+            break;
+        case 2:
+            usage = static_cast<double>(nextRandom(state)) / 7.0;
+            break;
+        default:
+            usage = (i % 3 == 0) ? -1.0 : -0.0;
+            break;
+        }
+
+        data.time_stamp_ns = timeMs * HistoryStore::TIME_RESOLUTION_NS;
+        data.sample_lateness_ns = 0;
+        data.cpu_usage_percent = usage;
+        data.load_avg_1min = static_cast<double>(i % 7) * 0.25;
+        data.memory.available_bytes = (nextRandom(state) << 20) + static_cast<unsigned long long>(i);
+        history.append(data);
+
+        usagePoints.push_back({ data.time_stamp_ns, data.cpu_usage_percent });
+        loadPoints.push_back({ data.time_stamp_ns, data.load_avg_1min });
+        availablePoints.push_back({ data.time_stamp_ns, static_cast<double>(static_cast<long long>(data.memory.available_bytes)) });
+    }
+
+    bool passed = checkSeries(history, "cpu.usage_percent", usagePoints);
+    passed = checkSeries(history, "load.avg_1min", loadPoints) && passed;
+    passed = checkSeries(history, "memory.available_bytes", availablePoints) && passed;
+    std::printf("%-24s round trip of %zu points per series: %s\n", "history", usagePoints.size(), passed ? "ok" : "FAILED");
+}
+
+void runHistoryBench(int iterations) {
+    unsigned long long jiffiesPerSecond = static_cast<unsigned long long>(sysconf(_SC_CLK_TCK));
+
+    // Record a second of real samples, replayed in a loop with a regular 10 ms timestamp
+    CollectorScheduler scheduler;
+    CpuCollector cpuCollector;
+    MemoryCollector memoryCollector;
+    LoadAverageCollector loadAverageCollector;
+    cpuCollector.init(jiffiesPerSecond, 1);
+    scheduler.addCollector(&cpuCollector, 1);
+    scheduler.addCollector(&memoryCollector, 1);
+    scheduler.addCollector(&loadAverageCollector, 1);
+    SystemInfoData shape;
+    scheduler.initSnapshot(shape, jiffiesPerSecond);
+    std::vector<SystemInfoData> samples(100, shape);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        scheduler.runDue(i + 1, 0, samples[i]);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    checkHistoryRoundTrip(shape);
+
+    SnapshotSchema schema;
+    schema.build(shape);
+    HistoryStore history;
+    history.init(schema, 64 * 1024 * 1024, 1024);
+
+    const long long periodNs = 10000000LL;
+    long long timeNs = 1700000000000000000LL;
+    size_t sample = 0;
+    BenchResult append = runBenchmark(iterations, [&]() {
+        SystemInfoData& data = samples[sample++ % samples.size()];
+        timeNs += periodNs;
+        data.time_stamp_ns = timeNs;
+        data.sample_lateness_ns = 0;
+        history.append(data);
+    });
+
+    int series = history.findSeries("cpu.core[0].usage_percent");
+    std::vector<HistoryPoint> points;
+    std::vector<HistoryAggregate> aggregates;
+    long long startNs = timeNs - 600 * 1000000000LL; // Last 10 minutes
+    BenchResult query = runBenchmark(10, [&]() {
+        points.clear();
+        history.query(series, startNs, timeNs + 1, points);
+    });
+    BenchResult aggregated = runBenchmark(10, [&]() {
+        aggregates.clear();
+        history.queryAggregated(series, startNs, timeNs + 1, 1000000000LL, aggregates);
+    });
+
+    double bitsPerPoint = history.getMemoryUsed() * 8.0 / static_cast<double>(history.getNumPoints());
+    reportResult("history", "append", shape.cpu_num_processors, append);
+    reportResult("history", "query 10 min", shape.cpu_num_processors, query);
+    reportResult("history", "queryAggregated 10 min", shape.cpu_num_processors, aggregated);
+    std::printf("%-24s series=%-4zu append: %8.1f ns/snapshot %6.1f allocs/op | %5.2f bits/point (raw 128) | "
+                "10 min query: %zu points %8.1f us, %zu buckets %8.1f us\n",
+                "history", history.getNumSeries(), append.nsPerOp, append.allocationsPerOp, bitsPerPoint,
+                points.size(), query.nsPerOp / 1000.0, aggregates.size(), aggregated.nsPerOp / 1000.0);
+}
@@ -0,0 +1,32 @@
+// LatencyHistogramBench.cpp
+// Measures what the self-instrumentation adds to every sample: recording a duration into a LatencyHistogram
+// and reading its p50/p99 back, which SystemInfo does for three histograms per sample.
+#include "BenchUtils.h"
+#include "LatencyHistogram.h"
+#include <cstdio>
+
+void runLatencyHistogramBench(int iterations) {
+    LatencyHistogram histogram;
+    long long value = 12345;
+    BenchResult record = runBenchmark(iterations, [&]() {
+        value = (value * 1103515245LL + 12345LL) & 0x3ffffffLL; // Spread over 0 to 67 ms
+        histogram.record(value);
+    });
+
+    static const double percentiles[] = {50.0, 99.0};
+    long long values[2] = {0, 0};
+    long long sink = 0;
+    BenchResult read = runBenchmark(iterations, [&]() {
+        histogram.getValuesAtPercentiles(percentiles, 2, values);
+        sink += values[1];
+    });
+
+    reportResult("latency_histogram", "record", 0, record);
+    reportResult("latency_histogram", "p50 and p99", 0, read);
+    std::printf("%-24s buckets=%-5zu record: %8.1f ns/op %6.1f allocs/op | p50 and p99: %8.1f ns/op %6.1f allocs/op (p99 %lld ns)\n",
+                "latency_histogram", LatencyHistogram::NUM_BUCKETS, record.nsPerOp, record.allocationsPerOp,
+                read.nsPerOp, read.allocationsPerOp, values[1]);
+    if (sink < 0) {
+        std::printf("Unexpected result\n");
+    }
+}
@@ -0,0 +1,79 @@
+// PipelineBench.cpp
+// Compares a compile-time MetricPipeline<CpuTotal, MemAvailable> against the runtime collectors that report the
+// same values (CpuCollector and MemoryCollector) on the live system, and CpuTotal against a full per-core parse
+// on synthetic stat files at every benchmarked core count.
+#include "BenchUtils.h"
+#include "CpuCollector.h"
+#include "MemoryCollector.h"
+#include "MetricPipeline.h"
+#include "MetricSources.h"
+#include "ProcStatReader.h"
+#include "SystemInfoData.h"
+#include <unistd.h>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void benchLive(int iterations) {
+    MetricPipeline<CpuTotal, MemAvailable> pipeline;
+    size_t succeeded = 0;
+    BenchResult compiled = runBenchmark(iterations, [&]() {
+        succeeded += pipeline.sample();
+    });
+
+    // The runtime collectors, sized for the live core count and the configured windows
+    CpuCollector cpuCollector;
+    cpuCollector.init(static_cast<unsigned long long>(sysconf(_SC_CLK_TCK)), 1);
+    MemoryCollector memoryCollector;
+    SystemInfoData data;
+    cpuCollector.initSnapshot(data);
+    memoryCollector.initSnapshot(data);
+    BenchResult runtime = runBenchmark(iterations, [&]() {
+        cpuCollector.collect(data);
+        memoryCollector.collect(data);
+    });
+
+    int numCores = cpuCollector.getNumCores();
+    reportResult("pipeline", "MetricPipeline<CpuTotal, MemAvailable> live", numCores, compiled);
+    reportResult("pipeline", "CpuCollector + MemoryCollector live", numCores, runtime);
+    std::printf("%-24s cores=%-5d MetricPipeline<CpuTotal, MemAvailable>: %9.1f ns/op %6.1f allocs/op | "
+                "CpuCollector + MemoryCollector: %9.1f ns/op %6.1f allocs/op\n",
+                "pipeline live", numCores, compiled.nsPerOp, compiled.allocationsPerOp, runtime.nsPerOp, runtime.allocationsPerOp);
+    if (succeeded == 0 || pipeline.get<MemAvailable>().getTotalBytes() == 0) {
+        std::printf("Unexpected result\n");
+    }
+}
+
+static void benchCores(int numCores, int iterations) {
+    std::string path = writeSyntheticStatFile(numCores);
+    if (path.empty()) {
+        std::cerr << "Skipping pipeline at " << numCores << " cores: failed to write a stat file\n";
+        return;
+    }
+
+    CpuTotal cpuTotal(path);
+    BenchResult total = runBenchmark(iterations, [&]() {
+        cpuTotal.sample();
+    });
+
+    ProcStatReader reader(path);
+    int numRows = numCores + 1;
+    std::vector<unsigned long long> user(numRows), nice(numRows), sys(numRows), idle(numRows);
+    BenchResult perCore = runBenchmark(iterations, [&]() {
+        reader.read(user.data(), nice.data(), sys.data(), idle.data(), numRows);
+    });
+
+    reportResult("pipeline", "CpuTotal", numCores, total);
+    reportResult("pipeline", "per-core parse", numCores, perCore);
+    std::printf("%-24s cores=%-5d CpuTotal: %9.1f ns/op %6.1f allocs/op | per-core parse: %9.1f ns/op %6.1f allocs/op\n",
+                "pipeline", numCores, total.nsPerOp, total.allocationsPerOp, perCore.nsPerOp, perCore.allocationsPerOp);
+    std::remove(path.c_str());
+}
+
+void runPipelineBench(int iterations) {
+    benchLive(iterations);
+    for (int numCores : getBenchCoreCounts()) {
+        benchCores(numCores, iterations);
+    }
+}
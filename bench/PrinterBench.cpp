@@ -0,0 +1,77 @@
+// PrinterBench.cpp
+// Measures Printer on the per-core report system_diagnostics prints (two lines per core) at every benchmarked
+// core count: printed with the configured printer settings, and filtered out by the verbosity. Standard output
+// goes to /dev/null meanwhile.
+#include "BenchUtils.h"
+#include "Printer.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const int FILTERED_THRESHOLD = 1000; // Above any configured verbosity
+
+static std::string benchCores(Printer& printer, int numCores, int iterations) {
+    std::vector<double> usagePercent(numCores, 42.0);
+    std::vector<double> timeStep(numCores, 0.2);
+
+    // What the printing thread pays. In async mode the writer thread writes meanwhile, and with the drop
+    // overflow policy lines beyond printer.queue_capacity are dropped after being formatted.
+    BenchResult printed = runBenchmark(iterations, [&]() {
+        for (int core = 0; core < numCores; ++core) {
+            printer.print("CPU Core " + std::to_string(core) + " Usage: " + std::to_string(usagePercent[core]) + "%");
+            printer.print("CPU Core " + std::to_string(core) + " Time step: " + std::to_string(timeStep[core]) + "s");
+        }
+    });
+    printer.flush();
+
+    BenchResult filtered = runBenchmark(iterations, [&]() {
+        for (int core = 0; core < numCores; ++core) {
+            PRINT_INFO(FILTERED_THRESHOLD, "CPU Core " + std::to_string(core) + " Usage: " + std::to_string(usagePercent[core]) + "%");
+            PRINT_INFO(FILTERED_THRESHOLD, "CPU Core " + std::to_string(core) + " Time step: " + std::to_string(timeStep[core]) + "s");
+        }
+    });
+
+    reportResult("printer", "print", numCores, printed);
+    reportResult("printer", "PRINT_INFO filtered", numCores, filtered);
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-24s cores=%-5d print: %10.1f ns/report %8.1f allocs/report (%6.1f ns/line) | filtered: %8.1f ns/report %6.1f allocs/report\n",
+                  "printer", numCores, printed.nsPerOp, printed.allocationsPerOp, printed.nsPerOp / (2.0 * numCores),
+                  filtered.nsPerOp, filtered.allocationsPerOp);
+    return line;
+}
+
+void runPrinterBench(int iterations) {
+    Printer& printer = Printer::getInstance();
+    if (printer.isEnabled(FILTERED_THRESHOLD)) {
+        std::printf("Skipping printer: debug.verbosity is at least %d\n", FILTERED_THRESHOLD);
+        return;
+    }
+
+    // Keep the report lines out of the benchmark output
+    std::cout.flush();
+    std::fflush(stdout);
+    int savedStdout = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (savedStdout < 0 || devNull < 0) {
+        std::printf("Skipping printer: could not redirect standard output\n");
+        return;
+    }
+    dup2(devNull, STDOUT_FILENO);
+    close(devNull);
+
+    std::vector<std::string> summaries;
+    for (int numCores : getBenchCoreCounts()) {
+        summaries.push_back(benchCores(printer, numCores, iterations));
+    }
+
+    printer.flush();
+    std::cout.flush();
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+    for (const std::string& summary : summaries) {
+        std::fputs(summary.c_str(), stdout);
+    }
+}
@@ -0,0 +1,77 @@
+// ProcStatBench.cpp
+// Compares the previous ifstream/istringstream /proc/stat parse against ProcStatReader,
+// on the live /proc/stat and on synthetic stat files at every benchmarked core count.
+#include "BenchUtils.h"
+#include "ProcStatReader.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The parse SystemInfo used before ProcStatReader: seek, getline per core, istringstream per line
+static void legacyParse(std::ifstream& statFile, int numCores, std::vector<unsigned long long>& out) {
+    statFile.clear();
+    statFile.seekg(0);
+
+    std::string line;
+    std::getline(statFile, line);
+    std::istringstream totalCpuStream(line);
+    std::string cpuLabel;
+    unsigned long long totalUser, totalUserLow, totalSys, totalIdle;
+    totalCpuStream >> cpuLabel >> totalUser >> totalUserLow >> totalSys >> totalIdle;
+    out[0] = totalUser + totalUserLow + totalSys + totalIdle;
+
+    std::vector<std::string> coreLines(numCores);
+    int coreCount = 0;
+    while (coreCount < numCores && std::getline(statFile, line)) {
+        coreLines[coreCount] = line;
+        ++coreCount;
+    }
+
+    for (int core = 0; core < numCores; ++core) {
+        std::istringstream coreStream(coreLines[core]);
+        coreStream >> cpuLabel >> totalUser >> totalUserLow >> totalSys >> totalIdle;
+        out[core + 1] = totalUser + totalUserLow + totalSys + totalIdle;
+    }
+}
+
+static void compare(const std::string& label, const std::string& path, int iterations) {
+    ProcStatReader reader(path);
+    int numRows = reader.countCpuLines();
+    if (numRows <= 0) {
+        std::cerr << "Skipping " << label << ": failed to read " << path << "\n";
+        return;
+    }
+    int numCores = numRows - 1;
+
+    std::ifstream statFile(path);
+    std::vector<unsigned long long> legacyOut(numRows);
+    BenchResult legacy = runBenchmark(iterations, [&]() {
+        legacyParse(statFile, numCores, legacyOut);
+    });
+
+    std::vector<unsigned long long> user(numRows), nice(numRows), sys(numRows), idle(numRows);
+    BenchResult current = runBenchmark(iterations, [&]() {
+        reader.read(user.data(), nice.data(), sys.data(), idle.data(), numRows);
+    });
+
+    reportResult("proc_stat", "legacy " + label, numCores, legacy);
+    reportResult("proc_stat", "ProcStatReader " + label, numCores, current);
+    std::printf("%-24s cores=%-5d legacy: %10.1f ns/op %8.1f allocs/op | ProcStatReader: %10.1f ns/op %8.1f allocs/op | speedup %.1fx\n",
+                label.c_str(), numCores, legacy.nsPerOp, legacy.allocationsPerOp,
+                current.nsPerOp, current.allocationsPerOp, legacy.nsPerOp / current.nsPerOp);
+}
+
+void runProcStatBench(int iterations) {
+    compare("/proc/stat", "/proc/stat", iterations);
+
+    for (int numCores : getBenchCoreCounts()) {
+        std::string syntheticPath = writeSyntheticStatFile(numCores);
+        if (!syntheticPath.empty()) {
+            compare("synthetic", syntheticPath, iterations);
+            std::remove(syntheticPath.c_str());
+        }
+    }
+}
@@ -0,0 +1,70 @@
+// SharedRingBench.cpp
+// Compares what a consumer pays for the latest sample when it runs its own SystemInfo (a full sample of
+// every collector) against reading it from a SharedSnapshotRing published by another process.
+#include "BenchUtils.h"
+#include "SharedSnapshotRing.h"
+#include "CollectorScheduler.h"
+#include "CpuCollector.h"
+#include "LoadAverageCollector.h"
+#include "MemoryCollector.h"
+#include "ProcessMonitor.h"
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+void runSharedRingBench(int iterations) {
+    unsigned long long jiffiesPerSecond = static_cast<unsigned long long>(sysconf(_SC_CLK_TCK));
+
+    // A consumer sampling locally runs every collector, parsing /proc, for each sample it wants
+    CollectorScheduler scheduler;
+    CpuCollector cpuCollector;
+    MemoryCollector memoryCollector;
+    LoadAverageCollector loadAverageCollector;
+    ProcessMonitor processMonitor;
+    cpuCollector.init(jiffiesPerSecond, 1);
+    processMonitor.init(jiffiesPerSecond, 1);
+    scheduler.addCollector(&cpuCollector, 1);
+    scheduler.addCollector(&memoryCollector, 1);
+    scheduler.addCollector(&loadAverageCollector, 1);
+    scheduler.addCollector(&processMonitor, 1);
+    SystemInfoData data;
+    scheduler.initSnapshot(data, jiffiesPerSecond);
+    unsigned long long deadlineJiffies = 0;
+    BenchResult sample = runBenchmark(iterations, [&]() {
+        scheduler.runDue(++deadlineJiffies, 0, data);
+    });
+
+    std::string name = "/system_diagnostics_bench_" + std::to_string(::getpid());
+    SharedSnapshotRing ring;
+    SnapshotSchema schema;
+    schema.build(data);
+    if (!ring.create(name, schema, 64)) {
+        std::printf("Skipping shared_ring: could not create %s\n", name.c_str());
+        return;
+    }
+    BenchResult publish = runBenchmark(iterations, [&]() {
+        ring.publish(data);
+    });
+
+    SharedSnapshotReader reader;
+    if (!reader.open(name)) {
+        std::printf("Skipping shared_ring: could not open %s\n", name.c_str());
+        return;
+    }
+    std::vector<char> buffer(reader.getSchema().getSize());
+    size_t read = 0;
+    BenchResult readLatest = runBenchmark(iterations, [&]() {
+        read += reader.readLatest(buffer.data(), buffer.size());
+    });
+
+    reportResult("shared_ring", "local sample", data.cpu_num_processors, sample);
+    reportResult("shared_ring", "publish", data.cpu_num_processors, publish);
+    reportResult("shared_ring", "readLatest", data.cpu_num_processors, readLatest);
+    std::printf("%-24s bytes=%-6zu local sample: %10.1f ns/op %6.1f allocs/op | publish: %8.1f ns/op %6.1f allocs/op | readLatest: %8.1f ns/op %6.1f allocs/op\n",
+                "shared_ring", buffer.size(), sample.nsPerOp, sample.allocationsPerOp, publish.nsPerOp, publish.allocationsPerOp,
+                readLatest.nsPerOp, readLatest.allocationsPerOp);
+    if (read == 0) {
+        std::printf("Unexpected result\n");
+    }
+}
@@ -0,0 +1,51 @@
+// SinkBench.cpp
+// Measures what a SinkWriter costs the sampler per snapshot (submit) and how long its thread takes to
+// format and write each snapshot, for every output format.
+#include "BenchUtils.h"
+#include "SinkWriter.h"
+#include "SystemInfo.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+void runSinkBench(int iterations) {
+    SystemInfo& systemInfo = SystemInfo::getInstance();
+    SystemInfoData data;
+    systemInfo.collectSystemInfo(data);
+
+    char directory[] = "/tmp/system_diagnostics_sinks_XXXXXX";
+    if (mkdtemp(directory) == nullptr) {
+        std::printf("Skipping sink: could not create a directory\n");
+        return;
+    }
+
+    const char* formats[] = {"csv", "jsonl", "binary"};
+    for (const char* format : formats) {
+        SinkConfig config = { format, directory, "bench", 0, 0, 1024 * 1024, 1.0, iterations + 1 };
+        SinkWriter sink(config);
+        if (!sink.start(systemInfo.getSnapshotSchema())) {
+            continue;
+        }
+
+        BenchResult submit = runBenchmark(iterations, [&]() {
+            sink.submit(data);
+        });
+        auto start = std::chrono::steady_clock::now();
+        sink.flush();
+        auto end = std::chrono::steady_clock::now();
+        sink.stop();
+
+        reportResult("sink", std::string("submit ") + format, data.cpu_num_processors, submit);
+        double drainNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        std::printf("%-24s submit: %8.1f ns/op %6.1f allocs/op | writer behind by %8.1f ms after the burst | written %llu, dropped %llu\n",
+                    (std::string("sink ") + format).c_str(), submit.nsPerOp, submit.allocationsPerOp, drainNs / 1e6,
+                    sink.getWrittenCount(), sink.getDroppedCount());
+    }
+
+    std::string command = std::string("rm -rf ") + directory;
+    if (std::system(command.c_str()) != 0) {
+        std::printf("Failed to remove %s\n", directory);
+    }
+}
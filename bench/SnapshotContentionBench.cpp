@@ -0,0 +1,180 @@
+// SnapshotContentionBench.cpp
+// Measures reader latency of snapshot publication with N reader threads while a sampler publishes
+// as fast as it can, comparing the previous mutex held across the whole sample against the seqlock.
+#include "BenchUtils.h"
+#include "ConfigManager.h"
+#include "ProcStatReader.h"
+#include "SeqLock.h"
+#include "SystemInfo.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct LatencySummary {
+    double p50Ns;
+    double p99Ns;
+    double maxNs;
+};
+
+static LatencySummary measureReaders(int numReaders, int readsPerReader, const std::function<void(SystemInfoData&)>& read) {
+    std::vector<std::vector<double> > latencies(numReaders);
+    std::vector<std::thread> readers;
+
+    for (int reader = 0; reader < numReaders; ++reader) {
+        latencies[reader].reserve(readsPerReader);
+        readers.emplace_back([&, reader]() {
+            SystemInfoData data;
+            read(data); // Size the reader's buffers before measuring
+            for (int i = 0; i < readsPerReader; ++i) {
+                auto start = std::chrono::steady_clock::now();
+                read(data);
+                auto end = std::chrono::steady_clock::now();
+                latencies[reader].push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+            }
+        });
+    }
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    std::vector<double> all;
+    for (const std::vector<double>& readerLatencies : latencies) {
+        all.insert(all.end(), readerLatencies.begin(), readerLatencies.end());
+    }
+    std::sort(all.begin(), all.end());
+    if (all.empty()) {
+        return { 0, 0, 0 };
+    }
+    return { all[all.size() / 2], all[(all.size() * 99) / 100], all.back() };
+}
+
+// Publishes synthetic snapshots from a sampler thread that really parses /proc/stat on every sample
+class SyntheticSampler {
+public:
+    SyntheticSampler(int numCores, bool useSeqLock) : useSeqLock_(useSeqLock), running_(false), samples_(0) {
+        counters_.assign(4 * (numCores + 1), 0);
+        building_.cpu_num_processors = numCores;
+        building_.cpu_usage_percent_per_core.assign(numCores, 0.0);
+        building_.cpu_real_time_step_per_core.assign(numCores, 0.0);
+        copySystemInfoData(building_, published_);
+    }
+
+    void start() {
+        running_ = true;
+        thread_ = std::thread([this]() {
+            while (running_) {
+                sample();
+            }
+        });
+    }
+
+    unsigned long long stop() {
+        running_ = false;
+        thread_.join();
+        return samples_;
+    }
+
+    void read(SystemInfoData& data) {
+        if (useSeqLock_) {
+            unsigned long long sequence;
+            do {
+                sequence = lock_.readBegin();
+                copySystemInfoData(published_, data);
+            } while (lock_.readRetry(sequence));
+        } else {
+            std::lock_guard<std::mutex> lock(mutex_);
+            copySystemInfoData(published_, data);
+        }
+    }
+
+private:
+    void sample() {
+        size_t numRows = building_.cpu_usage_percent_per_core.size() + 1;
+        if (useSeqLock_) {
+            // Parse and compute without holding anything readers need, then publish
+            parse(numRows);
+            lock_.writeBegin();
+            copySystemInfoData(building_, published_);
+            lock_.writeEnd();
+        } else {
+            // Previous behaviour: the lock is held across the file I/O and the parse
+            std::lock_guard<std::mutex> lock(mutex_);
+            parse(numRows);
+            copySystemInfoData(building_, published_);
+        }
+        ++samples_;
+    }
+
+    void parse(size_t numRows) {
+        unsigned long long* columns = counters_.data();
+        reader_.read(columns, columns + numRows, columns + 2 * numRows, columns + 3 * numRows, static_cast<int>(numRows));
+        building_.cpu_usage_percent = static_cast<double>(columns[0] % 100);
+        building_.time_stamp_ns = static_cast<long long>(samples_);
+    }
+
+    bool useSeqLock_;
+    std::atomic<bool> running_;
+    unsigned long long samples_;
+    std::thread thread_;
+    ProcStatReader reader_;
+    std::vector<unsigned long long> counters_;
+    SystemInfoData building_;
+    SystemInfoData published_;
+    std::mutex mutex_;
+    SeqLock lock_;
+};
+
+static void printSummary(const char* label, int numCores, int numReaders, const LatencySummary& summary, unsigned long long samples) {
+    // Latencies of single reads, allocations are not counted
+    std::string variant = std::string(label) + ", readers=" + std::to_string(numReaders);
+    BenchResult p50 = { summary.p50Ns, std::numeric_limits<double>::quiet_NaN() };
+    BenchResult p99 = { summary.p99Ns, std::numeric_limits<double>::quiet_NaN() };
+    reportResult("snapshot_contention", variant + " p50", numCores, p50);
+    reportResult("snapshot_contention", variant + " p99", numCores, p99);
+    std::printf("%-28s readers=%-3d p50: %8.0f ns  p99: %8.0f ns  max: %10.0f ns  samples published: %llu\n",
+                label, numReaders, summary.p50Ns, summary.p99Ns, summary.maxNs, samples);
+}
+
+void runSnapshotContentionBench(int iterations) {
+    const int numCores = 128;
+    const int readerCounts[] = {1, 2, 4, 8};
+
+    for (int numReaders : readerCounts) {
+        int readsPerReader = iterations / numReaders;
+        for (int useSeqLock = 0; useSeqLock <= 1; ++useSeqLock) {
+            SyntheticSampler sampler(numCores, useSeqLock != 0);
+            sampler.start();
+            LatencySummary summary = measureReaders(numReaders, readsPerReader, [&](SystemInfoData& data) {
+                sampler.read(data);
+            });
+            unsigned long long samples = sampler.stop();
+            printSummary(useSeqLock ? "seqlock, sampler busy" : "mutex, sampler busy", numCores, numReaders, summary, samples);
+        }
+    }
+
+    // End to end: the real collector sampling at its fastest configured rate (one jiffy)
+    ConfigManager::getInstance().setUpdatePeriodJiffies(1);
+    SystemInfo& systemInfo = SystemInfo::getInstance();
+    int liveCores = systemInfo.collectSystemInfo().cpu_num_processors;
+    for (int numReaders : readerCounts) {
+        int readsPerReader = iterations / numReaders;
+        LatencySummary idle = measureReaders(numReaders, readsPerReader, [&](SystemInfoData& data) {
+            systemInfo.collectSystemInfo(data);
+        });
+        printSummary("SystemInfo, sampler stopped", liveCores, numReaders, idle, 0);
+
+        systemInfo.startPeriodicUpdates();
+        LatencySummary busy = measureReaders(numReaders, readsPerReader, [&](SystemInfoData& data) {
+            systemInfo.collectSystemInfo(data);
+        });
+        systemInfo.stopPeriodicUpdates();
+        printSummary("SystemInfo, sampler running", liveCores, numReaders, busy, 0);
+    }
+}
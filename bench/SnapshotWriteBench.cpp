@@ -0,0 +1,33 @@
+// SnapshotWriteBench.cpp
+// Compares packaging a snapshot for MIDAS through packageSystemInfoForMIDAS() against serializing it
+// with writeSnapshot() into a preallocated buffer.
+#include "BenchUtils.h"
+#include "SystemInfo.h"
+#include <cstdio>
+#include <vector>
+
+void runSnapshotWriteBench(int iterations) {
+    SystemInfo& systemInfo = SystemInfo::getInstance();
+
+    double legacySink = 0;
+    BenchResult legacy = runBenchmark(iterations, [&]() {
+        std::vector<double> packaged = systemInfo.packageSystemInfoForMIDAS();
+        legacySink += packaged[0];
+    });
+
+    std::vector<char> buffer(systemInfo.getSnapshotSchema().getSize());
+    size_t written = 0;
+    BenchResult current = runBenchmark(iterations, [&]() {
+        written += systemInfo.writeSnapshot(buffer.data(), buffer.size());
+    });
+
+    int numCores = systemInfo.collectSystemInfo().cpu_num_processors;
+    reportResult("snapshot_write", "packageSystemInfoForMIDAS", numCores, legacy);
+    reportResult("snapshot_write", "writeSnapshot", numCores, current);
+    std::printf("%-24s fields=%-5zu packageSystemInfoForMIDAS: %8.1f ns/op %6.1f allocs/op | writeSnapshot: %8.1f ns/op %6.1f allocs/op (%zu bytes)\n",
+                "snapshot_write", systemInfo.getSnapshotSchema().getFields().size(), legacy.nsPerOp, legacy.allocationsPerOp,
+                current.nsPerOp, current.allocationsPerOp, buffer.size());
+    if (legacySink < 0 || written == 0) {
+        std::printf("Unexpected result\n");
+    }
+}
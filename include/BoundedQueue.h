@@ -0,0 +1,110 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Bounded lock-free multi-producer multi-consumer queue (Dmitry Vyukov's design). Every cell carries
+// a sequence number that tells producers and consumers whether it is free or full for their lap of the
+// ring, so a push or pop is one compare-and-swap on the shared position and never blocks.
+// Storage is allocated once in reset(); the capacity is rounded up to a power of two.
+template<typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity = 0) : mask_(0), enqueuePosition_(0), dequeuePosition_(0) {
+        reset(capacity);
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Reallocates the storage and drops all elements. Not thread safe.
+    void reset(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        cells_.reset(new Cell[rounded]);
+        for (size_t i = 0; i < rounded; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mask_ = rounded - 1;
+        enqueuePosition_.store(0, std::memory_order_relaxed);
+        dequeuePosition_.store(0, std::memory_order_relaxed);
+    }
+
+    // Moves value into the queue. Returns false (leaving value untouched) if the queue is full.
+    bool tryPush(T& value) {
+        size_t position = enqueuePosition_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[position & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (difference == 0) {
+                if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false; // The cell still holds an element from the previous lap
+            } else {
+                position = enqueuePosition_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Moves the oldest element into value. Returns false if the queue is empty.
+    bool tryPop(T& value) {
+        size_t position = dequeuePosition_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[position & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+            if (difference == 0) {
+                if (dequeuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false; // Nothing was pushed into this cell yet
+            } else {
+                position = dequeuePosition_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Approximate number of elements, exact only when no push or pop is in flight
+    size_t size() const {
+        size_t enqueued = enqueuePosition_.load(std::memory_order_relaxed);
+        size_t dequeued = dequeuePosition_.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    size_t capacity() const {
+        return mask_ + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static const size_t CACHE_LINE_BYTES = 64;
+
+    // Producers and consumers update different cache lines. Padded rather than alignas(), which C++11 does not
+    // honour for queues allocated with new (e.g. inside a SinkWriter).
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+    char enqueuePadding_[CACHE_LINE_BYTES];
+    std::atomic<size_t> enqueuePosition_;
+    char dequeuePadding_[CACHE_LINE_BYTES - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> dequeuePosition_;
+    char endPadding_[CACHE_LINE_BYTES - sizeof(std::atomic<size_t>)];
+};
+
+#endif // BOUNDED_QUEUE_H
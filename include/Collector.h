@@ -0,0 +1,22 @@
+#ifndef COLLECTOR_H
+#define COLLECTOR_H
+
+#include "SystemInfoData.h"
+
+// A source of system information sampled by the CollectorScheduler at its own period.
+// Collectors own whatever state they need between samples and write only their own fields of the snapshot.
+class Collector {
+public:
+    virtual ~Collector() {}
+
+    // Name of the collector, also its key under system_info.collectors in the config
+    virtual const char* getName() const = 0;
+
+    // Sizes and initializes the collector's fields of a snapshot, called before sampling starts
+    virtual void initSnapshot(SystemInfoData& data) = 0;
+
+    // Takes one sample and writes the collector's fields of the snapshot. Returns false if the sample failed.
+    virtual bool collect(SystemInfoData& data) = 0;
+};
+
+#endif // COLLECTOR_H
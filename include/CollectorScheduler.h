@@ -0,0 +1,48 @@
+#ifndef COLLECTOR_SCHEDULER_H
+#define COLLECTOR_SCHEDULER_H
+
+#include <cstddef>
+#include <vector>
+#include "Collector.h"
+
+// Runs several collectors at different periods from a single tick. The tick period is the greatest
+// common divisor of the collector periods, and a collector runs on the ticks that fall on its own period.
+class CollectorScheduler {
+public:
+    CollectorScheduler();
+
+    // The scheduler does not take ownership of the collector
+    void addCollector(Collector* collector, unsigned long long periodJiffies);
+
+    // Changes the period of a registered collector, which runs next one new period after its last run
+    void setCollectorPeriod(Collector* collector, unsigned long long periodJiffies);
+
+    unsigned long long getBasePeriodJiffies() const;
+
+    // Sizes the fields of every collector and the freshness entries of a snapshot
+    void initSnapshot(SystemInfoData& data, unsigned long long jiffiesPerSecond);
+
+    // Writes the period of every collector into the freshness entries of a snapshot sized by initSnapshot()
+    void writePeriods(SystemInfoData& data, unsigned long long jiffiesPerSecond) const;
+
+    // Runs the collectors that are due at the given (deadline) jiffy and refreshes their freshness entries.
+    // Returns the number of collectors that ran.
+    size_t runDue(unsigned long long deadlineJiffies, long long timeStampNs, SystemInfoData& data);
+
+    // Runs a registered collector outside its schedule, e.g. on an event, and refreshes its freshness entry. Its next
+    // scheduled run stays where it was. Returns false if the sample failed or the collector is not registered.
+    bool runNow(Collector* collector, long long timeStampNs, SystemInfoData& data);
+
+private:
+    struct Entry {
+        Collector* collector;
+        unsigned long long periodJiffies;
+        unsigned long long lastDeadlineJiffies;
+        bool hasRun;
+    };
+
+    std::vector<Entry> entries_;
+    unsigned long long basePeriodJiffies_;
+};
+
+#endif // COLLECTOR_SCHEDULER_H
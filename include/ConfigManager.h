@@ -2,8 +2,15 @@
 #ifndef CONFIG_MANAGER_H
 #define CONFIG_MANAGER_H
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
+#include "MetricArchive.h"
+#include "SinkWriter.h"
+#include "PressureCollector.h"
 
 using json = nlohmann::json;
 
@@ -14,35 +21,159 @@ public:
     int getVerbosity() const;
     int getUpdatePeriodJiffies() const;
     int getAveragePeriodJiffies() const;
+    const std::vector<int>& getAverageWindowsJiffies() const; // Extra CPU averaging windows, empty if none are configured
+    const std::string& getOverrunPolicy() const;
+    int getCollectorPeriodJiffies(const std::string& collectorName) const; // system_info.collectors.<name>.period_jiffies, defaults to the update period
+    const std::vector<int>& getWatchedProcessPids() const;
+    const std::vector<std::string>& getWatchedProcessNames() const; // fnmatch() patterns matched against /proc/<pid>/comm
+    int getMaxWatchedProcesses() const;
+    int getProcessRescanPeriodJiffies() const;
+    const std::vector<std::string>& getNetworkInterfaces() const; // fnmatch() patterns of the reported interfaces, empty for all of them
+    const std::vector<std::string>& getExcludedNetworkInterfaces() const; // fnmatch() patterns of interfaces never reported
+    int getMaxNetworkInterfaces() const;
+    const std::vector<std::string>& getDiskDevices() const; // fnmatch() patterns of the reported block devices, empty for all of them
+    const std::vector<std::string>& getExcludedDiskDevices() const; // fnmatch() patterns of devices never reported
+    bool getDiskPartitionsIncluded() const;
+    int getMaxDiskDevices() const;
+    const std::vector<PressureTriggerConfig>& getPressureTriggers() const; // Empty if no PSI triggers are configured
+    bool getSharedMemoryEnabled() const;
+    const std::string& getSharedMemoryName() const;
+    int getSharedMemorySlots() const;
+    bool getHistoryEnabled() const;
+    int getHistoryMemoryBudgetBytes() const;
+    int getHistoryBlockBytes() const;
+    bool getArchiveEnabled() const;
+    const std::string& getArchivePath() const;
+    const std::vector<ArchiveTierConfig>& getArchiveTiers() const;
+    const std::vector<SinkConfig>& getSinks() const; // Empty if no output sinks are configured
+    const std::string& getProcfsRoot() const;
+    std::string getProcPath(const std::string& name) const; // <procfs_root>/<name>, e.g. "/proc/stat"
+    const std::string& getCaptureMode() const; // "off", "record" or "replay"
+    const std::string& getCapturePath() const;
+    double getReplaySpeed() const; // 1 replays at the recorded pace, 0 as fast as possible
+    bool getHotReloadEnabled() const;
+    const std::string& getConfigFile() const; // File the configuration was read from, empty if only defaults are used
     void setVerbosity(int verbosity);
     void setUpdatePeriodJiffies(int updatePeriod);
     void setAveragePeriodJiffies(int averagePeriod);
+    void setProcfsRoot(const std::string& procfsRoot);
+    void setCapture(const std::string& mode, const std::string& path); // Takes effect if set before the first procfs read
+    void setReplaySpeed(double replaySpeed);
     const json& getConfig() const;
 
+    // Replaces the configuration with newly read contents of the config file. Sections that are only read at
+    // startup (RESTART_ONLY_SECTIONS) keep their current values; the ones the new file changes are returned in
+    // ignoredSections. Returns false, keeping the whole current configuration, if a period or an averaging
+    // window is not positive. Threads reading meanwhile get either the old or the new values of each getter, and
+    // the references the getters returned stay valid.
+    bool applyConfig(const json& fileContents, std::vector<std::string>& ignoredSections);
+
 private:
     bool debug = false; // Internal debug flag for config loading
 
     static ConfigManager* instance;
-    json config;
-    int verbosity;
-    int updatePeriodJiffies;
-    int averagePeriodJiffies;
+
+    // Everything read from the configuration, replaced as a whole by applyConfig() and the setters
+    struct Values {
+        json config;
+        int verbosity;
+        int updatePeriodJiffies;
+        int averagePeriodJiffies;
+        std::vector<int> averageWindowsJiffies;
+        std::vector<int> watchedProcessPids;
+        std::vector<std::string> watchedProcessNames;
+        int maxWatchedProcesses;
+        int processRescanPeriodJiffies;
+        std::vector<std::string> networkInterfaces;
+        std::vector<std::string> excludedNetworkInterfaces;
+        int maxNetworkInterfaces;
+        std::vector<std::string> diskDevices;
+        std::vector<std::string> excludedDiskDevices;
+        bool diskPartitionsIncluded;
+        int maxDiskDevices;
+        std::vector<PressureTriggerConfig> pressureTriggers;
+        std::string overrunPolicy;
+        bool sharedMemoryEnabled;
+        std::string sharedMemoryName;
+        int sharedMemorySlots;
+        bool historyEnabled;
+        int historyMemoryBudgetBytes;
+        int historyBlockBytes;
+        bool archiveEnabled;
+        std::string archivePath;
+        std::vector<ArchiveTierConfig> archiveTiers;
+        std::vector<SinkConfig> sinks;
+        std::string procfsRoot;
+        std::string captureMode;
+        std::string capturePath;
+        double replaySpeed;
+        bool hotReloadEnabled;
+    };
+
+    // Current values. Every version is kept until exit, as another thread may still hold a reference returned by a
+    // getter of an older one; reloads and setter calls are rare and small.
+    std::atomic<const Values*> values_;
+    std::vector<std::unique_ptr<Values> > valuesVersions_;
+    std::mutex updateMutex_; // Serializes applyConfig() and the setters
+    json fileConfig; // Contents of the config file as last read, without the setters' changes, under updateMutex_
+    std::string configFilePath;
 
     // Default values
     const int DEFAULT_VERBOSITY = 0;
     const int DEFAULT_UPDATE_PERIOD_JIFFIES = 100;
     const int DEFAULT_AVERAGE_PERIOD_JIFFIES = 1000;
+    const std::string DEFAULT_OVERRUN_POLICY = "skip";
+    const int DEFAULT_MAX_WATCHED_PROCESSES = 16;
+    const int DEFAULT_PROCESS_RESCAN_PERIOD_JIFFIES = 1000;
+    const int DEFAULT_MAX_NETWORK_INTERFACES = 16;
+    const std::vector<std::string> DEFAULT_EXCLUDED_DISK_DEVICES = { "loop*", "ram*", "zram*" };
+    const bool DEFAULT_DISK_PARTITIONS_INCLUDED = false;
+    const int DEFAULT_MAX_DISK_DEVICES = 16;
+    const std::string DEFAULT_PRESSURE_TRIGGER_TYPE = "some";
+    const int DEFAULT_PRESSURE_TRIGGER_WINDOW_US = 2000000;
+    const bool DEFAULT_SHARED_MEMORY_ENABLED = false;
+    const std::string DEFAULT_SHARED_MEMORY_NAME = "/system_diagnostics";
+    const int DEFAULT_SHARED_MEMORY_SLOTS = 64;
+    const bool DEFAULT_HISTORY_ENABLED = false;
+    const int DEFAULT_HISTORY_MEMORY_BUDGET_BYTES = 4 * 1024 * 1024;
+    const int DEFAULT_HISTORY_BLOCK_BYTES = 1024;
+    const bool DEFAULT_ARCHIVE_ENABLED = false;
+    const std::string DEFAULT_ARCHIVE_PATH = "/var/tmp/system_diagnostics.archive";
+    const std::string DEFAULT_SINK_DIRECTORY = "/var/tmp";
+    const std::string DEFAULT_SINK_PREFIX = "system_diagnostics";
+    const long long DEFAULT_SINK_ROTATE_BYTES = 64LL * 1024 * 1024;
+    const int DEFAULT_SINK_ROTATE_SECONDS = 3600;
+    const int DEFAULT_SINK_BATCH_BYTES = 64 * 1024;
+    const double DEFAULT_SINK_FLUSH_SECONDS = 1.0;
+    const int DEFAULT_SINK_QUEUE_CAPACITY = 256;
+    const std::string DEFAULT_PROCFS_ROOT = "/proc";
+    const std::string DEFAULT_CAPTURE_MODE = "off";
+    const std::string DEFAULT_CAPTURE_PATH = "/var/tmp/system_diagnostics.capture";
+    const double DEFAULT_REPLAY_SPEED = 1.0;
+    const bool DEFAULT_HOT_RELOAD_ENABLED = false;
+    const std::vector<ArchiveTierConfig> DEFAULT_ARCHIVE_TIERS = { { 1, 3600 }, { 60, 1440 }, { 3600, 720 } }; // 1 s for an hour, 1 min for a day, 1 h for a month
 
     //Methods
     ConfigManager(const std::string& configFile);
     void initializeVariables(const std::string& configFile);
-    void readConfig(const nlohmann::json& config);
+    void readConfig(Values& values); // Fills values from values.config
+    const Values& current() const;
+    void publish(std::unique_ptr<Values> values); // Under updateMutex_
     std::string getConfigFilePath(const std::string& configFile); // Private method to get the configuration file path
 
     template<typename T>
     void readConfigSection(const nlohmann::json& config, const std::string& configSectionName, T& target, const T& defaultValue);
     template<typename T>
-    T getConfigValue(const nlohmann::json& config, const std::string& configPath, const T& defaultValue);
+    void readConfigList(const nlohmann::json& config, const std::string& configSectionName, std::vector<T>& target) const; // Empty if missing
+    template<typename T>
+    T getConfigValue(const nlohmann::json& config, const std::string& configPath, const T& defaultValue) const;
+    void readSinks(const nlohmann::json& config, const std::string& configPath, std::vector<SinkConfig>& target);
+    void readPressureTriggers(const nlohmann::json& config, const std::string& configPath, std::vector<PressureTriggerConfig>& target);
+    bool checkPeriods(const nlohmann::json& config) const; // False, with a warning, if a period or window is not positive
+    void readArchiveTiers(const nlohmann::json& config, const std::string& configPath, std::vector<ArchiveTierConfig>& target);
+    static const nlohmann::json& getConfigNode(const nlohmann::json& config, const std::string& configPath); // Throws if the path is missing
+    static const nlohmann::json* findConfigNode(const nlohmann::json& config, const std::string& configPath); // Null if the path is missing
+    static void setConfigNode(nlohmann::json& config, const std::string& configPath, const nlohmann::json* value); // Removes it if value is null
     bool fileExists(const std::string& path);
 };
 
@@ -0,0 +1,49 @@
+#ifndef CONFIG_WATCHER_H
+#define CONFIG_WATCHER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <nlohmann/json.hpp>
+
+// Watches the config file with inotify on a thread of its own and parses it whenever it is written or replaced
+// (editors usually save through a rename, so the directory is watched rather than the file). A file that parsed
+// is handed over with takeConfig(), which never blocks, so the sampler picks it up between two samples and all
+// the parsing happens here. A file that does not parse is reported and the current configuration stays.
+class ConfigWatcher {
+public:
+    ConfigWatcher();
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    // Returns false if the file cannot be watched
+    bool start(const std::string& path);
+    void stop();
+
+    // Whether a newly parsed config is waiting, cheap enough to check on every sample
+    bool hasConfig() const;
+
+    // Moves the waiting config into config. False if there is none, or if the watcher is storing a newer one
+    // right now, in which case it is there for the next call.
+    bool takeConfig(nlohmann::json& config);
+
+private:
+    void watchLoop();
+    bool waitForChange(); // Blocks until the file changed and stopped changing, false once stopped
+
+    std::string path_;
+    std::string directory_;
+    std::string fileName_;
+    int inotifyFd_;
+    int stopFd_; // eventfd that wakes the thread up to stop
+    std::thread thread_;
+
+    std::mutex configMutex_; // Held by the watcher only to store a parsed config, by the sampler only with try_lock
+    nlohmann::json config_;
+    std::atomic<bool> hasConfig_;
+};
+
+#endif // CONFIG_WATCHER_H
@@ -0,0 +1,52 @@
+#ifndef COUNTER_MATRIX_H
+#define COUNTER_MATRIX_H
+
+#include <cstddef>
+#include <vector>
+#include "RingBuffer.h"
+
+// History of monotonically increasing counters stored as a struct of arrays.
+// Each column (e.g. user, nice, sys, idle) holds one contiguous block per time slot, and inside a
+// block the rows (e.g. cores) are contiguous, so comparing two slots for every row is a linear pass.
+// Time slots form a ring of `capacity` committed slots plus one pending slot that the producer
+// fills in place before committing it, so a failed sample never clobbers committed history.
+class CounterMatrix {
+public:
+    CounterMatrix();
+    CounterMatrix(size_t numColumns, size_t numRows, size_t capacity);
+
+    // Reallocates the storage and drops all samples
+    void reset(size_t numColumns, size_t numRows, size_t capacity);
+
+    // Reallocates the storage for a new capacity, keeping the newest samples that fit
+    void resize(size_t capacity);
+
+    // Writable rows of a column in the pending slot
+    unsigned long long* getPendingColumn(size_t column);
+
+    // Commits the pending slot as the newest sample, evicting the oldest one once full
+    void commit(unsigned long long jiffies);
+
+    // Rows of a column in a committed slot, index 0 being the oldest sample
+    const unsigned long long* getColumn(size_t column, size_t index) const;
+    unsigned long long getJiffies(size_t index) const;
+
+    // Latest sample at least windowJiffies before the newest one, or the oldest if the history is shorter
+    size_t findWindowStart(unsigned long long windowJiffies) const;
+
+    size_t size() const;
+    size_t capacity() const;
+    size_t getNumRows() const;
+    size_t getNumColumns() const;
+
+private:
+    size_t getSlot(size_t index) const;
+
+    size_t numColumns_;
+    size_t numRows_;
+    size_t capacity_;
+    RingBuffer<unsigned long long> jiffies_; // One entry per storage slot (capacity_ + 1)
+    std::vector<unsigned long long> counters_; // [column][slot][row]
+};
+
+#endif // COUNTER_MATRIX_H
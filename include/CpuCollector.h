@@ -0,0 +1,41 @@
+#ifndef CPU_COLLECTOR_H
+#define CPU_COLLECTOR_H
+
+#include <string>
+#include <vector>
+#include "Collector.h"
+#include "CpuUsageCalculator.h"
+#include "ProcStatReader.h"
+
+// Samples <procfs_root>/stat and reports the total and per-core CPU usage averaged over average_period_jiffies
+// and every window in average_windows_jiffies
+class CpuCollector : public Collector {
+public:
+    CpuCollector();
+
+    // Detects the cores and allocates the counter history for the given sampling period
+    void init(unsigned long long jiffiesPerSecond, unsigned long long periodJiffies);
+    // Applies a new sampling period and the configured windows, keeping the history that still fits. Returns
+    // false if the windows were kept because their number changed, which needs a restart.
+    bool reconfigure(unsigned long long periodJiffies);
+    int getNumCores() const;
+
+    const char* getName() const override;
+    void initSnapshot(SystemInfoData& data) override;
+    bool collect(SystemInfoData& data) override;
+
+private:
+    void initNumCores(); // Private method to initialize the number of CPU cores
+    void checkWindow(const std::string& name, unsigned long long windowJiffies) const; // Warns if a window does not fit the sampling period
+    bool addDataPointToBuffer(); // Private method to add a data point to the buffer without computing usage results
+    unsigned long long getCurrentJiffy() const;
+
+    ProcStatReader statReader_; // Kept-open reader for /proc/stat
+    CpuUsageCalculator cpuUsageCalculator_; // Counter history of the total CPU and every core
+    std::vector<double> coreUsagePercent_; // CPU usage for each row of cpuUsageCalculator_ (total usage stored at row 0), one block of rows per window
+    int numCores_; // Number of CPU cores
+    unsigned long long jiffiesPerSecond_; // System jiffies per second
+    unsigned long long periodJiffies_; // Number of jiffies per CPU sample
+};
+
+#endif // CPU_COLLECTOR_H
@@ -1,52 +1,87 @@
 #ifndef CPU_USAGE_CALCULATOR_H
 #define CPU_USAGE_CALCULATOR_H
 
-#include <deque>
-#include <mutex>
+#include <string>
 #include <vector>
 #include <limits> // For std::numeric_limits
-#include <map>
-
-struct DataPoint {
-    unsigned long long totalUser;
-    unsigned long long totalUserLow;
-    unsigned long long totalSys;
-    unsigned long long totalIdle;
-    unsigned long long jiffies;
-};
+#include "CounterMatrix.h"
 
 struct CpuUsageResult {
     double usagePercent;
     unsigned long long jiffiesPassed;
+    unsigned long long windowJiffies; // Averaging window the result was asked for, jiffiesPassed is shorter until the history fills
 };
 
+// Keeps the /proc/stat counters of the total CPU and every core in a single CounterMatrix.
+// Row 0 holds the total and row core + 1 holds each core, so all usages are computed in one pass.
+// Every averaging window is answered from the same history: window 0 is average_period_jiffies, followed by
+// the average_windows_jiffies from the config. Each window only looks up its start slot and diffs it against the
+// newest one, so a window costs O(cores) per sample.
 class CpuUsageCalculator {
 public:
-    static CpuUsageCalculator& getInstanceForCore(int core);
-    static CpuUsageCalculator& getInstanceForTotal();
     static const int TOTAL_CPU_USAGE_INDEX;
 
-    void addDataPointForCore(int core, unsigned long long totalUser, unsigned long long totalUserLow,
-                              unsigned long long totalSys, unsigned long long totalIdle, unsigned long long jiffies);
+    enum Column {
+        USER_COLUMN = 0,
+        USER_LOW_COLUMN,
+        SYS_COLUMN,
+        IDLE_COLUMN,
+        NUM_COLUMNS
+    };
+
+    CpuUsageCalculator();
+
+    // Allocates the history for numCores cores plus the total, sized to cover the longest averaging window
+    // when sampled every updatePeriodJiffies
+    void reset(int numCores, unsigned long long updatePeriodJiffies);
+
+    // Applies a new sampling period and the configured windows, keeping the newest data points that still fit.
+    // The windows are only applied if there are as many as before, since their number is part of the snapshot
+    // layout. Returns whether they were applied.
+    bool reconfigure(unsigned long long updatePeriodJiffies);
+
+    // Writable rows of a column for the next data point, so a parser can fill them in place
+    unsigned long long* getPendingColumn(Column column);
+    // Commits the pending data point. Rows from rowsWritten on were not sampled and repeat the previous
+    // data point, so they report no usage instead of garbage.
+    void commitDataPoint(unsigned long long jiffies, size_t rowsWritten);
+
     CpuUsageResult calculateCpuUsagePercentForCore(int core, size_t index1, size_t index2) const;
-    CpuUsageResult calculateCpuUsagePercentForCore(int core) const;
-    void addDataPointForTotal(unsigned long long totalUser, unsigned long long totalUserLow,
-                              unsigned long long totalSys, unsigned long long totalIdle, unsigned long long jiffies);
-    CpuUsageResult calculateCpuUsagePercentForTotal(size_t index1, size_t index2) const;
+    CpuUsageResult calculateCpuUsagePercentForCore(int core) const; // Over window 0
+    CpuUsageResult calculateCpuUsagePercentForCoreWindow(int core, size_t window) const;
     CpuUsageResult calculateCpuUsagePercentForTotal() const;
 
+    // Usage of every row over a window (window 0 if not given), written to usagePercent[row].
+    // Returns the jiffies passed between the two data points, 0 if there are fewer than two.
+    unsigned long long calculateCpuUsagePercent(double* usagePercent) const;
+    unsigned long long calculateCpuUsagePercentForWindow(size_t window, double* usagePercent) const;
+    unsigned long long calculateCpuUsagePercent(size_t index1, size_t index2, double* usagePercent) const;
+
+    size_t getNumWindows() const;
+    unsigned long long getWindowJiffies(size_t window) const;
+    // Latest data point at least the window's length before the newest one, or the oldest if the history is shorter
+    size_t getWindowStartIndex(size_t window) const;
+
+    size_t getNumRows() const;
+    static size_t getRowForCore(int core);
+
+    // Usage from how much the busy (user + nice + system) and idle jiffies grew, -1 if neither did. Branch-free,
+    // so loops over every row still vectorize.
+    static double getUsagePercent(double busyJiffies, double idleJiffies) {
+        double totalJiffies = busyJiffies + idleJiffies;
+        double divisor = totalJiffies > 0 ? totalJiffies : 1.0;
+        return totalJiffies > 0 ? (busyJiffies / divisor) * 100.0 : -1.0;
+    }
+
+    // average_period_jiffies followed by the distinct average_windows_jiffies, shared by every windowed rate
+    static std::vector<unsigned long long> getConfiguredWindowsJiffies();
+
 private:
-    CpuUsageCalculator();
-    ~CpuUsageCalculator();
+    std::string dumpRow(size_t row) const; // Every data point of a row, for diagnostics
 
-    static std::map<int, CpuUsageCalculator*> coreInstances_;
-    static std::mutex mutex_;
     size_t bufferSize_;
-    std::vector<DataPoint> buffer_;
-    size_t currentIndex_;
-    size_t largestOccupiedIndex_;
-
-    size_t getWrappedIndex(size_t index) const;
+    std::vector<unsigned long long> windowsJiffies_; // Averaging windows, window 0 is average_period_jiffies
+    CounterMatrix counters_;
 };
 
 #endif // CPU_USAGE_CALCULATOR_H
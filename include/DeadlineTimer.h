@@ -0,0 +1,61 @@
+#ifndef DEADLINE_TIMER_H
+#define DEADLINE_TIMER_H
+
+#include <string>
+#include <vector>
+#include <poll.h>
+
+// Timing of one periodic tick against its absolute deadline
+struct TickInfo {
+    long long deadlineNs;  // CLOCK_MONOTONIC deadline the tick was scheduled for
+    long long latenessNs;  // How late the tick started relative to its deadline
+    unsigned long long missedTicks; // Deadlines dropped just before this tick (skip policy only)
+};
+
+// Periodic timer driven by absolute CLOCK_MONOTONIC deadlines on a fixed grid (a timerfd armed with
+// TFD_TIMER_ABSTIME), so scheduling jitter never accumulates into drift.
+class DeadlineTimer {
+public:
+    enum OverrunPolicy {
+        CATCH_UP, // Run every overdue tick back to back until the timer is on schedule again
+        SKIP      // Drop overdue deadlines and run once for the most recent one
+    };
+
+    DeadlineTimer();
+    ~DeadlineTimer();
+
+    DeadlineTimer(const DeadlineTimer&) = delete;
+    DeadlineTimer& operator=(const DeadlineTimer&) = delete;
+
+    // Starts the grid at the first multiple of alignNs after now. Returns false if no timerfd could be created.
+    bool start(long long periodNs, OverrunPolicy policy, long long alignNs);
+
+    // Blocks until the next deadline and describes the tick that is due. If an event fd signals first, returns true
+    // without a tick and sets the bit of each signaled fd in *events (bit i for the i-th added fd) instead; the
+    // deadline stays due. Without events, event fds are not watched.
+    bool waitNextDeadline(TickInfo& tick, unsigned long long* events = nullptr);
+
+    // Also wakes waitNextDeadline() when fd signals POLLPRI, e.g. a PSI trigger. Up to 64 fds, the timer does not
+    // take ownership. Returns false if the limit is reached.
+    bool addEventFd(int fd);
+
+    // Moves the next deadline to one new period after the last one, so no tick is dropped by the change
+    void setPeriod(long long periodNs, OverrunPolicy policy);
+
+    long long getPeriodNs() const;
+    OverrunPolicy getOverrunPolicy() const;
+
+    static long long getMonotonicNanos();
+    static OverrunPolicy parseOverrunPolicy(const std::string& policy);
+
+private:
+    bool waitTimerOrEvents(unsigned long long& events); // Blocks until the armed timer expires or event fds signal
+
+    int fd_;
+    long long periodNs_;
+    long long nextDeadlineNs_;
+    OverrunPolicy policy_;
+    std::vector<struct pollfd> pollFds_; // The timerfd followed by the event fds
+};
+
+#endif // DEADLINE_TIMER_H
@@ -0,0 +1,57 @@
+#ifndef DISK_COLLECTOR_H
+#define DISK_COLLECTOR_H
+
+#include <string>
+#include <vector>
+#include "Collector.h"
+#include "NamedSlotTable.h"
+#include "ProcFile.h"
+#include "SlotCounters.h"
+
+// Reports IOPS, throughput, await, queue depth and utilization of the block devices in <procfs_root>/diskstats,
+// read through a kept-open ProcFile. Devices get one of max_devices slots and their counters go into one
+// CounterMatrix (one row per slot) with the same averaging windows as the CPU collector. Which line belongs to
+// which slot is looked up once, so the lines of partitions, loop devices and other filtered devices are skipped
+// without parsing their numbers; the table is only rebuilt when devices come or go.
+class DiskCollector : public Collector {
+public:
+    // Counters of a line of /proc/diskstats that are reported, times in milliseconds
+    enum Column {
+        READS_COLUMN = 0,
+        SECTORS_READ_COLUMN,
+        READ_MS_COLUMN,
+        WRITES_COLUMN,
+        SECTORS_WRITTEN_COLUMN,
+        WRITE_MS_COLUMN,
+        IO_MS_COLUMN,          // Time with at least one request in flight
+        WEIGHTED_IO_MS_COLUMN, // Time multiplied by the requests in flight
+        NUM_COLUMNS
+    };
+
+    DiskCollector(); // Reads diskstats under system_info.procfs_root
+    explicit DiskCollector(const std::string& path);
+
+    // Allocates the slots and the counter history for the given sampling period
+    void init(unsigned long long jiffiesPerSecond, unsigned long long periodJiffies);
+    // Applies a new sampling period, the configured windows and device filters, keeping the history that still
+    // fits. Returns false if the windows were kept because their number changed, which needs a restart.
+    bool reconfigure(unsigned long long periodJiffies);
+
+    const char* getName() const override;
+    void initSnapshot(SystemInfoData& data) override;
+    bool collect(SystemInfoData& data) override;
+
+private:
+    bool buildLineTable(unsigned long long jiffies); // Maps every line of the current contents to a slot
+    bool parse(); // Fills the pending counters, false if the lines no longer match the table
+    void readFilters();
+    void fillSnapshot(SystemInfoData& data);
+
+    ProcFile file_;
+    NamedSlotTable slots_;
+    SlotCounters counters_;
+    std::vector<long long> inFlight_; // Requests in flight of every slot at the latest sample
+    bool includePartitions_;
+};
+
+#endif // DISK_COLLECTOR_H
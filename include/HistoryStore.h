@@ -0,0 +1,101 @@
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "SnapshotSchema.h"
+#include "SystemInfoData.h"
+
+// One recorded value of a metric
+struct HistoryPoint {
+    long long timeNs; // Wall-clock time of the sample deadline, at HistoryStore::TIME_RESOLUTION_NS
+    double value;
+};
+
+// Summary of the points of a metric that fall into one bucket of a downsampled query
+struct HistoryAggregate {
+    long long startNs; // Start of the bucket
+    long long lastNs;  // Time of the last point in the bucket
+    double min;
+    double max;
+    double mean;
+    double last;
+    unsigned int count;
+};
+
+// Compressed history of every snapshot metric, one series per SnapshotSchema field (e.g. "cpu.core[7].usage_percent").
+// Points are encoded as in Facebook's Gorilla: timestamps as deltas of deltas and values as the XOR with the
+// previous value, so a metric that did not change costs two bits and a regular timestamp one. Each series
+// owns a ring of fixed-size blocks carved out of a single budget, and the oldest block of a series is
+// dropped when its newest one fills, so memory never grows after init().
+// Appends come from the sampling thread; queries may run from any thread and only hold the store's lock
+// while copying the blocks they need.
+class HistoryStore {
+public:
+    static const long long TIME_RESOLUTION_NS; // Timestamps are kept in milliseconds
+
+    HistoryStore();
+
+    // Creates one series per field of schema, splitting budgetBytes into blocks of blockBytes (at least two per series)
+    void init(const SnapshotSchema& schema, size_t budgetBytes, size_t blockBytes);
+    bool isEnabled() const;
+
+    // Records every metric of a snapshot, stamped with the wall-clock time of its sample deadline. Allocation-free.
+    void append(const SystemInfoData& data);
+
+    int findSeries(const std::string& metric) const; // -1 if there is no such metric
+    const std::string& getSeriesName(int series) const;
+    size_t getNumSeries() const;
+    size_t getMemoryBudget() const; // Bytes reserved for the compressed points
+    size_t getMemoryUsed() const;   // Bytes currently holding points
+    unsigned long long getNumPoints() const; // Points currently kept, over all series
+
+    // Appends the points of series with startNs <= time < endNs to points, oldest first. Returns the number added.
+    size_t query(int series, long long startNs, long long endNs, std::vector<HistoryPoint>& points) const;
+
+    // Downsamples the same range into buckets of bucketNs starting at startNs, leaving out empty buckets
+    size_t queryAggregated(int series, long long startNs, long long endNs, long long bucketNs,
+                           std::vector<HistoryAggregate>& aggregates) const;
+
+private:
+    struct Block {
+        uint32_t bitLength;  // Bits written so far, 0 if the block is empty
+        uint32_t numPoints;
+        long long minTime;   // In TIME_RESOLUTION_NS units, for skipping blocks outside a query
+        long long maxTime;
+    };
+
+    // Encoder state of a series, continued from one point to the next within a block
+    struct Series {
+        std::string name;
+        bool isInteger;
+        size_t firstBlock;   // Index of the series' first block in blocks_
+        size_t currentBlock; // 0 .. blocksPerSeries_ - 1, the block being appended to
+        long long previousTime;
+        long long previousDelta;
+        uint64_t previousValue;
+        int previousLeading;
+        int previousTrailing;
+    };
+
+    class Appender;
+    friend class Appender;
+
+    void appendPoint(size_t series, long long time, uint64_t value);
+    void startBlock(Series& series, long long time, uint64_t value);
+    template<typename Function>
+    void forEachPoint(int series, long long startNs, long long endNs, Function function) const;
+    static void decodeBlock(const uint8_t* bytes, const Block& block, bool isInteger, std::vector<HistoryPoint>& points);
+
+    std::vector<Series> series_;
+    std::vector<Block> blocks_;    // blocksPerSeries_ per series
+    std::vector<uint8_t> storage_; // blockBytes_ per block
+    size_t blockBytes_;
+    size_t blocksPerSeries_;
+    mutable std::mutex mutex_;
+};
+
+#endif // HISTORY_STORE_H
@@ -10,6 +10,8 @@ public:
     static JsonManager& getInstance();
     void loadConfigFile();
     const nlohmann::json& getConfig() const;
+    // Reads a config file and replaces its environment variable placeholders. Throws std::runtime_error on failure.
+    static nlohmann::json parseConfigFile(const std::string& configFile);
 
 private:
     JsonManager();
@@ -18,7 +20,7 @@ private:
     static nlohmann::json replaceEnvironmentVariables(const nlohmann::json& jsonConfig);
     static std::string replacePlaceholder(const std::string& input);
     std::string configFilePath;
-    nlohmann::json readConfigFile(const std::string& configFile);
+    static nlohmann::json readConfigFile(const std::string& configFile);
     std::string getConfigFilePath();
     static void recursivelyReplacePlaceholders(nlohmann::json& json);
 };
@@ -0,0 +1,50 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-size histogram of durations in nanoseconds, laid out like an HDR histogram: every power of two is
+// split into SUB_BUCKETS linear buckets, so any recorded value is reported within 1/SUB_BUCKETS (about 3%)
+// of itself from 1 ns up to MAX_VALUE_NS. Recording is a few instructions with no allocation, and the
+// storage is a plain array, so one histogram can be kept per measured quantity for the lifetime of a process.
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const long long SUB_BUCKETS = 1LL << SUB_BUCKET_BITS;
+    static const int MAX_EXPONENT = 40;                      // Values from 2^40 ns (about 18 minutes) on share the last buckets
+    static const long long MAX_VALUE_NS = (1LL << (MAX_EXPONENT + 1)) - 1;
+    static const size_t NUM_BUCKETS = static_cast<size_t>(SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS);
+
+    LatencyHistogram();
+
+    void record(long long valueNs); // Negative values count as 0, values above MAX_VALUE_NS as MAX_VALUE_NS
+    void reset();
+
+    unsigned long long getCount() const;
+    long long getMin() const; // Exact, 0 if nothing was recorded
+    long long getMax() const; // Exact, 0 if nothing was recorded
+    double getMean() const;   // Exact
+    double getStdDev() const; // Exact, the jitter of the recorded values
+
+    // Smallest recorded value that at least percentile % of the values do not exceed, within the bucket
+    // precision (the bucket's upper bound, clamped to getMax()). 0 if nothing was recorded.
+    long long getValueAtPercentile(double percentile) const;
+
+    // Same for several ascending percentiles in a single pass over the buckets
+    void getValuesAtPercentiles(const double* percentiles, size_t count, long long* values) const;
+
+private:
+    static size_t getBucketIndex(long long valueNs);
+    static long long getBucketUpperBound(size_t index);
+    unsigned long long getTargetCount(double percentile) const;
+
+    uint64_t buckets_[NUM_BUCKETS];
+    unsigned long long count_;
+    long long min_;
+    long long max_;
+    double sum_;
+    double sumOfSquares_;
+};
+
+#endif // LATENCY_HISTOGRAM_H
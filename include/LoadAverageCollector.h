@@ -0,0 +1,23 @@
+#ifndef LOAD_AVERAGE_COLLECTOR_H
+#define LOAD_AVERAGE_COLLECTOR_H
+
+#include <string>
+#include "Collector.h"
+#include "ProcFile.h"
+
+// Reports the 1, 5 and 15 minute load averages from <procfs_root>/loadavg, the same values sysinfo() returns
+// but readable from a capture or a synthetic procfs root
+class LoadAverageCollector : public Collector {
+public:
+    LoadAverageCollector(); // Reads loadavg under system_info.procfs_root
+    explicit LoadAverageCollector(const std::string& path);
+
+    const char* getName() const override;
+    void initSnapshot(SystemInfoData& data) override;
+    bool collect(SystemInfoData& data) override;
+
+private:
+    ProcFile file_;
+};
+
+#endif // LOAD_AVERAGE_COLLECTOR_H
@@ -0,0 +1,40 @@
+#ifndef MEMORY_COLLECTOR_H
+#define MEMORY_COLLECTOR_H
+
+#include <cstddef>
+#include <vector>
+#include "Collector.h"
+#include "ProcFile.h"
+
+// Reports the memory breakdown from <procfs_root>/meminfo, read through a kept-open ProcFile.
+// The line layout of /proc/meminfo is fixed for a running kernel, so the line index of every wanted key
+// is looked up once and each sample just walks the lines, checks the key and stores the value at its
+// offset in MemoryInfo. The table is only rebuilt if a key ever moves.
+class MemoryCollector : public Collector {
+public:
+    MemoryCollector(); // Reads meminfo under system_info.procfs_root
+    explicit MemoryCollector(const std::string& path);
+
+    const char* getName() const override;
+    void initSnapshot(SystemInfoData& data) override;
+    bool collect(SystemInfoData& data) override;
+
+    // MemAvailable on kernels before 3.14, which lack it: what the page cache could give back
+    static unsigned long long estimateAvailableBytes(unsigned long long freeBytes, unsigned long long buffersBytes, unsigned long long cachedBytes);
+
+private:
+    struct LineField {
+        const char* key;  // Key of the line, without the ':'
+        size_t keyLength;
+        std::ptrdiff_t offset; // Offset of the field in MemoryInfo, -1 for lines that are not reported
+    };
+
+    bool buildLineTable(); // Maps every line of the current file to a MemoryInfo field
+    bool parse(MemoryInfo& memory); // False if the layout changed since the table was built
+
+    ProcFile file_;
+    std::vector<LineField> lineTable_; // One entry per line of the file
+    bool hasMemAvailable_; // MemAvailable only exists since Linux 3.14
+};
+
+#endif // MEMORY_COLLECTOR_H
@@ -0,0 +1,116 @@
+#ifndef METRIC_ARCHIVE_H
+#define METRIC_ARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SnapshotSchema.h"
+#include "SystemInfoData.h"
+
+// Resolution and length of one tier of a MetricArchive, e.g. 1 s for an hour is { 1, 3600 }
+struct ArchiveTierConfig {
+    int resolutionSeconds;
+    int rows;
+};
+
+// One consolidated row of a metric: every sample that fell into [startNs, startNs + resolution)
+struct ArchiveRow {
+    long long startNs;
+    unsigned int count; // Samples consolidated into the row
+    double min;
+    double max;
+    double avg;
+};
+
+// File layout: ArchiveHeader | ArchiveTierHeader x numTiers | schema JSON | rows of tier 0 | rows of tier 1 | ...
+// A row is an ArchiveRowHeader followed by { min, max, avg } (three doubles) per schema field. Row slots
+// are addressed by time, the row starting at t sits in slot (t / resolution) % rows of its tier, so a slot
+// whose startNs is not the expected one holds an old row.
+struct ArchiveHeader {
+    uint32_t magic;       // MetricArchive::MAGIC
+    uint16_t version;     // MetricArchive::VERSION
+    uint16_t headerSize;  // sizeof(ArchiveHeader)
+    uint32_t numTiers;
+    uint32_t numFields;
+    uint64_t schemaHash;
+    uint32_t schemaOffset;
+    uint32_t schemaSize;
+    uint64_t totalSize;
+    int64_t lastUpdateNs; // Time of the last sample written
+};
+
+struct ArchiveTierHeader {
+    int64_t resolutionNs;
+    uint64_t numRows;
+    uint64_t rowStride;   // Bytes from one row to the next
+    uint64_t dataOffset;  // Start of the tier's first row
+    int64_t currentRowStartNs; // Row the tier is consolidating into, -1 before its first sample
+};
+
+struct ArchiveRowHeader {
+    int64_t startNs;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+// Persistent round-robin archive of every snapshot metric in a fixed-size, memory-mapped file, at several
+// resolutions. Samples are consolidated into the current row of the finest tier; when that row is complete
+// it is merged into the current row of the next tier, and so on, so every tier is kept up to date
+// incrementally. The row each tier is filling is recorded in the file, so a restarted writer carries on where
+// the previous one stopped. Writing only touches the mapping: no system calls, no allocations, and the kernel writes
+// the pages back, so the history survives a crash or restart of the process.
+class MetricArchive {
+public:
+    static const uint32_t MAGIC;
+    static const uint16_t VERSION;
+
+    MetricArchive();
+    ~MetricArchive();
+
+    MetricArchive(const MetricArchive&) = delete;
+    MetricArchive& operator=(const MetricArchive&) = delete;
+
+    // Opens path for writing, continuing an existing archive with the same schema and tiers or replacing it
+    // with an empty one. Returns false if the file could not be created or mapped.
+    bool open(const std::string& path, const SnapshotSchema& schema, const std::vector<ArchiveTierConfig>& tiers);
+    // Maps an existing archive read-only. Returns false if it does not exist or has an unknown layout.
+    bool openReadOnly(const std::string& path);
+    void close(); // Flushes a writable archive to disk
+
+    bool isOpen() const;
+
+    // Consolidates every metric of a snapshot, stamped with the wall-clock time of its sample deadline
+    void append(const SystemInfoData& data);
+
+    const SnapshotSchema& getSchema() const;
+    size_t getNumTiers() const;
+    long long getTierResolutionNs(size_t tier) const;
+    size_t getTierRows(size_t tier) const;
+    long long getLastUpdateNs() const;
+
+    // Appends the rows of a field (a SnapshotSchema field index) in one tier, oldest first, skipping slots
+    // that were never written or are older than the tier's span. Returns the number of rows added.
+    size_t readRows(size_t tier, size_t field, std::vector<ArchiveRow>& rows) const;
+
+private:
+    class Appender;
+    friend class Appender;
+
+    bool mapFile(size_t size, bool writable);
+    bool hasLayout(const ArchiveHeader& expected, const std::vector<ArchiveTierHeader>& tiers) const;
+    const ArchiveTierHeader& getTier(size_t tier) const;
+    ArchiveTierHeader& getTier(size_t tier);
+    char* getRow(size_t tier, long long startNs) const;
+    void accumulate(size_t tier, long long timeNs, const double* stats, uint32_t count);
+
+    std::string path_;
+    int fd_;
+    char* mapping_;
+    size_t mappingSize_;
+    bool writable_;
+    SnapshotSchema schema_;
+    std::vector<double> sampleStats_;           // The snapshot being appended, as a row of { v, v, v }
+};
+
+#endif // METRIC_ARCHIVE_H
@@ -0,0 +1,49 @@
+#ifndef METRIC_PIPELINE_H
+#define METRIC_PIPELINE_H
+
+#include <cstddef>
+
+// A set of metric sources chosen at compile time, e.g. MetricPipeline<CpuTotal, MemAvailable> for a frontend
+// that only needs the total CPU usage and the available memory (see MetricSources.h). The pipeline is made of
+// exactly the listed sources: sample() calls each one directly, with no virtual calls and no runtime checks of
+// what is enabled, and sources that are not listed are never compiled in. This is the counterpart of
+// SystemInfo, which samples every collector with periods, windows and outputs chosen in the config file.
+//
+// A source is any default-constructible class with a bool sample() method and a static getName(). Each source
+// appears at most once and is accessed with get<Source>().
+template<typename... Sources>
+class MetricPipeline : private Sources... {
+public:
+    MetricPipeline() : Sources()... {
+    }
+
+    MetricPipeline(const MetricPipeline&) = delete;
+    MetricPipeline& operator=(const MetricPipeline&) = delete;
+
+    // Samples every source in the listed order. Returns how many of them succeeded.
+    size_t sample() {
+        // The initializer list fixes the order, the leading 0 keeps it valid for an empty pipeline
+        size_t succeeded[] = { 0, static_cast<size_t>(static_cast<Sources&>(*this).sample())... };
+        size_t count = 0;
+        for (size_t value : succeeded) {
+            count += value;
+        }
+        return count;
+    }
+
+    template<typename Source>
+    Source& get() {
+        return static_cast<Source&>(*this);
+    }
+
+    template<typename Source>
+    const Source& get() const {
+        return static_cast<const Source&>(*this);
+    }
+
+    static constexpr size_t getNumSources() {
+        return sizeof...(Sources);
+    }
+};
+
+#endif // METRIC_PIPELINE_H
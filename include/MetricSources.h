@@ -0,0 +1,73 @@
+#ifndef METRIC_SOURCES_H
+#define METRIC_SOURCES_H
+
+#include <string>
+#include "ProcFile.h"
+#include "ProcStatReader.h"
+
+// Sources of a MetricPipeline. Each one reads a single procfs file and keeps only the values it reports, so a
+// pipeline made of a few of them carries none of the storage or parsing of the sources it leaves out. They are
+// plain classes with a non-virtual sample(), which the pipeline calls directly, and parse and account with the
+// same routines as the collectors (ProcParse, CpuUsageCalculator, MemoryCollector), so both report the same values.
+
+// Total CPU usage between two consecutive samples, from the aggregate "cpu" line of <procfs_root>/stat only
+class CpuTotal {
+public:
+    CpuTotal(); // Reads stat under system_info.procfs_root
+    explicit CpuTotal(const std::string& path);
+
+    static const char* getName();
+    bool sample();
+
+    double getUsagePercent() const; // -1 until two samples exist
+    unsigned long long getElapsedJiffies() const; // CPU time the usage covers, summed over every core
+
+private:
+    ProcStatReader statReader_;
+    unsigned long long busyJiffies_; // user + nice + system of the latest sample
+    unsigned long long idleJiffies_;
+    double usagePercent_;
+    unsigned long long elapsedJiffies_;
+    bool hasSample_;
+};
+
+// MemTotal and MemAvailable from <procfs_root>/meminfo, parsing stops as soon as both are found
+class MemAvailable {
+public:
+    MemAvailable(); // Reads meminfo under system_info.procfs_root
+    explicit MemAvailable(const std::string& path);
+
+    static const char* getName();
+    bool sample();
+
+    unsigned long long getTotalBytes() const;
+    unsigned long long getAvailableBytes() const; // MemFree + Buffers + Cached on kernels before 3.14
+    double getAvailablePercent() const;
+
+private:
+    ProcFile file_;
+    unsigned long long totalBytes_;
+    unsigned long long availableBytes_;
+};
+
+// The 1, 5 and 15 minute load averages from <procfs_root>/loadavg
+class LoadAverage {
+public:
+    LoadAverage(); // Reads loadavg under system_info.procfs_root
+    explicit LoadAverage(const std::string& path);
+
+    static const char* getName();
+    bool sample();
+
+    double get1Min() const;
+    double get5Min() const;
+    double get15Min() const;
+
+private:
+    ProcFile file_;
+    double load1Min_;
+    double load5Min_;
+    double load15Min_;
+};
+
+#endif // METRIC_SOURCES_H
@@ -0,0 +1,62 @@
+#ifndef NAMED_SLOT_TABLE_H
+#define NAMED_SLOT_TABLE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Slots of the devices listed one per line in a procfs file such as net/dev or diskstats. A device keeps its slot
+// as long as it is listed, so the counter history of the slot stays its own. Which line belongs to which slot is
+// looked up once, so each sample only compares the names, and the table is rebuilt when devices come or go.
+class NamedSlotTable {
+public:
+    static const size_t NAME_SIZE = 32; // Longer names are cut
+
+    NamedSlotTable();
+
+    // Frees every slot. kind names a device in messages ("network interface"), maxSetting is the setting that
+    // raises the number of slots.
+    void init(size_t numSlots, const std::string& kind, const std::string& maxSetting);
+
+    // Reported devices (every one if patterns is empty) and excluded ones, as fnmatch() patterns. Devices that no
+    // longer pass the filters lose their slot on the next rebuild, which this forces.
+    void setFilters(const std::vector<std::string>& patterns, const std::vector<std::string>& excludedPatterns);
+    bool matchesFilters(const char* name) const;
+
+    // Rebuilding: every line of the file in order, then assignSlots() frees the slots of devices that are gone or no
+    // longer reported and gives the free ones to new reported devices, in the order of the file
+    void clearLines();
+    void addLine(const char* name, size_t length, bool reported);
+    void assignSlots(unsigned long long jiffies);
+
+    // Sampling: false if the line no longer names the device of the table, the table needs a rebuild then
+    size_t getNumLines() const;
+    bool matchesLine(size_t line, const char* name, size_t length) const;
+    int getLineSlot(size_t line) const; // -1 for devices that are not reported
+
+    size_t size() const;
+    const char* getName(size_t slot) const; // Empty if free
+    unsigned long long getFirstJiffies(size_t slot) const; // Jiffies of the first sample of the device in the slot
+
+private:
+    struct Slot {
+        char name[NAME_SIZE];
+        unsigned long long firstJiffies;
+    };
+
+    struct LineEntry {
+        char name[NAME_SIZE];
+        int slot;
+        bool reported;
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<LineEntry> lineTable_; // One entry per device line of the file
+    std::vector<bool> slotInUse_;      // Scratch of assignSlots()
+    std::vector<std::string> patterns_;
+    std::vector<std::string> excludedPatterns_;
+    std::string kind_;
+    std::string maxSetting_;
+};
+
+#endif // NAMED_SLOT_TABLE_H
@@ -0,0 +1,55 @@
+#ifndef NETWORK_COLLECTOR_H
+#define NETWORK_COLLECTOR_H
+
+#include <string>
+#include <vector>
+#include "Collector.h"
+#include "NamedSlotTable.h"
+#include "ProcFile.h"
+#include "SlotCounters.h"
+
+// Reports receive and transmit rates of bytes, packets, errors and drops for the network interfaces in
+// <procfs_root>/net/dev, read through a kept-open ProcFile. Interfaces get one of max_interfaces slots and their
+// counters go into one CounterMatrix (one row per slot) with the same averaging windows as the CPU collector.
+// Which line of the file belongs to which slot is looked up once, and each sample just walks the lines and checks
+// the names; the table is only rebuilt when interfaces come or go.
+class NetworkCollector : public Collector {
+public:
+    // Order of the counters on a line of /proc/net/dev that are reported
+    enum Column {
+        RX_BYTES_COLUMN = 0,
+        RX_PACKETS_COLUMN,
+        RX_ERRORS_COLUMN,
+        RX_DROPPED_COLUMN,
+        TX_BYTES_COLUMN,
+        TX_PACKETS_COLUMN,
+        TX_ERRORS_COLUMN,
+        TX_DROPPED_COLUMN,
+        NUM_COLUMNS
+    };
+
+    NetworkCollector(); // Reads net/dev under system_info.procfs_root
+    explicit NetworkCollector(const std::string& path);
+
+    // Allocates the slots and the counter history for the given sampling period
+    void init(unsigned long long jiffiesPerSecond, unsigned long long periodJiffies);
+    // Applies a new sampling period, the configured windows and interface filters, keeping the history that still
+    // fits. Returns false if the windows were kept because their number changed, which needs a restart.
+    bool reconfigure(unsigned long long periodJiffies);
+
+    const char* getName() const override;
+    void initSnapshot(SystemInfoData& data) override;
+    bool collect(SystemInfoData& data) override;
+
+private:
+    bool buildLineTable(unsigned long long jiffies); // Maps every line of the current contents to a slot
+    bool parse(); // Fills the pending counters, false if the lines no longer match the table
+    void readFilters();
+    void fillSnapshot(SystemInfoData& data);
+
+    ProcFile file_;
+    NamedSlotTable slots_;
+    SlotCounters counters_;
+};
+
+#endif // NETWORK_COLLECTOR_H
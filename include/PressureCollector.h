@@ -0,0 +1,74 @@
+#ifndef PRESSURE_COLLECTOR_H
+#define PRESSURE_COLLECTOR_H
+
+#include <string>
+#include <vector>
+#include "Collector.h"
+#include "ProcFile.h"
+
+// One PSI trigger of system_info.pressure.triggers, e.g. { "memory", "some", 300000, 2000000 } fires when tasks
+// stall on memory for 300 ms within any 2 s
+struct PressureTriggerConfig {
+    std::string resource; // "cpu", "memory" or "io"
+    std::string type;     // "some" or "full"
+    int stallUs;          // Stall time within the window that fires the trigger
+    int windowUs;         // Tracking window, 500 ms to 10 s (a multiple of 2 s without CAP_SYS_RESOURCE); fires at most once per window
+};
+
+// Reports pressure stall information of the CPU, memory and I/O from <procfs_root>/pressure/{cpu,memory,io}, read
+// through kept-open ProcFiles, and turns the stall totals into stall rates between its own samples. Resources the
+// kernel does not report (no CONFIG_PSI, or booted with psi=0) are left at -1 without further reads.
+//
+// The configured triggers are registered on the pressure files of the real procfs, and SystemInfo polls their fds
+// alongside its timer, so a stall is sampled as soon as the kernel reports it instead of on the next tick.
+class PressureCollector : public Collector {
+public:
+    enum Resource {
+        CPU_RESOURCE = 0,
+        MEMORY_RESOURCE,
+        IO_RESOURCE,
+        NUM_RESOURCES
+    };
+
+    PressureCollector(); // Reads pressure/ under system_info.procfs_root
+    explicit PressureCollector(const std::string& directory);
+    ~PressureCollector();
+
+    PressureCollector(const PressureCollector&) = delete;
+    PressureCollector& operator=(const PressureCollector&) = delete;
+
+    // Registers the triggers of system_info.pressure.triggers. Triggers the kernel rejects are reported and skipped,
+    // and none are registered on a procfs root that is not procfs or while replaying a capture.
+    void init();
+
+    // Fds of the registered triggers, which signal POLLPRI when they fire
+    const std::vector<int>& getTriggerFds() const;
+
+    // Counts the triggers that fired, bit i standing for getTriggerFds()[i], into the next collected snapshot
+    void addTriggerEvents(unsigned long long events);
+
+    const char* getName() const override;
+    void initSnapshot(SystemInfoData& data) override;
+    bool collect(SystemInfoData& data) override;
+
+private:
+    struct Totals {
+        unsigned long long someUs;
+        unsigned long long fullUs;
+        long long sampleNs; // Time of the read, 0 before the first one
+    };
+
+    bool parse(Resource resource, PressureInfo& pressure);
+    static PressureInfo& getPressure(SystemInfoData& data, Resource resource);
+    static int parseResource(const std::string& name); // -1 if unknown
+
+    std::string directory_;
+    ProcFile files_[NUM_RESOURCES];
+    bool available_[NUM_RESOURCES]; // False once a resource could not be read, the kernel does not report it then
+    Totals totals_[NUM_RESOURCES];
+    unsigned long long triggerEvents_[NUM_RESOURCES];
+    std::vector<int> triggerFds_;
+    std::vector<Resource> triggerResources_; // Resource of each trigger fd
+};
+
+#endif // PRESSURE_COLLECTOR_H
@@ -3,33 +3,156 @@
 #define PRINTER_H
 
 #include "ConfigManager.h" // Include ConfigManager header file
+#include "BoundedQueue.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+
+// Messages above this verbosity are compiled out entirely (see SYSTEM_DIAGNOSTICS_STRIP_DEBUG_LOGS in CMakeLists.txt)
+#ifndef SYSTEM_DIAGNOSTICS_MAX_VERBOSITY
+#define SYSTEM_DIAGNOSTICS_MAX_VERBOSITY 1000000
+#endif
+
+// Logging macros that only evaluate the message expression once the verbosity check passed, so
+// filtered-out messages cost a comparison and no string building. The threshold is a constant at every
+// call site, so messages above SYSTEM_DIAGNOSTICS_MAX_VERBOSITY are removed by the compiler.
+#define PRINTER_LOG_(method, threshold, lineNumber, filename, ...)                                  \
+    do {                                                                                            \
+        if ((threshold) <= SYSTEM_DIAGNOSTICS_MAX_VERBOSITY) {                                      \
+            Printer& loggingPrinter_ = Printer::getInstance();                                      \
+            if (loggingPrinter_.isEnabled(threshold)) {                                             \
+                loggingPrinter_.method((__VA_ARGS__), lineNumber, filename, threshold);             \
+            }                                                                                       \
+        }                                                                                           \
+    } while (0)
+
+#define PRINT_INFO(threshold, ...) PRINTER_LOG_(print, threshold, -1, "", __VA_ARGS__)
+#define PRINT_WARNING(threshold, ...) PRINTER_LOG_(printWarning, threshold, __LINE__, __FILE__, __VA_ARGS__)
+#define PRINT_ERROR(threshold, ...) PRINTER_LOG_(printError, threshold, __LINE__, __FILE__, __VA_ARGS__)
+
+// Rate-limited variants for conditions that can recur on every sample. Each call site gets its own budget
+// (printer.rate_limit_burst messages per printer.rate_limit_interval_seconds); suppressed messages are not
+// formatted, only counted, and the next message printed from the site says how many were suppressed.
+#define PRINTER_LOG_RATE_LIMITED_(method, threshold, lineNumber, filename, ...)                     \
+    do {                                                                                            \
+        if ((threshold) <= SYSTEM_DIAGNOSTICS_MAX_VERBOSITY) {                                      \
+            Printer& loggingPrinter_ = Printer::getInstance();                                      \
+            if (loggingPrinter_.isEnabled(threshold)) {                                             \
+                static PrinterRateLimit loggingRateLimit_(__FILE__, __LINE__);                      \
+                std::string loggingSuppressed_;                                                     \
+                if (loggingRateLimit_.acquire(loggingSuppressed_)) {                                \
+                    loggingPrinter_.method((__VA_ARGS__) + loggingSuppressed_, lineNumber, filename, threshold); \
+                }                                                                                   \
+            }                                                                                       \
+        }                                                                                           \
+    } while (0)
+
+#define PRINT_INFO_RATE_LIMITED(threshold, ...) PRINTER_LOG_RATE_LIMITED_(print, threshold, -1, "", __VA_ARGS__)
+#define PRINT_WARNING_RATE_LIMITED(threshold, ...) PRINTER_LOG_RATE_LIMITED_(printWarning, threshold, __LINE__, __FILE__, __VA_ARGS__)
+#define PRINT_ERROR_RATE_LIMITED(threshold, ...) PRINTER_LOG_RATE_LIMITED_(printError, threshold, __LINE__, __FILE__, __VA_ARGS__)
+
+// Budget of one rate-limited call site: up to `burst` messages per interval, the rest are counted
+class PrinterRateLimit {
+public:
+    PrinterRateLimit(const char* filename, int lineNumber);
+    ~PrinterRateLimit(); // Reports messages that were suppressed and never summarized
+
+    // Whether a message may be printed now. If messages were suppressed before it, suppressedNote is set to a
+    // note to append to the message (the only case that builds a string).
+    bool acquire(std::string& suppressedNote);
+
+private:
+    const char* filename_;
+    int lineNumber_;
+    std::mutex mutex_; // Uncontended in practice, each site is usually hit by one thread
+    long long windowStartNs_;
+    long long printedInWindow_;
+    unsigned long long suppressed_;
+    long long firstSuppressedNs_;
+};
+
+// Settings of the printer that a config reload may change while messages are being printed
+struct PrinterSettings {
+    int verbosity;
+    bool printLineNumber;
+    bool printCurrentTime;
+    std::string prefix;
+    std::string suffix;
+    std::string infoColor;
+    std::string warningColor;
+    std::string errorColor;
+    int rateLimitBurst; // Messages per rate-limited call site and interval, 0 to disable rate limiting
+    double rateLimitIntervalSeconds;
+};
 
 class Printer {
 public:
     static Printer& getInstance();
+    ~Printer(); // Writes out every queued message before returning
 
     void print(const std::string& message, int lineNumber = -1, const std::string& filename = "", int debugThreshold = -1) const;
     void printWarning(const std::string& message, int lineNumber = -1, const std::string& filename = "", int debugThreshold = -1) const;
     void printError(const std::string& message, int lineNumber = -1, const std::string& filename = "", int debugThreshold = -1) const;
     void printWithColor(const std::string& message, const std::string& status, int lineNumber, const std::string& filename, const std::string& color) const;
 
+    // Whether a message with this debug threshold would be printed at the configured verbosity
+    bool isEnabled(int debugThreshold) const { return settings_.load(std::memory_order_acquire)->verbosity >= debugThreshold; }
+
+    // Budget of every rate-limited call site
+    int getRateLimitBurst() const;
+    double getRateLimitIntervalSeconds() const;
+
+    // In async mode, waits until every message queued so far has been written
+    void flush() const;
+    unsigned long long getQueuedCount() const; // Messages handed to the writer thread
+    unsigned long long getDroppedCount() const; // Messages dropped because the queue was full (drop policy)
+
+    // Re-reads the verbosity and the printer section from the ConfigManager. Threads printing meanwhile use
+    // either the old or the new settings, never a mix. async, queue_capacity and overflow_policy need a restart.
+    void reloadSettings();
+
 private:
     Printer();
 
+    enum OverflowPolicy {
+        DROP_ON_OVERFLOW, // The message is dropped and counted, the caller never waits
+        BLOCK_ON_OVERFLOW // The caller waits for room in the queue
+    };
+
     void initializeSettings();
+    std::unique_ptr<PrinterSettings> readSettings() const;
+    void startWriter();
+    void stopWriter();
+    void writerLoop();
+    void writeRecord(std::string& record) const; // Queues a formatted record, or writes it directly in synchronous mode
 
-    int verbosity;
-    bool printLineNumber;
-    bool printCurrentTime;
-    std::string prefix;
-    std::string suffix;
-    std::string infoColor;
-    std::string warningColor;
-    std::string errorColor;
+    // Current settings, swapped as a whole on reload. Every version is kept until the printer is destroyed,
+    // as a thread may still be formatting a message with an older one; reloads are rare and small.
+    std::atomic<const PrinterSettings*> settings_;
+    std::vector<std::unique_ptr<PrinterSettings> > settingsVersions_;
+    std::mutex reloadMutex_; // Serializes reloadSettings()
+    bool async; // Hand messages to a background writer thread instead of writing them on the caller's thread
+    size_t queueCapacity;
+    OverflowPolicy overflowPolicy;
+
+    // Asynchronous mode: producers format their message and push it into the lock-free queue,
+    // the writer thread writes whatever is queued in batches with a single flush
+    mutable BoundedQueue<std::string> queue_;
+    std::thread writerThread_;
+    std::atomic<bool> writerRunning_;
+    mutable std::atomic<bool> writerSleeping_;
+    mutable std::mutex wakeMutex_; // Only used to park the idle writer thread
+    mutable std::condition_variable wakeCondition_;
+    mutable std::atomic<unsigned long long> queuedCount_;
+    mutable std::atomic<unsigned long long> droppedCount_;
+    std::atomic<unsigned long long> writtenCount_;
     std::string buildMessageString(const std::string& message, const std::string& status, int lineNumber, const std::string& filename) const;
     std::string colorizeString(const std::string& message, const std::string& color) const;
-    std::string getColorCode(const std::string& color) const;
+    static const char* getColorCode(const std::string& color);
     std::string getCurrentTime() const;
 };
 
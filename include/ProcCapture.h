@@ -0,0 +1,106 @@
+#ifndef PROC_CAPTURE_H
+#define PROC_CAPTURE_H
+
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "DeadlineTimer.h"
+
+// Records the raw contents of every procfs read, with the time of the read and the ticks that caused it, into a
+// compact capture file (system_info.capture.mode "record"), and feeds them back to ProcFile in place of the real
+// files ("replay"), so a capture from any machine drives the same parsers and calculators again.
+//
+// The file is a "SYSC" header followed by records: a path definition ('P') the first time a path is read, every
+// read as the full contents ('R') or as the bytes that changed since the previous read of the same path ('D'),
+// and a tick ('T') before the reads of each sample. Numbers are varints, times are deltas to the previous one.
+class ProcCapture {
+public:
+    enum Mode {
+        OFF,
+        RECORD,
+        REPLAY
+    };
+
+    // Configured from system_info.capture on first use
+    static ProcCapture& getInstance();
+
+    ProcCapture(const ProcCapture&) = delete;
+    ProcCapture& operator=(const ProcCapture&) = delete;
+
+    // Closes the current capture file and continues in mode with the one at path, from a fresh state. Only
+    // ProcFiles opened afterwards follow the new mode. False, and OFF, if the file could not be opened.
+    bool reopen(Mode mode, const std::string& path);
+
+    Mode getMode() const;
+    bool isRecording() const;
+    bool isReplaying() const;
+
+    // CLOCK_MONOTONIC time of a sample: now, or when replaying the recorded time of the latest replayed read
+    long long getSampleNanos() const;
+
+    // Id of a path in the capture. Recording assigns one to every new path, replaying returns -1 for paths
+    // the capture has not reached yet.
+    int getPathId(const std::string& path);
+
+    // Recording: one read of the path, or its failure with error (an errno value)
+    void recordRead(int pathId, const char* data, size_t size, int error);
+    void recordTick(const TickInfo& tick, long long timeStampNs);
+    void flush();
+
+    // Replaying: false (with errno set) if the latest recorded read of the path failed or the path was never read
+    bool canOpen(int pathId) const;
+    bool replayRead(int pathId, std::vector<char>& buffer, size_t& length);
+
+    // Replaying: applies the reads recorded for the next tick. False once the capture is exhausted.
+    bool nextTick(TickInfo& tick, long long& timeStampNs);
+
+private:
+    ProcCapture();
+    ~ProcCapture();
+
+    bool openRecording(const std::string& path);
+    bool openReplay(const std::string& path);
+    bool readUntilTick(); // Applies records up to the next tick, which becomes pendingTick_
+
+    // Encoding into recordBuffer_
+    void putVarint(unsigned long long value);
+    void putSignedVarint(long long value);
+    void writeRecord();
+
+    // Decoding from file_
+    bool getVarint(unsigned long long& value);
+    bool getSignedVarint(long long& value);
+    bool getBytes(char* data, size_t size);
+
+    struct PathState {
+        std::string path;
+        std::string data;  // Contents of the latest read
+        int error;         // errno of the latest read, 0 if it succeeded
+        long long readNs;  // CLOCK_MONOTONIC time of the latest read
+        bool seen;         // Whether the path was read at all
+    };
+
+    Mode mode_;
+    std::string capturePath_;
+    FILE* file_;
+    std::vector<char> fileBuffer_; // stdio buffer of file_, so records reach the disk in large writes
+    mutable std::mutex mutex_;
+
+    std::unordered_map<std::string, int> pathIds_;
+    std::vector<PathState> paths_;
+    std::string recordBuffer_; // Scratch for encoding one record, reused
+    std::string decodeBuffer_; // Scratch for applying a 'D' record, swapped with the contents it replaces
+    long long lastReadNs_;     // Base of the read time deltas
+    long long lastDeadlineNs_; // Base of the tick deadline deltas
+    long long lastTimeStampNs_;
+    long long sampleNs_;       // Time of the latest replayed read
+    TickInfo pendingTick_;
+    long long pendingTimeStampNs_;
+    bool hasPendingTick_;
+    unsigned long long ticks_; // Ticks recorded or replayed so far
+};
+
+#endif // PROC_CAPTURE_H
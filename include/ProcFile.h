@@ -0,0 +1,50 @@
+#ifndef PROC_FILE_H
+#define PROC_FILE_H
+
+#include <string>
+#include <vector>
+
+// A procfs file read through a file descriptor that stays open for the lifetime of the object.
+// Every read is a single pread() into a reusable buffer that only grows when the file outgrows it,
+// so steady-state sampling performs no heap allocations and no open()/close() calls.
+// When ProcCapture records, every open and read is also written to the capture, and when it replays, the
+// recorded contents are served instead of the file's.
+class ProcFile {
+public:
+    explicit ProcFile(const std::string& path = "", size_t initialBufferSize = 4096);
+    ~ProcFile();
+
+    ProcFile(const ProcFile&) = delete;
+    ProcFile& operator=(const ProcFile&) = delete;
+    ProcFile(ProcFile&& other);
+    ProcFile& operator=(ProcFile&& other);
+
+    // Closes the current file, if any, and opens path. Returns false if it could not be opened.
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const;
+    const std::string& getPath() const;
+
+    // preads the whole file from offset 0. Returns false (with errno set) if it could not be read,
+    // e.g. ESRCH once the process behind a /proc/<pid> file has exited.
+    bool read();
+
+    // Raw contents of the most recent read (not null terminated).
+    const char* data() const;
+    size_t size() const;
+
+    // Names of the entries of a directory, e.g. the PIDs in /proc, recorded and replayed like a read.
+    // Returns false (with errno set) if the directory could not be read.
+    static bool listDirectory(const std::string& path, std::vector<std::string>& names);
+
+private:
+    std::string path_;
+    int fd_;
+    int captureId_; // Id of path_ in ProcCapture, -1 unless recording or replaying
+    bool replaying_; // Open on the capture instead of a file descriptor
+    std::vector<char> buffer_;
+    size_t length_;
+};
+
+#endif // PROC_FILE_H
@@ -0,0 +1,82 @@
+#ifndef PROC_PARSE_H
+#define PROC_PARSE_H
+
+#include <cstddef>
+#include <cstring>
+
+// Minimal, locale-free helpers for scanning procfs text in place. All functions advance the
+// cursor and never read past end.
+namespace ProcParse {
+
+inline void skipSpaces(const char*& p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+}
+
+inline void skipToken(const char*& p, const char* end) {
+    skipSpaces(p, end);
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\n') {
+        ++p;
+    }
+}
+
+inline unsigned long long parseUnsigned(const char*& p, const char* end) {
+    skipSpaces(p, end);
+    unsigned long long value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + static_cast<unsigned long long>(*p - '0');
+        ++p;
+    }
+    return value;
+}
+
+// Non-negative decimal such as the load averages of /proc/loadavg ("0.52")
+inline double parseDecimal(const char*& p, const char* end) {
+    double value = static_cast<double>(parseUnsigned(p, end));
+    if (p < end && *p == '.') {
+        ++p;
+        double scale = 0.1;
+        while (p < end && *p >= '0' && *p <= '9') {
+            value += scale * (*p - '0');
+            scale *= 0.1;
+            ++p;
+        }
+    }
+    return value;
+}
+
+// Whether the line at p is "key: ..." as in /proc/meminfo
+inline bool hasKey(const char* p, const char* end, const char* key, size_t keyLength) {
+    return static_cast<size_t>(end - p) > keyLength && std::memcmp(p, key, keyLength) == 0 && p[keyLength] == ':';
+}
+
+// Value of a /proc/meminfo line in bytes, p points past the colon ("   1234 kB"). Lines without a unit are counts.
+inline unsigned long long parseMemInfoValue(const char*& p, const char* end) {
+    unsigned long long value = parseUnsigned(p, end);
+    skipSpaces(p, end);
+    if (end - p >= 2 && p[0] == 'k' && p[1] == 'B') {
+        value *= 1024;
+    }
+    return value;
+}
+
+// The 1, 5 and 15 minute loads of /proc/loadavg ("0.52 0.58 0.59 1/467 12345"), the other fields are left unread
+inline void parseLoadAverages(const char*& p, const char* end, double& load1Min, double& load5Min, double& load15Min) {
+    load1Min = parseDecimal(p, end);
+    load5Min = parseDecimal(p, end);
+    load15Min = parseDecimal(p, end);
+}
+
+inline void nextLine(const char*& p, const char* end) {
+    while (p < end && *p != '\n') {
+        ++p;
+    }
+    if (p < end) {
+        ++p;
+    }
+}
+
+} // namespace ProcParse
+
+#endif // PROC_PARSE_H
@@ -0,0 +1,39 @@
+#ifndef PROC_STAT_READER_H
+#define PROC_STAT_READER_H
+
+#include <string>
+#include "ProcFile.h"
+
+// Reads /proc/stat through a ProcFile that stays open for the lifetime of the reader.
+// Every sample is a single pread() into a reusable buffer, and the counters are parsed in place,
+// so steady-state sampling performs no heap allocations.
+class ProcStatReader {
+public:
+    explicit ProcStatReader(const std::string& path = "/proc/stat");
+
+    ProcStatReader(const ProcStatReader&) = delete;
+    ProcStatReader& operator=(const ProcStatReader&) = delete;
+
+    bool isOpen() const;
+    const std::string& getPath() const;
+
+    // Reads the file and parses the "cpu" lines into the given columns. Row 0 is the aggregate
+    // "cpu" line and row n is the n-th per-core line. Returns the number of rows written (at most
+    // maxRows), or -1 if the file could not be read.
+    int read(unsigned long long* user, unsigned long long* nice, unsigned long long* sys,
+             unsigned long long* idle, int maxRows);
+
+    // Number of "cpu" lines in the file, including the aggregate line. Returns -1 on failure.
+    int countCpuLines();
+
+    // Raw contents of the most recent read (not null terminated).
+    const char* data() const;
+    size_t size() const;
+
+private:
+    ProcFile file_;
+
+    static const size_t INITIAL_BUFFER_SIZE = 16384;
+};
+
+#endif // PROC_STAT_READER_H
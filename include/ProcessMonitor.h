@@ -0,0 +1,65 @@
+#ifndef PROCESS_MONITOR_H
+#define PROCESS_MONITOR_H
+
+#include <string>
+#include <vector>
+#include "Collector.h"
+#include "ProcFile.h"
+#include "SlotCounters.h"
+
+// Reports CPU usage, resident memory and thread count of the processes listed under system_info.processes,
+// by PID or by command name pattern. Each watched process keeps /proc/<pid>/stat and /proc/<pid>/statm open,
+// so a sample is two pread() calls per process. The CPU time counters go into one CounterMatrix shared by
+// every process (one row per slot) and use the same averaging windows as the CPU collector.
+class ProcessMonitor : public Collector {
+public:
+    enum Column {
+        UTIME_COLUMN = 0,
+        STIME_COLUMN,
+        NUM_COLUMNS
+    };
+
+    ProcessMonitor();
+
+    // Allocates the slots and the counter history for the given sampling period and looks for the processes
+    void init(unsigned long long jiffiesPerSecond, unsigned long long periodJiffies);
+    // Applies a new sampling period, the configured windows and rescan period, keeping the history that still fits.
+    // Returns false if the windows were kept because their number changed, which needs a restart.
+    bool reconfigure(unsigned long long periodJiffies);
+
+    const char* getName() const override;
+    void initSnapshot(SystemInfoData& data) override;
+    bool collect(SystemInfoData& data) override;
+
+private:
+    struct Slot {
+        int pid; // 0 if free
+        char name[16];
+        ProcFile statFile;
+        ProcFile statmFile;
+        unsigned long long firstJiffies; // Jiffies of the first sample of this process, older history belongs to another one
+        long long rssBytes;
+        int numThreads;
+    };
+
+    void rescan(unsigned long long jiffies); // Looks for configured processes that are not watched yet
+    bool isWatched(int pid) const;
+    bool watch(int pid, unsigned long long jiffies); // Opens the process files in a free slot
+    void release(Slot& slot);
+    bool sampleSlot(Slot& slot, unsigned long long* utime, unsigned long long* stime); // False once the process exited
+    void fillSnapshot(SystemInfoData& data);
+
+    std::vector<Slot> slots_;
+    ProcFile commFile_; // Reused to read /proc/<pid>/comm while rescanning
+    SlotCounters counters_; // utime and stime of every slot
+    std::vector<int> pids_; // Configured PIDs
+    std::vector<std::string> namePatterns_; // Configured command name patterns
+    std::vector<std::string> procEntries_; // Reused listing of the procfs root while rescanning
+    std::string procRoot_; // system_info.procfs_root
+    unsigned long long rescanPeriodJiffies_;
+    unsigned long long lastRescanJiffies_;
+    bool rescanDue_;
+    long long pageSize_;
+};
+
+#endif // PROCESS_MONITOR_H
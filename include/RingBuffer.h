@@ -0,0 +1,78 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+// Fixed-capacity circular buffer. Storage is allocated once at construction (or reset), pushing
+// overwrites the oldest element once the buffer is full, and every access is O(1).
+// Logical index 0 is the oldest element and size() - 1 the newest.
+template<typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity = 0) {
+        reset(capacity);
+    }
+
+    // Reallocates the storage for a new capacity and drops all elements
+    void reset(size_t capacity) {
+        data_.assign(capacity, T());
+        head_ = 0;
+        size_ = 0;
+    }
+
+    void clear() {
+        head_ = 0;
+        size_ = 0;
+    }
+
+    void push(const T& value) {
+        if (data_.empty()) {
+            return;
+        }
+        data_[head_] = value;
+        head_ = getWrappedIndex(head_ + 1);
+        if (size_ < data_.size()) {
+            ++size_;
+        }
+    }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return data_.size(); }
+    bool empty() const { return size_ == 0; }
+    bool full() const { return size_ == data_.size(); }
+
+    // Element at a logical index, 0 being the oldest
+    const T& at(size_t index) const {
+        return data_[getPhysicalIndex(index)];
+    }
+
+    // Element pushed `age` pushes before the newest one, 0 being the newest
+    const T& fromNewest(size_t age) const {
+        return at(size_ - 1 - age);
+    }
+
+    const T& oldest() const { return at(0); }
+    const T& newest() const { return at(size_ - 1); }
+
+    // Position in the underlying storage that the next push will write to
+    size_t getNextPhysicalIndex() const {
+        return head_;
+    }
+
+    // Position in the underlying storage of a logical index
+    size_t getPhysicalIndex(size_t index) const {
+        return getWrappedIndex(head_ + data_.size() - size_ + index);
+    }
+
+private:
+    size_t getWrappedIndex(size_t index) const {
+        return index >= data_.size() ? index - data_.size() : index;
+    }
+
+    std::vector<T> data_;
+    size_t head_; // Storage position of the next push
+    size_t size_;
+};
+
+#endif // RING_BUFFER_H
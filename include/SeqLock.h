@@ -0,0 +1,48 @@
+#ifndef SEQ_LOCK_H
+#define SEQ_LOCK_H
+
+#include <atomic>
+#include <thread>
+
+// Sequence lock for a single writer and any number of readers.
+// The writer never waits for readers, and readers never take a lock: they copy the protected data
+// optimistically and retry if the sequence number shows that a write overlapped the copy.
+// The protected data must not be reallocated while readers may be copying it.
+class SeqLock {
+public:
+    SeqLock() : sequence_(0) {}
+
+    void writeBegin() {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void writeEnd() {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Waits for any write in progress to finish and returns the sequence to validate against
+    unsigned long long readBegin() const {
+        unsigned long long sequence = sequence_.load(std::memory_order_acquire);
+        while (sequence & 1) {
+            std::this_thread::yield();
+            sequence = sequence_.load(std::memory_order_acquire);
+        }
+        return sequence;
+    }
+
+    // True if a write started since readBegin() returned sequence, in which case the copy is torn
+    bool readRetry(unsigned long long sequence) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return sequence_.load(std::memory_order_relaxed) != sequence;
+    }
+
+    unsigned long long getSequence() const {
+        return sequence_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<unsigned long long> sequence_;
+};
+
+#endif // SEQ_LOCK_H
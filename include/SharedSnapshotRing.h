@@ -0,0 +1,115 @@
+#ifndef SHARED_SNAPSHOT_RING_H
+#define SHARED_SNAPSHOT_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "SnapshotSchema.h"
+#include "SystemInfoData.h"
+
+// Layout of the POSIX shared-memory object (/dev/shm/<name>) a SharedSnapshotRing publishes into:
+//   SharedRingHeader | schema JSON (SnapshotSchema::toJson()) | numSlots x slotStride bytes of slots
+// Each slot is a SharedRingSlot followed by one serialized snapshot in the SnapshotSchema layout.
+// Snapshot number i (counting from 0) lives in slot i % numSlots, and that slot's sequence is 2i+1 while
+// it is being written and 2i+2 once it is complete, so a reader can tell a torn or overwritten copy.
+struct SharedRingHeader {
+    std::atomic<uint32_t> magic;  // SharedSnapshotRing::MAGIC, stored last once everything else is initialized
+    uint16_t version;             // SharedSnapshotRing::VERSION
+    uint16_t headerSize;          // sizeof(SharedRingHeader)
+    uint32_t numSlots;
+    uint32_t slotStride;          // Bytes from one slot to the next, a multiple of 64
+    uint32_t snapshotSize;        // SnapshotSchema::getSize()
+    uint32_t schemaOffset;
+    uint32_t schemaSize;          // Length of the schema JSON, not null terminated
+    uint32_t slotsOffset;
+    uint64_t schemaHash;
+    uint64_t totalSize;
+    int32_t writerPid;
+    std::atomic<uint32_t> state;  // SharedSnapshotRing::ACTIVE while the writer publishes, CLOSED once it stopped
+    std::atomic<uint64_t> publishedCount; // Number of snapshots published so far, the latest is publishedCount - 1
+};
+
+struct SharedRingSlot {
+    std::atomic<uint64_t> sequence;
+    uint64_t reserved;
+};
+
+// Writer side: publishes every snapshot of one SystemInfo into a shared-memory ring, so other processes on
+// the node read the samples instead of parsing /proc themselves. Only one writer may publish under a name;
+// publish() never blocks and never allocates.
+class SharedSnapshotRing {
+public:
+    enum State : uint32_t {
+        ACTIVE = 1,
+        CLOSED = 2
+    };
+
+    static const uint32_t MAGIC;
+    static const uint16_t VERSION;
+
+    SharedSnapshotRing();
+    ~SharedSnapshotRing();
+
+    SharedSnapshotRing(const SharedSnapshotRing&) = delete;
+    SharedSnapshotRing& operator=(const SharedSnapshotRing&) = delete;
+
+    // Creates the shared-memory object name (e.g. "/system_diagnostics") with room for numSlots snapshots of
+    // the given schema, replacing a ring left behind by a writer that exited. Returns false if it could not be
+    // created or another live process is still publishing under that name.
+    bool create(const std::string& name, const SnapshotSchema& schema, unsigned int numSlots);
+    void close(); // Marks the ring closed for readers and unlinks it
+
+    bool isOpen() const;
+    void publish(const SystemInfoData& data);
+
+private:
+    std::string name_;
+    int fd_;
+    char* mapping_;
+    size_t mappingSize_;
+    SharedRingHeader* header_;
+    SnapshotSchema schema_;
+};
+
+// Reader side: maps a ring read-only. Reads are lock-free, never block the writer and never allocate.
+class SharedSnapshotReader {
+public:
+    SharedSnapshotReader();
+    ~SharedSnapshotReader();
+
+    SharedSnapshotReader(const SharedSnapshotReader&) = delete;
+    SharedSnapshotReader& operator=(const SharedSnapshotReader&) = delete;
+
+    // Maps the ring published under name. Returns false if there is none (yet) or it has an unknown layout.
+    bool open(const std::string& name);
+    void close();
+
+    bool isOpen() const;
+    // False once the writer closed the ring or exited. A restarted writer creates a new ring, possibly of
+    // another shape, so open() the name again to follow it.
+    bool isWriterActive() const;
+
+    const SnapshotSchema& getSchema() const; // Layout of every snapshot, resolve metrics once with findField()
+    unsigned int getNumSlots() const;         // Snapshots kept, the history a reader can go back
+    unsigned long long getPublishedCount() const;
+
+    // Copies the latest snapshot into buffer. Returns the bytes written, or 0 if nothing has been published
+    // yet, the buffer is smaller than getSchema().getSize(), or the latest slot stays incomplete (e.g. the writer
+    // died while publishing). index, if given, receives its number.
+    size_t readLatest(void* buffer, size_t capacity, unsigned long long* index = nullptr) const;
+
+    // Copies snapshot number index. Returns 0 if it is not published yet or was already overwritten.
+    size_t read(unsigned long long index, void* buffer, size_t capacity) const;
+
+private:
+    const SharedRingSlot* getSlot(unsigned long long index) const;
+
+    int fd_;
+    const char* mapping_;
+    size_t mappingSize_;
+    const SharedRingHeader* header_;
+    SnapshotSchema schema_;
+};
+
+#endif // SHARED_SNAPSHOT_RING_H
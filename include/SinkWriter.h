@@ -0,0 +1,90 @@
+#ifndef SINK_WRITER_H
+#define SINK_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BoundedQueue.h"
+#include "SnapshotSchema.h"
+#include "SnapshotSink.h"
+#include "SystemInfoData.h"
+
+// One entry of system_info.sinks
+struct SinkConfig {
+    std::string format;       // "csv", "jsonl" or "binary"
+    std::string directory;    // Must exist
+    std::string prefix;       // Files are named <prefix>-<YYYYmmdd-HHMMSS>.<extension>
+    long long rotateBytes;    // Start a new file once this size is reached, 0 to never rotate by size
+    int rotateSeconds;        // Start a new file once the current one is this old, 0 to never rotate by age
+    int batchBytes;           // Formatted records are written in blocks of about this size
+    double flushSeconds;      // Longest a record waits in the block before it is written
+    int queueCapacity;        // Snapshots buffered for the writer thread, further ones are dropped
+};
+
+// Streams every snapshot it is given into rotating output files on its own thread. The sampler only
+// serializes the snapshot into a preallocated buffer and hands it over through a lock-free queue, so a slow
+// disk never holds it up: when the writer falls behind by more than queueCapacity snapshots, new ones are
+// dropped and counted. The writer formats records into a block and writes it with one write() once it
+// reaches batchBytes or flushSeconds have passed.
+class SinkWriter {
+public:
+    explicit SinkWriter(const SinkConfig& config);
+    ~SinkWriter(); // Writes every queued snapshot before returning
+
+    SinkWriter(const SinkWriter&) = delete;
+    SinkWriter& operator=(const SinkWriter&) = delete;
+
+    // Starts the writer thread for snapshots of the given schema. Returns false for an unknown format.
+    bool start(const SnapshotSchema& schema);
+    void stop();
+
+    // Queues a snapshot. Lock-free and allocation-free, called from the sampling thread.
+    void submit(const SystemInfoData& data);
+
+    // Waits until every snapshot queued so far has been written out
+    void flush();
+
+    const SinkConfig& getConfig() const;
+    unsigned long long getWrittenCount() const;
+    unsigned long long getDroppedCount() const; // Queue full or write failed
+
+private:
+    void writerLoop();
+    size_t drainQueue(); // Formats queued snapshots into batch_ until it holds a block, returns how many
+    void writeBatch();
+    bool openFile();
+    void closeFile();
+
+    SinkConfig config_;
+    SnapshotSchema schema_;
+    std::unique_ptr<SnapshotSink> sink_;
+    std::string fileHeader_;
+
+    // Serialized snapshots cycle from freeBuffers_ (sampler) to filledBuffers_ (writer) and back
+    BoundedQueue<std::vector<char> > freeBuffers_;
+    BoundedQueue<std::vector<char> > filledBuffers_;
+    std::atomic<unsigned long long> submittedCount_; // Queued for the writer
+    std::atomic<unsigned long long> writtenCount_;
+    std::atomic<unsigned long long> failedCount_;    // Queued, but their write failed
+    std::atomic<unsigned long long> queueFullCount_; // Never queued because the queue was full
+
+    std::thread thread_;
+    std::atomic<bool> running_;
+    std::atomic<bool> flushRequested_;
+    std::mutex wakeMutex_; // Only used to park the idle writer thread
+    std::condition_variable wakeCondition_;
+
+    // Owned by the writer thread
+    std::string batch_;
+    unsigned long long batchRecords_;
+    long long lastWriteNs_;
+    int fd_;
+    long long fileBytes_;
+    long long fileOpenedNs_;
+};
+
+#endif // SINK_WRITER_H
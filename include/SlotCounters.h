@@ -0,0 +1,52 @@
+#ifndef SLOT_COUNTERS_H
+#define SLOT_COUNTERS_H
+
+#include <cstddef>
+#include <vector>
+#include "CounterMatrix.h"
+
+// Counter history of a fixed number of slots (network interfaces, block devices, processes) in one CounterMatrix,
+// one row per slot, with the same averaging windows as the CPU collector and enough samples for the longest one.
+// A slot can change hands, so each slot is only compared with the samples taken since it got its current owner.
+class SlotCounters {
+public:
+    SlotCounters();
+
+    // Allocates the history for the given sampling period and the configured windows, dropping every sample
+    void init(size_t numColumns, size_t numSlots, unsigned long long jiffiesPerSecond, unsigned long long periodJiffies);
+    // Applies a new sampling period and the configured windows, keeping the history that still fits. Returns false
+    // if the windows were kept because their number changed, which needs a restart.
+    bool reconfigure(unsigned long long periodJiffies);
+
+    // Jiffies of the sample being taken, from ProcCapture so a replay uses the recorded times
+    unsigned long long getCurrentJiffy() const;
+    unsigned long long getJiffiesPerSecond() const;
+
+    // Window 0 is average_period_jiffies
+    size_t getNumWindows() const;
+    size_t getNumSlots() const;
+
+    // Writable rows of a column in the pending sample, clearPending() zeroes every column first
+    unsigned long long* getPendingColumn(size_t column);
+    void clearPending();
+    void commit(unsigned long long jiffies);
+
+    // Start of a window in the history, the same for every slot
+    size_t findWindowStart(size_t window) const;
+
+    // How much each counter of a slot grew from windowStart, or from the first sample at firstJiffies if the slot
+    // got its owner later, to the newest sample. False if there is no older sample of the owner yet or a counter
+    // went backwards, as counters restart from zero when a device is recreated under the same name.
+    bool getDeltas(size_t windowStart, size_t slot, unsigned long long firstJiffies, unsigned long long* deltas,
+                   unsigned long long& jiffiesPassed) const;
+
+private:
+    size_t getHistorySize() const; // Samples needed for the longest window at the current period
+
+    CounterMatrix counters_;
+    std::vector<unsigned long long> windowsJiffies_;
+    unsigned long long jiffiesPerSecond_;
+    unsigned long long periodJiffies_;
+};
+
+#endif // SLOT_COUNTERS_H
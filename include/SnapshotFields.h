@@ -0,0 +1,177 @@
+#ifndef SNAPSHOT_FIELDS_H
+#define SNAPSHOT_FIELDS_H
+
+#include "SystemInfoData.h"
+
+// Name of one metric of a snapshot, kept as pieces so that visiting a snapshot never builds strings.
+// The full name is "group[index][subIndex].name", leaving out negative indices, e.g. "cpu.core[3].usage_percent".
+struct SnapshotFieldName {
+    const char* group;
+    int index;
+    int subIndex;
+    const char* name;
+};
+
+template<typename Visitor>
+void visitPressureFields(const char* group, const PressureInfo& pressure, Visitor& visitor) {
+    visitor.visitDouble(SnapshotFieldName{ group, -1, -1, "some_avg10" }, pressure.some_avg10);
+    visitor.visitDouble(SnapshotFieldName{ group, -1, -1, "some_avg60" }, pressure.some_avg60);
+    visitor.visitDouble(SnapshotFieldName{ group, -1, -1, "some_avg300" }, pressure.some_avg300);
+    visitor.visitInt(SnapshotFieldName{ group, -1, -1, "some_total_us" }, pressure.some_total_us);
+    visitor.visitDouble(SnapshotFieldName{ group, -1, -1, "some_stall_percent" }, pressure.some_stall_percent);
+    visitor.visitDouble(SnapshotFieldName{ group, -1, -1, "full_avg10" }, pressure.full_avg10);
+    visitor.visitDouble(SnapshotFieldName{ group, -1, -1, "full_avg60" }, pressure.full_avg60);
+    visitor.visitDouble(SnapshotFieldName{ group, -1, -1, "full_avg300" }, pressure.full_avg300);
+    visitor.visitInt(SnapshotFieldName{ group, -1, -1, "full_total_us" }, pressure.full_total_us);
+    visitor.visitDouble(SnapshotFieldName{ group, -1, -1, "full_stall_percent" }, pressure.full_stall_percent);
+    visitor.visitDouble(SnapshotFieldName{ group, -1, -1, "real_time_step" }, pressure.real_time_step);
+    visitor.visitInt(SnapshotFieldName{ group, -1, -1, "trigger_events" }, static_cast<long long>(pressure.trigger_events));
+}
+
+// Calls visitor.visitInt(name, long long) or visitor.visitDouble(name, double) for every metric of a
+// snapshot, always in the same order. This order is the binary layout of SnapshotSchema: metrics may only be
+// appended at the end, anything else needs a new SnapshotSchema::VERSION.
+template<typename Visitor>
+void forEachSnapshotField(const SystemInfoData& data, Visitor& visitor) {
+    visitor.visitInt(SnapshotFieldName{ "snapshot", -1, -1, "time_stamp_ns" }, data.time_stamp_ns);
+    visitor.visitInt(SnapshotFieldName{ "snapshot", -1, -1, "sample_deadline_ns" }, data.sample_deadline_ns);
+    visitor.visitInt(SnapshotFieldName{ "snapshot", -1, -1, "sample_lateness_ns" }, data.sample_lateness_ns);
+    visitor.visitInt(SnapshotFieldName{ "snapshot", -1, -1, "missed_updates" }, static_cast<long long>(data.missed_updates));
+
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "total_ram" }, data.total_ram);
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "free_ram" }, data.free_ram);
+    const MemoryInfo& memory = data.memory;
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "total_bytes" }, static_cast<long long>(memory.total_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "free_bytes" }, static_cast<long long>(memory.free_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "available_bytes" }, static_cast<long long>(memory.available_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "used_bytes" }, static_cast<long long>(memory.used_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "buffers_bytes" }, static_cast<long long>(memory.buffers_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "cached_bytes" }, static_cast<long long>(memory.cached_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "shmem_bytes" }, static_cast<long long>(memory.shmem_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "slab_reclaimable_bytes" }, static_cast<long long>(memory.slab_reclaimable_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "dirty_bytes" }, static_cast<long long>(memory.dirty_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "writeback_bytes" }, static_cast<long long>(memory.writeback_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "committed_as_bytes" }, static_cast<long long>(memory.committed_as_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "swap_total_bytes" }, static_cast<long long>(memory.swap_total_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "swap_free_bytes" }, static_cast<long long>(memory.swap_free_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "swap_used_bytes" }, static_cast<long long>(memory.swap_used_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "swap_cached_bytes" }, static_cast<long long>(memory.swap_cached_bytes));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "huge_pages_total" }, static_cast<long long>(memory.huge_pages_total));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "huge_pages_free" }, static_cast<long long>(memory.huge_pages_free));
+    visitor.visitInt(SnapshotFieldName{ "memory", -1, -1, "huge_page_size_bytes" }, static_cast<long long>(memory.huge_page_size_bytes));
+
+    visitor.visitDouble(SnapshotFieldName{ "load", -1, -1, "avg_1min" }, data.load_avg_1min);
+    visitor.visitDouble(SnapshotFieldName{ "load", -1, -1, "avg_5min" }, data.load_avg_5min);
+    visitor.visitDouble(SnapshotFieldName{ "load", -1, -1, "avg_15min" }, data.load_avg_15min);
+
+    visitor.visitInt(SnapshotFieldName{ "cpu", -1, -1, "num_processors" }, data.cpu_num_processors);
+    visitor.visitDouble(SnapshotFieldName{ "cpu", -1, -1, "usage_percent" }, data.cpu_usage_percent);
+    visitor.visitDouble(SnapshotFieldName{ "cpu", -1, -1, "real_time_step" }, data.cpu_real_time_step);
+    for (size_t core = 0; core < data.cpu_usage_percent_per_core.size(); ++core) {
+        visitor.visitDouble(SnapshotFieldName{ "cpu.core", static_cast<int>(core), -1, "usage_percent" }, data.cpu_usage_percent_per_core[core]);
+        visitor.visitDouble(SnapshotFieldName{ "cpu.core", static_cast<int>(core), -1, "real_time_step" }, data.cpu_real_time_step_per_core[core]);
+    }
+    size_t numCores = data.cpu_usage_percent_per_core.size();
+    for (size_t window = 0; window < data.cpu_window_jiffies.size(); ++window) {
+        visitor.visitInt(SnapshotFieldName{ "cpu.window", static_cast<int>(window), -1, "jiffies" }, static_cast<long long>(data.cpu_window_jiffies[window]));
+        visitor.visitDouble(SnapshotFieldName{ "cpu.window", static_cast<int>(window), -1, "usage_percent" }, data.cpu_usage_percent_per_window[window]);
+        visitor.visitDouble(SnapshotFieldName{ "cpu.window", static_cast<int>(window), -1, "real_time_step" }, data.cpu_real_time_step_per_window[window]);
+        for (size_t core = 0; core < numCores; ++core) {
+            visitor.visitDouble(SnapshotFieldName{ "cpu.window_core", static_cast<int>(window), static_cast<int>(core), "usage_percent" },
+                                data.cpu_usage_percent_per_window_per_core[window * numCores + core]);
+        }
+    }
+
+    size_t numProcesses = data.processes.size();
+    for (size_t slot = 0; slot < numProcesses; ++slot) {
+        const ProcessInfo& process = data.processes[slot];
+        visitor.visitInt(SnapshotFieldName{ "process", static_cast<int>(slot), -1, "pid" }, process.pid);
+        visitor.visitDouble(SnapshotFieldName{ "process", static_cast<int>(slot), -1, "cpu_usage_percent" }, process.cpu_usage_percent);
+        visitor.visitDouble(SnapshotFieldName{ "process", static_cast<int>(slot), -1, "cpu_real_time_step" }, process.cpu_real_time_step);
+        visitor.visitInt(SnapshotFieldName{ "process", static_cast<int>(slot), -1, "rss_bytes" }, process.rss_bytes);
+        visitor.visitInt(SnapshotFieldName{ "process", static_cast<int>(slot), -1, "num_threads" }, process.num_threads);
+    }
+    for (size_t window = 0; window < data.cpu_window_jiffies.size() && numProcesses > 0; ++window) {
+        for (size_t slot = 0; slot < numProcesses; ++slot) {
+            visitor.visitDouble(SnapshotFieldName{ "process.window", static_cast<int>(window), static_cast<int>(slot), "cpu_usage_percent" },
+                                data.process_cpu_usage_percent_per_window[window * numProcesses + slot]);
+        }
+    }
+
+    // Grouped by collector name, e.g. "memory.source_period_ns"
+    for (const SourceFreshness& freshness : data.source_freshness) {
+        visitor.visitInt(SnapshotFieldName{ freshness.name, -1, -1, "source_time_stamp_ns" }, freshness.time_stamp_ns);
+        visitor.visitInt(SnapshotFieldName{ freshness.name, -1, -1, "source_period_ns" }, freshness.period_ns);
+    }
+
+    const MonitorStats& monitor = data.monitor;
+    visitor.visitInt(SnapshotFieldName{ "monitor", -1, -1, "samples" }, static_cast<long long>(monitor.samples));
+    visitor.visitInt(SnapshotFieldName{ "monitor", -1, -1, "collect_ns" }, monitor.collect_ns);
+    visitor.visitInt(SnapshotFieldName{ "monitor", -1, -1, "collect_p50_ns" }, monitor.collect_p50_ns);
+    visitor.visitInt(SnapshotFieldName{ "monitor", -1, -1, "collect_p99_ns" }, monitor.collect_p99_ns);
+    visitor.visitInt(SnapshotFieldName{ "monitor", -1, -1, "collect_max_ns" }, monitor.collect_max_ns);
+    visitor.visitInt(SnapshotFieldName{ "monitor", -1, -1, "publish_lock_ns" }, monitor.publish_lock_ns);
+    visitor.visitInt(SnapshotFieldName{ "monitor", -1, -1, "publish_lock_p50_ns" }, monitor.publish_lock_p50_ns);
+    visitor.visitInt(SnapshotFieldName{ "monitor", -1, -1, "publish_lock_p99_ns" }, monitor.publish_lock_p99_ns);
+    visitor.visitInt(SnapshotFieldName{ "monitor", -1, -1, "publish_lock_max_ns" }, monitor.publish_lock_max_ns);
+    visitor.visitInt(SnapshotFieldName{ "monitor", -1, -1, "wakeup_lateness_p50_ns" }, monitor.wakeup_lateness_p50_ns);
+    visitor.visitInt(SnapshotFieldName{ "monitor", -1, -1, "wakeup_lateness_p99_ns" }, monitor.wakeup_lateness_p99_ns);
+    visitor.visitInt(SnapshotFieldName{ "monitor", -1, -1, "wakeup_lateness_max_ns" }, monitor.wakeup_lateness_max_ns);
+    visitor.visitInt(SnapshotFieldName{ "monitor", -1, -1, "wakeup_jitter_ns" }, monitor.wakeup_jitter_ns);
+    visitor.visitInt(SnapshotFieldName{ "monitor", -1, -1, "cpu_time_ns" }, monitor.cpu_time_ns);
+    visitor.visitDouble(SnapshotFieldName{ "monitor", -1, -1, "cpu_overhead_percent" }, monitor.cpu_overhead_percent);
+
+    // Slots are numbered, the interface name of each slot is in SystemInfoData::network_interfaces
+    size_t numInterfaces = data.network_interfaces.size();
+    for (size_t slot = 0; slot < numInterfaces; ++slot) {
+        const NetworkInterfaceInfo& interface = data.network_interfaces[slot];
+        int index = static_cast<int>(slot);
+        visitor.visitDouble(SnapshotFieldName{ "network.interface", index, -1, "rx_bytes_per_second" }, interface.rx_bytes_per_second);
+        visitor.visitDouble(SnapshotFieldName{ "network.interface", index, -1, "rx_packets_per_second" }, interface.rx_packets_per_second);
+        visitor.visitDouble(SnapshotFieldName{ "network.interface", index, -1, "rx_errors_per_second" }, interface.rx_errors_per_second);
+        visitor.visitDouble(SnapshotFieldName{ "network.interface", index, -1, "rx_dropped_per_second" }, interface.rx_dropped_per_second);
+        visitor.visitDouble(SnapshotFieldName{ "network.interface", index, -1, "tx_bytes_per_second" }, interface.tx_bytes_per_second);
+        visitor.visitDouble(SnapshotFieldName{ "network.interface", index, -1, "tx_packets_per_second" }, interface.tx_packets_per_second);
+        visitor.visitDouble(SnapshotFieldName{ "network.interface", index, -1, "tx_errors_per_second" }, interface.tx_errors_per_second);
+        visitor.visitDouble(SnapshotFieldName{ "network.interface", index, -1, "tx_dropped_per_second" }, interface.tx_dropped_per_second);
+        visitor.visitDouble(SnapshotFieldName{ "network.interface", index, -1, "real_time_step" }, interface.real_time_step);
+    }
+    for (size_t window = 0; window < data.cpu_window_jiffies.size() && numInterfaces > 0; ++window) {
+        for (size_t slot = 0; slot < numInterfaces; ++slot) {
+            visitor.visitDouble(SnapshotFieldName{ "network.window", static_cast<int>(window), static_cast<int>(slot), "rx_bytes_per_second" },
+                                data.network_rx_bytes_per_second_per_window[window * numInterfaces + slot]);
+            visitor.visitDouble(SnapshotFieldName{ "network.window", static_cast<int>(window), static_cast<int>(slot), "tx_bytes_per_second" },
+                                data.network_tx_bytes_per_second_per_window[window * numInterfaces + slot]);
+        }
+    }
+
+    // Slots are numbered, the device name of each slot is in SystemInfoData::disk_devices
+    size_t numDevices = data.disk_devices.size();
+    for (size_t slot = 0; slot < numDevices; ++slot) {
+        const DiskDeviceInfo& device = data.disk_devices[slot];
+        int index = static_cast<int>(slot);
+        visitor.visitDouble(SnapshotFieldName{ "disk.device", index, -1, "read_iops" }, device.read_iops);
+        visitor.visitDouble(SnapshotFieldName{ "disk.device", index, -1, "write_iops" }, device.write_iops);
+        visitor.visitDouble(SnapshotFieldName{ "disk.device", index, -1, "read_bytes_per_second" }, device.read_bytes_per_second);
+        visitor.visitDouble(SnapshotFieldName{ "disk.device", index, -1, "write_bytes_per_second" }, device.write_bytes_per_second);
+        visitor.visitDouble(SnapshotFieldName{ "disk.device", index, -1, "await_ms" }, device.await_ms);
+        visitor.visitDouble(SnapshotFieldName{ "disk.device", index, -1, "queue_depth" }, device.queue_depth);
+        visitor.visitDouble(SnapshotFieldName{ "disk.device", index, -1, "utilization_percent" }, device.utilization_percent);
+        visitor.visitInt(SnapshotFieldName{ "disk.device", index, -1, "in_flight" }, device.in_flight);
+        visitor.visitDouble(SnapshotFieldName{ "disk.device", index, -1, "real_time_step" }, device.real_time_step);
+    }
+    for (size_t window = 0; window < data.cpu_window_jiffies.size() && numDevices > 0; ++window) {
+        for (size_t slot = 0; slot < numDevices; ++slot) {
+            visitor.visitDouble(SnapshotFieldName{ "disk.window", static_cast<int>(window), static_cast<int>(slot), "utilization_percent" },
+                                data.disk_utilization_percent_per_window[window * numDevices + slot]);
+            visitor.visitDouble(SnapshotFieldName{ "disk.window", static_cast<int>(window), static_cast<int>(slot), "await_ms" },
+                                data.disk_await_ms_per_window[window * numDevices + slot]);
+        }
+    }
+
+    visitPressureFields("pressure.cpu", data.pressure_cpu, visitor);
+    visitPressureFields("pressure.memory", data.pressure_memory, visitor);
+    visitPressureFields("pressure.io", data.pressure_io, visitor);
+}
+
+#endif // SNAPSHOT_FIELDS_H
@@ -0,0 +1,70 @@
+#ifndef SNAPSHOT_SCHEMA_H
+#define SNAPSHOT_SCHEMA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SystemInfoData.h"
+
+// Fixed header at the start of every serialized snapshot, all fields little endian as on the host
+struct SnapshotHeader {
+    uint32_t magic;       // SnapshotSchema::MAGIC
+    uint16_t version;     // SnapshotSchema::VERSION
+    uint16_t headerSize;  // sizeof(SnapshotHeader), the first field starts here
+    uint32_t numFields;
+    uint32_t totalSize;   // Header and fields, in bytes
+    uint64_t schemaHash;  // Hash of the field names, types and offsets, changes whenever the layout does
+};
+
+// Layout of a serialized snapshot: a SnapshotHeader followed by one 8-byte slot per metric, either a
+// 64-bit signed integer or a double. The layout is fixed for a given snapshot shape (cores, windows,
+// processes and sources), so a frontend looks up the offset of each metric once by name instead of
+// hard-coding indices, and checks schemaHash to notice when the layout changed.
+class SnapshotSchema {
+public:
+    enum FieldType : uint32_t {
+        INT64 = 1,
+        DOUBLE = 2
+    };
+
+    struct Field {
+        std::string name; // e.g. "memory.available_bytes", "cpu.core[3].usage_percent"
+        FieldType type;
+        uint32_t offset;  // Byte offset from the start of the buffer
+    };
+
+    static const uint32_t MAGIC;
+    static const uint16_t VERSION;
+
+    SnapshotSchema();
+
+    // Lays out every metric of a snapshot of the given shape
+    void build(const SystemInfoData& shape);
+
+    size_t getSize() const; // Bytes needed to serialize one snapshot
+    uint64_t getHash() const;
+    const std::vector<Field>& getFields() const;
+    const Field* findField(const std::string& name) const; // nullptr if there is no such metric
+
+    // Serializes data into buffer without allocating. Returns the bytes written, or 0 if the buffer is
+    // smaller than getSize() or data does not have the shape the schema was built for.
+    size_t write(const SystemInfoData& data, void* buffer, size_t capacity) const;
+
+    // Schema as JSON ({"version", "hash", "size", "fields": [{"name", "type", "offset"}]}), e.g. for the ODB
+    std::string toJson() const;
+
+    // Rebuilds a schema from toJson() output, e.g. one published by another process. Returns false, leaving
+    // the schema unchanged, if the JSON is malformed, of another VERSION, does not match its own hash or lays the
+    // fields out other than build() does, so a reader never copies from outside the snapshot.
+    bool loadJson(const std::string& schemaJson);
+
+private:
+    static uint64_t computeHash(const std::vector<Field>& fields);
+
+    std::vector<Field> fields_;
+    size_t size_;
+    uint64_t hash_;
+};
+
+#endif // SNAPSHOT_SCHEMA_H
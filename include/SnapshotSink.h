@@ -0,0 +1,61 @@
+#ifndef SNAPSHOT_SINK_H
+#define SNAPSHOT_SINK_H
+
+#include <memory>
+#include <string>
+#include "SnapshotSchema.h"
+
+// Output format of a SinkWriter. A sink turns serialized snapshots (the SnapshotSchema layout) into bytes
+// appended to an output file, so formatting runs on the sink's thread and never on the sampler's.
+class SnapshotSink {
+public:
+    virtual ~SnapshotSink() {}
+
+    virtual const char* getExtension() const = 0; // File extension, without the dot
+
+    // Appends what every output file starts with, e.g. the CSV column names
+    virtual void formatFileHeader(const SnapshotSchema& schema, std::string& out) const = 0;
+
+    // Appends one serialized snapshot of the given schema
+    virtual void formatRecord(const SnapshotSchema& schema, const char* snapshot, std::string& out) const = 0;
+
+    // "csv", "jsonl" or "binary", nullptr for any other format
+    static std::unique_ptr<SnapshotSink> create(const std::string& format);
+};
+
+// One line per snapshot, with a header line of metric names
+class CsvSink : public SnapshotSink {
+public:
+    const char* getExtension() const override;
+    void formatFileHeader(const SnapshotSchema& schema, std::string& out) const override;
+    void formatRecord(const SnapshotSchema& schema, const char* snapshot, std::string& out) const override;
+};
+
+// One JSON object per line, keyed by metric name. Non-finite values are written as null.
+class JsonLinesSink : public SnapshotSink {
+public:
+    const char* getExtension() const override;
+    void formatFileHeader(const SnapshotSchema& schema, std::string& out) const override;
+    void formatRecord(const SnapshotSchema& schema, const char* snapshot, std::string& out) const override;
+};
+
+// A BinarySinkHeader and the schema JSON, then every snapshot exactly as SnapshotSchema::write() lays it out
+class BinarySink : public SnapshotSink {
+public:
+    static const uint32_t MAGIC;
+    static const uint16_t VERSION;
+
+    const char* getExtension() const override;
+    void formatFileHeader(const SnapshotSchema& schema, std::string& out) const override;
+    void formatRecord(const SnapshotSchema& schema, const char* snapshot, std::string& out) const override;
+};
+
+struct BinarySinkHeader {
+    uint32_t magic;      // BinarySink::MAGIC
+    uint16_t version;    // BinarySink::VERSION
+    uint16_t headerSize; // sizeof(BinarySinkHeader), the schema JSON starts here
+    uint32_t schemaSize; // Length of the schema JSON, the first record follows it
+    uint32_t recordSize; // SnapshotSchema::getSize(), every record has this size
+};
+
+#endif // SNAPSHOT_SINK_H
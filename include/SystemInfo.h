@@ -8,85 +8,110 @@
 #include <vector>
 #include <map>
 #include <atomic>
-#include "CpuUsageCalculator.h"
-
-struct SystemInfoData {
-    long total_ram;
-    long free_ram;
-    long total_ram_MB;
-    long free_ram_MB;
-    double cpu_usage_percent;
-    int cpu_num_processors;
-    double cpu_real_time_step;
-    std::vector<double> cpu_usage_percent_per_core;
-    std::vector<double> cpu_real_time_step_per_core;
-    double load_avg_1min;
-    double load_avg_5min;
-    double load_avg_15min;
-    double time_stamp_ns;
-};
+#include "SystemInfoData.h"
+#include "CollectorScheduler.h"
+#include "CpuCollector.h"
+#include "MemoryCollector.h"
+#include "LoadAverageCollector.h"
+#include "ProcessMonitor.h"
+#include "NetworkCollector.h"
+#include "DiskCollector.h"
+#include "PressureCollector.h"
+#include "SeqLock.h"
+#include "SnapshotSchema.h"
+#include "SharedSnapshotRing.h"
+#include "HistoryStore.h"
+#include "MetricArchive.h"
+#include "SinkWriter.h"
+#include <memory>
+#include "DeadlineTimer.h"
+#include "LatencyHistogram.h"
+#include "ConfigWatcher.h"
 
 class SystemInfo {
 public:
     static SystemInfo& getInstance(); // Singleton access method
     ~SystemInfo(); // Destructor to close the file
 
-    void updateSystemInfo(); // Method to update system information
+    void updateSystemInfo(); // Method to update system information if an update period has passed since the last update
+
+    //Public Getters (thread safe and lock-free), get all information in on struct (SystemInfoData)
+    SystemInfoData collectSystemInfo() const;
+    void collectSystemInfo(SystemInfoData& data) const; // Reuses the storage of data, no allocations once sized
+    std::vector<double> packageSystemInfoForMIDAS() const; // Legacy layout, allocates on every call
+    static std::vector<double> packageSystemInfoForMIDAS(const SystemInfoData& data); // Same layout for a given snapshot
 
-    //Public Getters (thread safe), get all information in on struct (SystemInfoData)
-    SystemInfoData collectSystemInfo();
-    std::vector<double> packageSystemInfoForMIDAS();
+    // Serializes the latest snapshot into a caller-provided buffer (e.g. a MIDAS bank) in the layout described by
+    // getSnapshotSchema(). Lock-free and allocation-free. Returns the bytes written, 0 if the buffer is too small.
+    size_t writeSnapshot(void* buffer, size_t capacity) const;
+    const SnapshotSchema& getSnapshotSchema() const; // Fixed once SystemInfo is constructed
+
+    // Compressed history of every metric when system_info.history is enabled, queried by schema field name
+    const HistoryStore& getHistory() const;
 
     void startPeriodicUpdates();
-    void stopPeriodicUpdates();
+    void stopPeriodicUpdates(); // Also waits for the output sinks to write every snapshot taken so far
 
 private:
     SystemInfo(); // Private constructor
 
-    //Private Getters (not thread safe)
-    double getCpuUsage() const;
-    double getTimeStep() const;
-    double getCpuUsageForCore(int core) const;
-    double getTimeStepForCore(int core) const;
-    double getTotalRamMB() const;
-    double getFreeRamMB() const;
-    double getUsedRamMB() const;
-    double getTotalRam() const;
-    double getFreeRam() const;
-    double getUsedRam() const;
-    double getLoadAvg1Min() const;
-    double getLoadAvg5Min() const;
-    double getLoadAvg15Min() const;
-    int getNumCores() const;
-    double getLastUpdateTimestampNanos() const; 
-
-    void initCpuUsage(); // Initialize CPU usage
-    void initNumCores(); // Private method to initialize the number of CPU cores
-    void setCpuUsageResult(); //Private method to set CPU Usage statistics using CpuUsageCalculator
-    void addDataPointToBuffer(); //Private method to add a data point to the buffer without computing usage results
     void initializeJiffiesInformation(); //Private method to grab system's definition of a jiffy
+    void initCollectors(); //Private method to register every collector with its configured period
+    void initSnapshots(); //Private method to size the snapshot buffers once the number of cores is known
+    void publishSnapshot(); //Private method to make the building snapshot visible to readers and hand it to the ring, history, archive and sinks
+    void publishToReaders(); //Private method to only make the building snapshot visible to collectSystemInfo() and writeSnapshot()
     unsigned long long getCurrentJiffy(); //Calculates the current jiffy from system information.
+    long long getNanosPerJiffy() const;
+    void sampleSystemInfo(const TickInfo& tick, long long timeStampNs); //Private method to run the collectors due at the given tick
+    void sampleSystemInfoLocked(const TickInfo& tick, long long timeStampNs); //Same, for callers that hold updateMutex_
+    void updateMonitorStats(long long collectNs, long long latenessNs); //Private method to report the monitor's own cost in the building snapshot
+    void applyReloadedConfig(); //Private method to apply a config file the watcher reloaded, between two samples
+    void samplePressureEvent(unsigned long long triggerEvents, long long timeStampNs); //Private method to sample pressure right after a trigger fired
 
     void periodicUpdate();
+    void replayUpdates(); //Private method to run the ticks of a replayed capture in place of the timer
     std::thread updateThread_;
-    std::atomic<bool> running_;
-    std::mutex updateMutex_;
+    std::atomic<bool> running_{false};
+    std::mutex updateMutex_; // Serializes writers (the update thread and direct updateSystemInfo() calls), never taken by readers
 
-    std::ifstream statFile_; // File stream for /proc/stat
-    unsigned long long lastTotalUser_, lastTotalUserLow_, lastTotalSys_, lastTotalIdle_;
-    std::string cpuLabel_;
-    double uptime_, totalRam_, freeRam_, usedRam_, loadAvg1Min_, loadAvg5Min_, loadAvg15Min_;
-    int numCores_; // Number of CPU cores
-    std::map<int, CpuUsageResult> coreUsageResults_; // Map to store CPU usage results for each core (total usage stored at -1)
+    // Sources of system information, each sampled at its own period by scheduler_
+    CollectorScheduler scheduler_;
+    CpuCollector cpuCollector_;
+    MemoryCollector memoryCollector_;
+    LoadAverageCollector loadAverageCollector_;
+    ProcessMonitor processMonitor_;
+    NetworkCollector networkCollector_;
+    DiskCollector diskCollector_;
+    PressureCollector pressureCollector_;
 
     unsigned long long jiffiesPerSecond_; //System jiffies per second
-    unsigned long long updatePeriodJiffies_; //Number of jiffies per CPU sample
-    unsigned long long averagePeriodJiffies_; //Number of jiffies average over to compute CPU usage statistics
+    unsigned long long updatePeriodJiffies_; //Number of jiffies per scheduler tick (the GCD of the collector periods)
     unsigned long long lastUpdateJiffies_ = 0; //Number of jiffies before last update, intially zero
+    TickInfo lastTick_ = {0, 0, 0}; //Deadline and lateness of the last sample
+    unsigned long long missedUpdates_ = 0; //Deadlines skipped since the updates started
+    DeadlineTimer::OverrunPolicy overrunPolicy_; //Policy of the update timer, may change on a config reload
+    ConfigWatcher configWatcher_; //Reloads the config file on changes when system_info.hot_reload is enabled
+
+    // Self-instrumentation, reported in SystemInfoData::monitor. Only touched by the writer under updateMutex_.
+    LatencyHistogram collectHistogram_; //Time the collectors take per sample
+    LatencyHistogram publishLockHistogram_; //Time the seqlock is held per sample
+    LatencyHistogram latenessHistogram_; //Lateness of every sample against its deadline
+    long long lastPublishLockNs_ = 0;
+    long long monitorCpuNs_ = 0; //Thread CPU time of every sample so far
+    long long firstSampleNs_ = 0; //CLOCK_MONOTONIC start of the first sample, 0 before it
+    unsigned long long samples_ = 0;
 
     static SystemInfo* instance_; // Singleton instance
     static std::mutex mutex_; // Mutex for thread safety
-    mutable std::mutex dataMutex_;  // Mutex for synchronizing access to member variables
 
-    std::chrono::time_point<std::chrono::high_resolution_clock> lastUpdate_; //Unix timestamp
+    // Snapshot publication: the writer assembles buildingSnapshot_ without holding anything readers
+    // use, then copies it into publishedSnapshot_ under the seqlock. Both have a fixed shape after initSnapshots().
+    SystemInfoData buildingSnapshot_;
+    SystemInfoData publishedSnapshot_;
+    SeqLock snapshotLock_;
+    SnapshotSchema snapshotSchema_;
+    SharedSnapshotRing sharedRing_; // Every published snapshot is also copied here when system_info.shared_memory is enabled
+    HistoryStore history_;
+    MetricArchive archive_; // On-disk round-robin archive when system_info.archive is enabled
+    std::vector<std::unique_ptr<SinkWriter> > sinks_; // Output files of system_info.sinks, each written on its own thread
 };
@@ -0,0 +1,156 @@
+#ifndef SYSTEM_INFO_DATA_H
+#define SYSTEM_INFO_DATA_H
+
+#include <vector>
+
+// When a source was last sampled
+struct SourceFreshness {
+    const char* name;        // Collector name, as used under system_info.collectors in the config
+    long long time_stamp_ns; // Unix time of the source's latest sample, 0 if it was never sampled
+    long long period_ns;     // Configured sampling period of the source
+};
+
+// Memory breakdown from /proc/meminfo, in bytes unless noted
+struct MemoryInfo {
+    unsigned long long total_bytes;            // MemTotal
+    unsigned long long free_bytes;             // MemFree, excludes page cache and buffers
+    unsigned long long available_bytes;        // MemAvailable, what can be allocated without swapping
+    unsigned long long used_bytes;             // total_bytes - available_bytes
+    unsigned long long buffers_bytes;          // Buffers
+    unsigned long long cached_bytes;           // Cached
+    unsigned long long shmem_bytes;            // Shmem, counted in Cached but not reclaimable
+    unsigned long long slab_reclaimable_bytes; // SReclaimable
+    unsigned long long dirty_bytes;            // Dirty, waiting to be written back
+    unsigned long long writeback_bytes;        // Writeback, being written back
+    unsigned long long committed_as_bytes;     // Committed_AS
+    unsigned long long swap_total_bytes;       // SwapTotal
+    unsigned long long swap_free_bytes;        // SwapFree
+    unsigned long long swap_used_bytes;        // swap_total_bytes - swap_free_bytes
+    unsigned long long swap_cached_bytes;      // SwapCached
+    unsigned long long huge_pages_total;       // HugePages_Total, in pages
+    unsigned long long huge_pages_free;        // HugePages_Free, in pages
+    unsigned long long huge_page_size_bytes;   // Hugepagesize
+};
+
+// One watched process. Plain data with a fixed-size name, so copying snapshots never allocates.
+struct ProcessInfo {
+    int pid;                   // 0 if the slot is not watching a process
+    char name[16];             // Command name from /proc/<pid>/comm, null terminated
+    double cpu_usage_percent;  // Over average_period_jiffies, 100% per fully used core, -1 until two samples exist
+    double cpu_real_time_step; // Time the usage actually covers
+    long long rss_bytes;       // Resident set size
+    int num_threads;
+};
+
+// One network interface from /proc/net/dev. Rates are per second over average_period_jiffies, -1 until two samples
+// exist. Plain data with a fixed-size name, so copying snapshots never allocates.
+struct NetworkInterfaceInfo {
+    char name[16];                // Interface name, null terminated, empty if the slot is not used
+    double rx_bytes_per_second;
+    double rx_packets_per_second;
+    double rx_errors_per_second;
+    double rx_dropped_per_second;
+    double tx_bytes_per_second;
+    double tx_packets_per_second;
+    double tx_errors_per_second;
+    double tx_dropped_per_second;
+    double real_time_step;        // Time the rates actually cover
+};
+
+// One block device from /proc/diskstats. Values are over average_period_jiffies, -1 until two samples exist.
+// Plain data with a fixed-size name, so copying snapshots never allocates.
+struct DiskDeviceInfo {
+    char name[32];                  // Device name, null terminated, empty if the slot is not used
+    double read_iops;               // Completed reads per second
+    double write_iops;              // Completed writes per second
+    double read_bytes_per_second;
+    double write_bytes_per_second;
+    double await_ms;                // Average time a completed request took, queueing included, 0 without requests
+    double queue_depth;             // Average number of requests in flight (aqu-sz)
+    double utilization_percent;     // Share of the time the device was busy
+    long long in_flight;            // Requests in flight at the latest sample
+    double real_time_step;          // Time the values actually cover
+};
+
+// Pressure stall information of one resource from /proc/pressure/<resource>. "some" counts time in which at least
+// one task was stalled on the resource, "full" time in which every non-idle task was. The averages are the
+// kernel's over 10 s, 60 s and 300 s; the stall rates are the same share of time measured from the totals between
+// the latest two samples, so they follow the sampling period instead of the kernel's windows. Every value is -1 if
+// the kernel does not report it, and the stall rates until two samples exist.
+struct PressureInfo {
+    double some_avg10;              // Percent of time
+    double some_avg60;
+    double some_avg300;
+    long long some_total_us;        // Stall time since boot
+    double some_stall_percent;
+    double full_avg10;
+    double full_avg60;
+    double full_avg300;
+    long long full_total_us;
+    double full_stall_percent;
+    double real_time_step;          // Time the stall rates actually cover
+    unsigned long long trigger_events; // Configured triggers of this resource that fired since the start
+};
+
+// The monitor's own cost, measured by SystemInfo on every sample. Percentiles, maxima and the jitter come from
+// LatencyHistograms of every sample since the start, within about 3%.
+struct MonitorStats {
+    unsigned long long samples;         // Samples taken, including this one
+    long long collect_ns;               // Time the collectors took to read and parse their sources for this sample
+    long long collect_p50_ns;
+    long long collect_p99_ns;
+    long long collect_max_ns;
+    long long publish_lock_ns;          // Time the previous sample held the snapshot seqlock, readers retry meanwhile
+    long long publish_lock_p50_ns;
+    long long publish_lock_p99_ns;
+    long long publish_lock_max_ns;
+    long long wakeup_lateness_p50_ns;   // Lateness of the sample against its deadline, the latest is sample_lateness_ns
+    long long wakeup_lateness_p99_ns;
+    long long wakeup_lateness_max_ns;
+    long long wakeup_jitter_ns;         // Standard deviation of the lateness
+    long long cpu_time_ns;              // CLOCK_THREAD_CPUTIME_ID spent sampling and publishing, up to the previous sample
+    double cpu_overhead_percent;        // cpu_time_ns over the wall time since the first sample, 100% is one core
+};
+
+struct SystemInfoData {
+    long total_ram;
+    long free_ram;
+    long total_ram_MB;
+    long free_ram_MB;
+    MemoryInfo memory;
+    double cpu_usage_percent;
+    int cpu_num_processors;
+    double cpu_real_time_step;
+    std::vector<double> cpu_usage_percent_per_core;
+    std::vector<double> cpu_real_time_step_per_core;
+    std::vector<unsigned long long> cpu_window_jiffies; // CPU averaging windows, window 0 is average_period_jiffies (the fields above)
+    std::vector<double> cpu_usage_percent_per_window; // Total CPU usage over each window
+    std::vector<double> cpu_real_time_step_per_window; // Time each window actually covers, shorter until the history fills
+    std::vector<double> cpu_usage_percent_per_window_per_core; // Usage of core c over window w at [w * cpu_num_processors + c]
+    std::vector<ProcessInfo> processes; // One slot per watched process, system_info.processes.max_processes slots
+    std::vector<double> process_cpu_usage_percent_per_window; // Usage of slot s over cpu_window_jiffies[w] at [w * processes.size() + s]
+    double load_avg_1min;
+    double load_avg_5min;
+    double load_avg_15min;
+    PressureInfo pressure_cpu; // Pressure stall information, a finer measure of contention than the load averages
+    PressureInfo pressure_memory;
+    PressureInfo pressure_io;
+    long long time_stamp_ns; // Unix time of the latest sample
+    long long sample_deadline_ns; // CLOCK_MONOTONIC deadline the latest sample was scheduled for
+    long long sample_lateness_ns; // How late the latest sample started relative to its deadline
+    unsigned long long missed_updates; // Deadlines skipped since the updates started
+    std::vector<SourceFreshness> source_freshness; // One entry per collector
+    MonitorStats monitor; // Cost of the monitor itself
+    std::vector<NetworkInterfaceInfo> network_interfaces; // One slot per reported interface, system_info.network.max_interfaces slots
+    std::vector<double> network_rx_bytes_per_second_per_window; // Receive rate of slot s over cpu_window_jiffies[w] at [w * network_interfaces.size() + s]
+    std::vector<double> network_tx_bytes_per_second_per_window; // Transmit rate, same layout
+    std::vector<DiskDeviceInfo> disk_devices; // One slot per reported device, system_info.disks.max_devices slots
+    std::vector<double> disk_utilization_percent_per_window; // Utilization of slot s over cpu_window_jiffies[w] at [w * disk_devices.size() + s]
+    std::vector<double> disk_await_ms_per_window; // Await, same layout
+};
+
+// Copies a snapshot, reusing the storage of `to` so that copies between snapshots of the same
+// shape never allocate.
+void copySystemInfoData(const SystemInfoData& from, SystemInfoData& to);
+
+#endif // SYSTEM_INFO_DATA_H
@@ -0,0 +1,96 @@
+#include "CollectorScheduler.h"
+#include "Printer.h"
+
+static unsigned long long greatestCommonDivisor(unsigned long long a, unsigned long long b) {
+    while (b != 0) {
+        unsigned long long remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+CollectorScheduler::CollectorScheduler() : basePeriodJiffies_(0) {
+}
+
+void CollectorScheduler::addCollector(Collector* collector, unsigned long long periodJiffies) {
+    if (periodJiffies == 0) {
+        PRINT_WARNING(-1, std::string("Period of collector ") + collector->getName() + " cannot be zero, using 1 jiffy.");
+        periodJiffies = 1;
+    }
+
+    Entry entry = {collector, periodJiffies, 0, false};
+    entries_.push_back(entry);
+    basePeriodJiffies_ = greatestCommonDivisor(basePeriodJiffies_, periodJiffies);
+}
+
+void CollectorScheduler::setCollectorPeriod(Collector* collector, unsigned long long periodJiffies) {
+    if (periodJiffies == 0) {
+        PRINT_WARNING(-1, std::string("Period of collector ") + collector->getName() + " cannot be zero, using 1 jiffy.");
+        periodJiffies = 1;
+    }
+
+    basePeriodJiffies_ = 0;
+    for (Entry& entry : entries_) {
+        if (entry.collector == collector) {
+            entry.periodJiffies = periodJiffies;
+        }
+        basePeriodJiffies_ = greatestCommonDivisor(basePeriodJiffies_, entry.periodJiffies);
+    }
+}
+
+unsigned long long CollectorScheduler::getBasePeriodJiffies() const {
+    return basePeriodJiffies_;
+}
+
+void CollectorScheduler::initSnapshot(SystemInfoData& data, unsigned long long jiffiesPerSecond) {
+    data.source_freshness.resize(entries_.size());
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        entries_[i].collector->initSnapshot(data);
+
+        SourceFreshness& freshness = data.source_freshness[i];
+        freshness.name = entries_[i].collector->getName();
+        freshness.time_stamp_ns = 0;
+    }
+    writePeriods(data, jiffiesPerSecond);
+    data.monitor = MonitorStats(); // Filled in by SystemInfo on every sample
+}
+
+void CollectorScheduler::writePeriods(SystemInfoData& data, unsigned long long jiffiesPerSecond) const {
+    for (size_t i = 0; i < entries_.size() && i < data.source_freshness.size(); ++i) {
+        data.source_freshness[i].period_ns = static_cast<long long>(entries_[i].periodJiffies * 1000000000ULL / jiffiesPerSecond);
+    }
+}
+
+size_t CollectorScheduler::runDue(unsigned long long deadlineJiffies, long long timeStampNs, SystemInfoData& data) {
+    size_t collectorsRun = 0;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        Entry& entry = entries_[i];
+
+        // Deadlines sit on a fixed grid, so comparing them (rather than the actual wake-up times) never drifts
+        if (entry.hasRun && deadlineJiffies - entry.lastDeadlineJiffies < entry.periodJiffies) {
+            continue;
+        }
+
+        if (entry.collector->collect(data)) {
+            data.source_freshness[i].time_stamp_ns = timeStampNs;
+        }
+        entry.lastDeadlineJiffies = deadlineJiffies;
+        entry.hasRun = true;
+        ++collectorsRun;
+    }
+    return collectorsRun;
+}
+
+bool CollectorScheduler::runNow(Collector* collector, long long timeStampNs, SystemInfoData& data) {
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i].collector == collector) {
+            if (!collector->collect(data)) {
+                return false;
+            }
+            data.source_freshness[i].time_stamp_ns = timeStampNs;
+            return true;
+        }
+    }
+    return false;
+}
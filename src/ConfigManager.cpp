@@ -7,6 +7,7 @@
 #include <sstream>
 #include <cstdlib> // for getenv
 #include <string>
+#include <utility>
 #include <filesystem> // for filesystem utilities
 #include <sys/stat.h> // for stat
 
@@ -14,6 +15,26 @@ using json = nlohmann::json;
 
 ConfigManager* ConfigManager::instance = nullptr;
 
+// Sections that size buffers, open files or start threads at startup, so a reload cannot change them
+static const char* const RESTART_ONLY_SECTIONS[] = {
+    "printer.async",
+    "printer.queue_capacity",
+    "printer.overflow_policy",
+    "system_info.processes.pids",
+    "system_info.processes.names",
+    "system_info.processes.max_processes",
+    "system_info.network.max_interfaces",
+    "system_info.disks.max_devices",
+    "system_info.pressure.triggers",
+    "system_info.shared_memory",
+    "system_info.history",
+    "system_info.archive",
+    "system_info.sinks",
+    "system_info.procfs_root",
+    "system_info.capture",
+    "system_info.hot_reload",
+};
+
 ConfigManager& ConfigManager::getInstance(const std::string& configFile) {
     if (!instance) {
         instance = new ConfigManager(configFile);
@@ -21,64 +42,292 @@ ConfigManager& ConfigManager::getInstance(const std::string& configFile) {
     return *instance;
 }
 
-ConfigManager::ConfigManager(const std::string& configFile) {
+ConfigManager::ConfigManager(const std::string& configFile) : values_(nullptr) {
+    std::unique_ptr<Values> values(new Values());
     // Load the configuration file using JsonManager
     std::string configFilePath = getConfigFilePath(configFile); //Get or try to construct file path
     if (!configFilePath.empty() && std::ifstream(configFilePath).good()) { //If the file exists
         JsonManager& jsonManager = JsonManager::getInstance(configFilePath);
 
         // Access the configuration using JsonManager's getConfig() method
-        config = jsonManager.getConfig(); // Save the configuration
+        values->config = jsonManager.getConfig(); // Save the configuration
+        fileConfig = values->config;
+        this->configFilePath = configFilePath;
 
         // Read the config and assign variables
-        readConfig(config);
+        readConfig(*values);
     }
     else {
         if (debug) {
             std::cerr << "Warning: Invalid or missing configuration file: " << configFilePath << ". Using default configuration values." << std::endl;
         }
+        // Assign the default values
+        readConfig(*values);
     }
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    publish(std::move(values));
+}
+
+const ConfigManager::Values& ConfigManager::current() const {
+    return *values_.load(std::memory_order_acquire);
+}
+
+void ConfigManager::publish(std::unique_ptr<Values> values) {
+    valuesVersions_.push_back(std::move(values));
+    values_.store(valuesVersions_.back().get(), std::memory_order_release);
 }
 
 int ConfigManager::getVerbosity() const {
-    return verbosity;
+    return current().verbosity;
 }
 
 const json& ConfigManager::getConfig() const {
-    return config;
+    return current().config;
+}
+
+bool ConfigManager::applyConfig(const json& fileContents, std::vector<std::string>& ignoredSections) {
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    ignoredSections.clear();
+    std::unique_ptr<Values> values(new Values());
+    json& newConfig = values->config;
+    newConfig = fileContents;
+    for (const char* section : RESTART_ONLY_SECTIONS) {
+        const json* previousValue = findConfigNode(fileConfig, section);
+        const json* newValue = findConfigNode(fileContents, section);
+        if ((previousValue == nullptr) != (newValue == nullptr) || (previousValue && *previousValue != *newValue)) {
+            ignoredSections.push_back(section);
+        }
+        setConfigNode(newConfig, section, findConfigNode(current().config, section));
+    }
+    if (!checkPeriods(newConfig)) {
+        ignoredSections.clear();
+        return false;
+    }
+
+    fileConfig = fileContents;
+    readConfig(*values);
+    publish(std::move(values));
+    return true;
+}
+
+bool ConfigManager::checkPeriods(const nlohmann::json& config) const {
+    // Read the way readConfig() and getCollectorPeriodJiffies() will, so the values checked are the ones used
+    std::vector<std::pair<std::string, int> > periods;
+    int updatePeriod = getConfigValue<int>(config, "system_info.update_period_jiffies", DEFAULT_UPDATE_PERIOD_JIFFIES);
+    periods.push_back(std::make_pair("system_info.update_period_jiffies", updatePeriod));
+    periods.push_back(std::make_pair("system_info.average_period_jiffies", getConfigValue<int>(config, "system_info.average_period_jiffies", DEFAULT_AVERAGE_PERIOD_JIFFIES)));
+    std::vector<int> windows;
+    readConfigList(config, "system_info.average_windows_jiffies", windows);
+    for (int window : windows) {
+        periods.push_back(std::make_pair("system_info.average_windows_jiffies", window));
+    }
+    periods.push_back(std::make_pair("system_info.processes.rescan_period_jiffies", getConfigValue<int>(config, "system_info.processes.rescan_period_jiffies", DEFAULT_PROCESS_RESCAN_PERIOD_JIFFIES)));
+    const nlohmann::json* collectors = findConfigNode(config, "system_info.collectors");
+    if (collectors && collectors->is_object()) {
+        for (nlohmann::json::const_iterator collector = collectors->begin(); collector != collectors->end(); ++collector) {
+            std::string configPath = "system_info.collectors." + collector.key() + ".period_jiffies";
+            periods.push_back(std::make_pair(configPath, getConfigValue<int>(config, configPath, updatePeriod)));
+        }
+    }
+
+    for (const std::pair<std::string, int>& period : periods) {
+        if (period.second <= 0) {
+            PRINT_WARNING(-1, "Ignoring the reloaded configuration, " + period.first + " must be positive but is " + std::to_string(period.second) + ".");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ConfigManager::getHotReloadEnabled() const {
+    return current().hotReloadEnabled;
+}
+
+const std::string& ConfigManager::getConfigFile() const {
+    return configFilePath;
 }
 
 int ConfigManager::getAveragePeriodJiffies() const {
-    return averagePeriodJiffies;
+    return current().averagePeriodJiffies;
+}
+
+const std::vector<int>& ConfigManager::getAverageWindowsJiffies() const {
+    return current().averageWindowsJiffies;
+}
+
+const std::vector<int>& ConfigManager::getWatchedProcessPids() const {
+    return current().watchedProcessPids;
+}
+
+const std::vector<std::string>& ConfigManager::getWatchedProcessNames() const {
+    return current().watchedProcessNames;
+}
+
+int ConfigManager::getMaxWatchedProcesses() const {
+    return current().maxWatchedProcesses;
+}
+
+int ConfigManager::getProcessRescanPeriodJiffies() const {
+    return current().processRescanPeriodJiffies;
+}
+
+const std::vector<std::string>& ConfigManager::getNetworkInterfaces() const {
+    return current().networkInterfaces;
+}
+
+const std::vector<std::string>& ConfigManager::getExcludedNetworkInterfaces() const {
+    return current().excludedNetworkInterfaces;
+}
+
+int ConfigManager::getMaxNetworkInterfaces() const {
+    return current().maxNetworkInterfaces;
+}
+
+const std::vector<std::string>& ConfigManager::getDiskDevices() const {
+    return current().diskDevices;
+}
+
+const std::vector<std::string>& ConfigManager::getExcludedDiskDevices() const {
+    return current().excludedDiskDevices;
+}
+
+bool ConfigManager::getDiskPartitionsIncluded() const {
+    return current().diskPartitionsIncluded;
+}
+
+int ConfigManager::getMaxDiskDevices() const {
+    return current().maxDiskDevices;
+}
+
+const std::vector<PressureTriggerConfig>& ConfigManager::getPressureTriggers() const {
+    return current().pressureTriggers;
+}
+
+bool ConfigManager::getSharedMemoryEnabled() const {
+    return current().sharedMemoryEnabled;
+}
+
+const std::string& ConfigManager::getSharedMemoryName() const {
+    return current().sharedMemoryName;
+}
+
+int ConfigManager::getSharedMemorySlots() const {
+    return current().sharedMemorySlots;
+}
+
+bool ConfigManager::getHistoryEnabled() const {
+    return current().historyEnabled;
+}
+
+int ConfigManager::getHistoryMemoryBudgetBytes() const {
+    return current().historyMemoryBudgetBytes;
+}
+
+int ConfigManager::getHistoryBlockBytes() const {
+    return current().historyBlockBytes;
+}
+
+bool ConfigManager::getArchiveEnabled() const {
+    return current().archiveEnabled;
+}
+
+const std::string& ConfigManager::getArchivePath() const {
+    return current().archivePath;
+}
+
+const std::vector<ArchiveTierConfig>& ConfigManager::getArchiveTiers() const {
+    return current().archiveTiers;
+}
+
+const std::vector<SinkConfig>& ConfigManager::getSinks() const {
+    return current().sinks;
+}
+
+const std::string& ConfigManager::getProcfsRoot() const {
+    return current().procfsRoot;
+}
+
+std::string ConfigManager::getProcPath(const std::string& name) const {
+    return current().procfsRoot + "/" + name;
+}
+
+const std::string& ConfigManager::getCaptureMode() const {
+    return current().captureMode;
+}
+
+const std::string& ConfigManager::getCapturePath() const {
+    return current().capturePath;
+}
+
+double ConfigManager::getReplaySpeed() const {
+    return current().replaySpeed;
 }
 
 int ConfigManager::getUpdatePeriodJiffies() const {
-    return updatePeriodJiffies;
+    return current().updatePeriodJiffies;
+}
+
+const std::string& ConfigManager::getOverrunPolicy() const {
+    return current().overrunPolicy;
+}
+
+int ConfigManager::getCollectorPeriodJiffies(const std::string& collectorName) const {
+    const Values& values = current();
+    return getConfigValue<int>(values.config, "system_info.collectors." + collectorName + ".period_jiffies", values.updatePeriodJiffies);
 }
 
 
 void ConfigManager::setVerbosity(int newVerbosity) {
-    if (!config.contains("debug")) {
-        config["debug"] = json::object(); // Create the debug section if it doesn't exist
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    std::unique_ptr<Values> values(new Values(current()));
+    if (!values->config.contains("debug")) {
+        values->config["debug"] = json::object(); // Create the debug section if it doesn't exist
     }
-    verbosity = newVerbosity;
-    config["debug"]["verbosity"] = newVerbosity;
+    values->verbosity = newVerbosity;
+    values->config["debug"]["verbosity"] = newVerbosity;
+    publish(std::move(values));
 }
 
 void ConfigManager::setAveragePeriodJiffies(int averagePeriod) {
-    if (!config.contains("system_info")) {
-        config["average_period_jiffies"] = json::object();
-    }
-    averagePeriodJiffies = averagePeriod;
-    config["system_info"]["average_period_jiffies"] = averagePeriod;
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    std::unique_ptr<Values> values(new Values(current()));
+    values->averagePeriodJiffies = averagePeriod;
+    values->config["system_info"]["average_period_jiffies"] = averagePeriod;
+    publish(std::move(values));
 }
 
 void ConfigManager::setUpdatePeriodJiffies(int updatePeriod) {
-    if (!config.contains("system_info")) {
-        config["update_period_jiffies"] = json::object();
-    }
-    updatePeriodJiffies = updatePeriod;
-    config["system_info"]["update_period_jiffies"] = updatePeriod;
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    std::unique_ptr<Values> values(new Values(current()));
+    values->updatePeriodJiffies = updatePeriod;
+    values->config["system_info"]["update_period_jiffies"] = updatePeriod;
+    publish(std::move(values));
+}
+
+void ConfigManager::setProcfsRoot(const std::string& newProcfsRoot) {
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    std::unique_ptr<Values> values(new Values(current()));
+    values->procfsRoot = newProcfsRoot;
+    values->config["system_info"]["procfs_root"] = newProcfsRoot;
+    publish(std::move(values));
+}
+
+void ConfigManager::setCapture(const std::string& mode, const std::string& path) {
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    std::unique_ptr<Values> values(new Values(current()));
+    values->captureMode = mode;
+    values->capturePath = path;
+    values->config["system_info"]["capture"]["mode"] = mode;
+    values->config["system_info"]["capture"]["path"] = path;
+    publish(std::move(values));
+}
+
+void ConfigManager::setReplaySpeed(double newReplaySpeed) {
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    std::unique_ptr<Values> values(new Values(current()));
+    values->replaySpeed = newReplaySpeed;
+    values->config["system_info"]["capture"]["replay_speed"] = newReplaySpeed;
+    publish(std::move(values));
 }
 
 std::string ConfigManager::getConfigFilePath(const std::string& configFile) {
@@ -116,11 +365,44 @@ std::string ConfigManager::getConfigFilePath(const std::string& configFile) {
     return configFilePath;
 }
 
-void ConfigManager::readConfig(const nlohmann::json& config) {
-    readConfigSection(config, "debug.verbosity", verbosity, DEFAULT_VERBOSITY);
-    readConfigSection(config, "system_info.update_period_jiffies", updatePeriodJiffies, DEFAULT_UPDATE_PERIOD_JIFFIES);
-    readConfigSection(config, "system_info.average_period_jiffies", averagePeriodJiffies, DEFAULT_AVERAGE_PERIOD_JIFFIES);
-
+void ConfigManager::readConfig(Values& values) {
+    const nlohmann::json& config = values.config;
+    readConfigSection(config, "debug.verbosity", values.verbosity, DEFAULT_VERBOSITY);
+    readConfigSection(config, "system_info.update_period_jiffies", values.updatePeriodJiffies, DEFAULT_UPDATE_PERIOD_JIFFIES);
+    readConfigSection(config, "system_info.average_period_jiffies", values.averagePeriodJiffies, DEFAULT_AVERAGE_PERIOD_JIFFIES);
+    readConfigSection(config, "system_info.overrun_policy", values.overrunPolicy, DEFAULT_OVERRUN_POLICY);
+    readConfigList(config, "system_info.average_windows_jiffies", values.averageWindowsJiffies);
+    readConfigList(config, "system_info.processes.pids", values.watchedProcessPids);
+    readConfigList(config, "system_info.processes.names", values.watchedProcessNames);
+    readConfigSection(config, "system_info.processes.max_processes", values.maxWatchedProcesses, DEFAULT_MAX_WATCHED_PROCESSES);
+    readConfigSection(config, "system_info.processes.rescan_period_jiffies", values.processRescanPeriodJiffies, DEFAULT_PROCESS_RESCAN_PERIOD_JIFFIES);
+    readConfigList(config, "system_info.network.interfaces", values.networkInterfaces);
+    readConfigList(config, "system_info.network.exclude_interfaces", values.excludedNetworkInterfaces);
+    readConfigSection(config, "system_info.network.max_interfaces", values.maxNetworkInterfaces, DEFAULT_MAX_NETWORK_INTERFACES);
+    readConfigList(config, "system_info.disks.devices", values.diskDevices);
+    if (findConfigNode(config, "system_info.disks.exclude_devices")) {
+        readConfigList(config, "system_info.disks.exclude_devices", values.excludedDiskDevices);
+    } else {
+        values.excludedDiskDevices = DEFAULT_EXCLUDED_DISK_DEVICES;
+    }
+    readConfigSection(config, "system_info.disks.include_partitions", values.diskPartitionsIncluded, DEFAULT_DISK_PARTITIONS_INCLUDED);
+    readConfigSection(config, "system_info.disks.max_devices", values.maxDiskDevices, DEFAULT_MAX_DISK_DEVICES);
+    readPressureTriggers(config, "system_info.pressure.triggers", values.pressureTriggers);
+    readConfigSection(config, "system_info.shared_memory.enabled", values.sharedMemoryEnabled, DEFAULT_SHARED_MEMORY_ENABLED);
+    readConfigSection(config, "system_info.shared_memory.name", values.sharedMemoryName, DEFAULT_SHARED_MEMORY_NAME);
+    readConfigSection(config, "system_info.shared_memory.slots", values.sharedMemorySlots, DEFAULT_SHARED_MEMORY_SLOTS);
+    readConfigSection(config, "system_info.history.enabled", values.historyEnabled, DEFAULT_HISTORY_ENABLED);
+    readConfigSection(config, "system_info.history.memory_budget_bytes", values.historyMemoryBudgetBytes, DEFAULT_HISTORY_MEMORY_BUDGET_BYTES);
+    readConfigSection(config, "system_info.history.block_bytes", values.historyBlockBytes, DEFAULT_HISTORY_BLOCK_BYTES);
+    readConfigSection(config, "system_info.archive.enabled", values.archiveEnabled, DEFAULT_ARCHIVE_ENABLED);
+    readConfigSection(config, "system_info.archive.path", values.archivePath, DEFAULT_ARCHIVE_PATH);
+    readArchiveTiers(config, "system_info.archive.tiers", values.archiveTiers);
+    readConfigSection(config, "system_info.procfs_root", values.procfsRoot, DEFAULT_PROCFS_ROOT);
+    readConfigSection(config, "system_info.capture.mode", values.captureMode, DEFAULT_CAPTURE_MODE);
+    readConfigSection(config, "system_info.capture.path", values.capturePath, DEFAULT_CAPTURE_PATH);
+    readConfigSection(config, "system_info.capture.replay_speed", values.replaySpeed, DEFAULT_REPLAY_SPEED);
+    readSinks(config, "system_info.sinks", values.sinks);
+    readConfigSection(config, "system_info.hot_reload", values.hotReloadEnabled, DEFAULT_HOT_RELOAD_ENABLED);
 }
 
 template<typename T>
@@ -129,24 +411,80 @@ void ConfigManager::readConfigSection(const nlohmann::json& config, const std::s
 }
 
 template<typename T>
-T ConfigManager::getConfigValue(const nlohmann::json& config, const std::string& configPath, const T& defaultValue) {
+void ConfigManager::readConfigList(const nlohmann::json& config, const std::string& configPath, std::vector<T>& target) const {
+    try {
+        target = getConfigNode(config, configPath).get<std::vector<T> >();
+    } catch (const std::exception& e) {
+        if (debug) {
+            std::cerr << "Warning: Failed to read config list for path '" << configPath << "'. Using an empty list. Exception: " << e.what() << std::endl;
+        }
+        target.clear();
+    }
+}
+
+void ConfigManager::readSinks(const nlohmann::json& config, const std::string& configPath, std::vector<SinkConfig>& target) {
+    target.clear();
+    try {
+        // Every key but the format is optional
+        for (const nlohmann::json& sink : getConfigNode(config, configPath)) {
+            SinkConfig sinkConfig;
+            sinkConfig.format = sink.at("format").get<std::string>();
+            sinkConfig.directory = sink.value("directory", DEFAULT_SINK_DIRECTORY);
+            sinkConfig.prefix = sink.value("prefix", DEFAULT_SINK_PREFIX);
+            sinkConfig.rotateBytes = sink.value("rotate_bytes", DEFAULT_SINK_ROTATE_BYTES);
+            sinkConfig.rotateSeconds = sink.value("rotate_seconds", DEFAULT_SINK_ROTATE_SECONDS);
+            sinkConfig.batchBytes = sink.value("batch_bytes", DEFAULT_SINK_BATCH_BYTES);
+            sinkConfig.flushSeconds = sink.value("flush_seconds", DEFAULT_SINK_FLUSH_SECONDS);
+            sinkConfig.queueCapacity = sink.value("queue_capacity", DEFAULT_SINK_QUEUE_CAPACITY);
+            target.push_back(sinkConfig);
+        }
+    } catch (const std::exception& e) {
+        if (debug) {
+            std::cerr << "Warning: Failed to read the sinks for path '" << configPath << "'. Using no sinks. Exception: " << e.what() << std::endl;
+        }
+        target.clear();
+    }
+}
+
+void ConfigManager::readPressureTriggers(const nlohmann::json& config, const std::string& configPath, std::vector<PressureTriggerConfig>& target) {
+    target.clear();
     try {
-        // Split the period-separated path into individual keys
-        std::vector<std::string> keys;
-        std::istringstream iss(configPath);
-        std::string key;
-        while (std::getline(iss, key, '.')) {
-            keys.push_back(key);
+        for (const nlohmann::json& trigger : getConfigNode(config, configPath)) {
+            PressureTriggerConfig triggerConfig;
+            triggerConfig.resource = trigger.at("resource").get<std::string>();
+            triggerConfig.type = trigger.value("type", DEFAULT_PRESSURE_TRIGGER_TYPE);
+            triggerConfig.stallUs = trigger.at("stall_us").get<int>();
+            triggerConfig.windowUs = trigger.value("window_us", DEFAULT_PRESSURE_TRIGGER_WINDOW_US);
+            target.push_back(triggerConfig);
+        }
+    } catch (const std::exception& e) {
+        if (debug) {
+            std::cerr << "Warning: Failed to read the pressure triggers for path '" << configPath << "'. Using no triggers. Exception: " << e.what() << std::endl;
         }
+        target.clear();
+    }
+}
 
-        // Traverse the JSON object using the keys
-        const nlohmann::json* current = &config;
-        for (const auto& k : keys) {
-            current = &((*current)[k]);
+void ConfigManager::readArchiveTiers(const nlohmann::json& config, const std::string& configPath, std::vector<ArchiveTierConfig>& target) {
+    try {
+        std::vector<ArchiveTierConfig> tiers;
+        for (const nlohmann::json& tier : getConfigNode(config, configPath)) {
+            tiers.push_back({ tier.at("resolution_seconds").get<int>(), tier.at("rows").get<int>() });
+        }
+        target = tiers;
+    } catch (const std::exception& e) {
+        if (debug) {
+            std::cerr << "Warning: Failed to read archive tiers for path '" << configPath << "'. Using the default tiers. Exception: " << e.what() << std::endl;
         }
+        target = DEFAULT_ARCHIVE_TIERS;
+    }
+}
 
+template<typename T>
+T ConfigManager::getConfigValue(const nlohmann::json& config, const std::string& configPath, const T& defaultValue) const {
+    try {
         // Return the value found
-        return current->get<T>();
+        return getConfigNode(config, configPath).get<T>();
     } catch (const std::exception& e) {
         if (debug) {
             std::cerr << "Warning: Failed to read config value for path '" << configPath << "'. Using default value " << defaultValue << ". Exception: " << e.what() << std::endl;
@@ -155,6 +493,52 @@ T ConfigManager::getConfigValue(const nlohmann::json& config, const std::string&
     }
 }
 
+const nlohmann::json& ConfigManager::getConfigNode(const nlohmann::json& config, const std::string& configPath) {
+    // Split the period-separated path into individual keys
+    std::vector<std::string> keys;
+    std::istringstream iss(configPath);
+    std::string key;
+    while (std::getline(iss, key, '.')) {
+        keys.push_back(key);
+    }
+
+    // Traverse the JSON object using the keys (at() throws on a missing key, so optional keys fall back to the default)
+    const nlohmann::json* current = &config;
+    for (const auto& k : keys) {
+        current = &(current->at(k));
+    }
+    return *current;
+}
+
+const nlohmann::json* ConfigManager::findConfigNode(const nlohmann::json& config, const std::string& configPath) {
+    try {
+        return &getConfigNode(config, configPath);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+void ConfigManager::setConfigNode(nlohmann::json& config, const std::string& configPath, const nlohmann::json* value) {
+    // Walk down to the parent object, creating the missing ones only when there is a value to store
+    nlohmann::json* current = &config;
+    size_t begin = 0;
+    size_t end = configPath.find('.');
+    for (; end != std::string::npos; begin = end + 1, end = configPath.find('.', begin)) {
+        std::string key = configPath.substr(begin, end - begin);
+        if (!current->is_object() || (!current->contains(key) && !value)) {
+            return;
+        }
+        current = &(*current)[key];
+    }
+
+    std::string key = configPath.substr(begin);
+    if (value) {
+        (*current)[key] = *value;
+    } else if (current->is_object()) {
+        current->erase(key);
+    }
+}
+
 bool ConfigManager::fileExists(const std::string& path) {
     struct stat buffer;
     return (stat(path.c_str(), &buffer) == 0);
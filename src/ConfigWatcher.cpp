@@ -0,0 +1,133 @@
+#include "ConfigWatcher.h"
+#include "JsonManager.h"
+#include "Printer.h"
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+// Editors write a file in several steps, so parse once it has been quiet for this long
+static const int SETTLE_MILLISECONDS = 100;
+
+ConfigWatcher::ConfigWatcher() : inotifyFd_(-1), stopFd_(-1), hasConfig_(false) {
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+bool ConfigWatcher::start(const std::string& path) {
+    stop();
+    path_ = path;
+    size_t lastSlash = path_.find_last_of('/');
+    directory_ = lastSlash == std::string::npos ? "." : (lastSlash == 0 ? "/" : path_.substr(0, lastSlash));
+    fileName_ = lastSlash == std::string::npos ? path_ : path_.substr(lastSlash + 1);
+
+    inotifyFd_ = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    stopFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (inotifyFd_ < 0 || stopFd_ < 0 ||
+        inotify_add_watch(inotifyFd_, directory_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        PRINT_WARNING(-1, "Failed to watch " + path_ + " for changes: " + std::string(strerror(errno)));
+        stop();
+        return false;
+    }
+
+    thread_ = std::thread([this]() {
+        this->watchLoop();
+    });
+    PRINT_INFO(2, "Watching " + path_ + " for changes.");
+    return true;
+}
+
+void ConfigWatcher::stop() {
+    if (thread_.joinable()) {
+        uint64_t one = 1;
+        if (write(stopFd_, &one, sizeof(one)) < 0) {
+            PRINT_WARNING(-1, "Failed to stop the config watcher: " + std::string(strerror(errno)));
+        }
+        thread_.join();
+    }
+    if (inotifyFd_ >= 0) {
+        close(inotifyFd_);
+        inotifyFd_ = -1;
+    }
+    if (stopFd_ >= 0) {
+        close(stopFd_);
+        stopFd_ = -1;
+    }
+}
+
+bool ConfigWatcher::hasConfig() const {
+    return hasConfig_.load(std::memory_order_acquire);
+}
+
+bool ConfigWatcher::takeConfig(nlohmann::json& config) {
+    std::unique_lock<std::mutex> lock(configMutex_, std::try_to_lock);
+    if (!lock.owns_lock() || !hasConfig_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    config = std::move(config_);
+    hasConfig_.store(false, std::memory_order_relaxed);
+    return true;
+}
+
+void ConfigWatcher::watchLoop() {
+    while (waitForChange()) {
+        nlohmann::json config;
+        try {
+            config = JsonManager::parseConfigFile(path_);
+        } catch (const std::exception& e) {
+            PRINT_WARNING(-1, "Not reloading " + path_ + ", keeping the current configuration: " + e.what());
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config_ = std::move(config);
+        hasConfig_.store(true, std::memory_order_release);
+    }
+}
+
+bool ConfigWatcher::waitForChange() {
+    // Events are variable-length records, the buffer holds at least one with the longest name
+    alignas(struct inotify_event) char buffer[4096 + sizeof(struct inotify_event) + NAME_MAX + 1];
+    struct pollfd fds[2];
+    fds[0].fd = stopFd_;
+    fds[0].events = POLLIN;
+    fds[1].fd = inotifyFd_;
+    fds[1].events = POLLIN;
+
+    bool changed = false;
+    while (true) {
+        // Wait without a timeout for the first change, then until the file stays quiet
+        int ready = poll(fds, 2, changed ? SETTLE_MILLISECONDS : -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            PRINT_WARNING(-1, "Stopped watching " + path_ + ": " + std::string(strerror(errno)));
+            return false;
+        }
+        if (fds[0].revents != 0) {
+            return false;
+        }
+        if (ready == 0) {
+            return true;
+        }
+
+        ssize_t length;
+        while ((length = read(inotifyFd_, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + length;) {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+                if (event->len > 0 && fileName_ == event->name) {
+                    changed = true;
+                }
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+}
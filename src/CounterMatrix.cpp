@@ -0,0 +1,105 @@
+#include "CounterMatrix.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+CounterMatrix::CounterMatrix() : numColumns_(0), numRows_(0), capacity_(0) {
+}
+
+CounterMatrix::CounterMatrix(size_t numColumns, size_t numRows, size_t capacity) {
+    reset(numColumns, numRows, capacity);
+}
+
+void CounterMatrix::reset(size_t numColumns, size_t numRows, size_t capacity) {
+    numColumns_ = numColumns;
+    numRows_ = numRows;
+    capacity_ = capacity;
+
+    // One extra storage slot is kept as the pending slot
+    jiffies_.reset(capacity_ + 1);
+    counters_.assign(numColumns_ * (capacity_ + 1) * numRows_, 0);
+}
+
+void CounterMatrix::resize(size_t capacity) {
+    if (capacity == capacity_) {
+        return;
+    }
+
+    // Copy the kept samples to the front of the new storage, oldest first
+    size_t kept = std::min(size(), capacity);
+    size_t first = size() - kept;
+    RingBuffer<unsigned long long> jiffies(capacity + 1);
+    std::vector<unsigned long long> counters(numColumns_ * (capacity + 1) * numRows_, 0);
+    for (size_t index = 0; index < kept; ++index) {
+        for (size_t column = 0; column < numColumns_; ++column) {
+            std::memcpy(&counters[(column * (capacity + 1) + index) * numRows_], getColumn(column, first + index),
+                        numRows_ * sizeof(unsigned long long));
+        }
+        jiffies.push(getJiffies(first + index));
+    }
+
+    capacity_ = capacity;
+    jiffies_ = std::move(jiffies);
+    counters_.swap(counters);
+}
+
+unsigned long long* CounterMatrix::getPendingColumn(size_t column) {
+    size_t slot = jiffies_.getNextPhysicalIndex();
+    return &counters_[(column * (capacity_ + 1) + slot) * numRows_];
+}
+
+void CounterMatrix::commit(unsigned long long jiffies) {
+    jiffies_.push(jiffies);
+}
+
+const unsigned long long* CounterMatrix::getColumn(size_t column, size_t index) const {
+    return &counters_[(column * (capacity_ + 1) + getSlot(index)) * numRows_];
+}
+
+unsigned long long CounterMatrix::getJiffies(size_t index) const {
+    return jiffies_.at(jiffies_.size() - size() + index);
+}
+
+size_t CounterMatrix::findWindowStart(unsigned long long windowJiffies) const {
+    size_t numSamples = size();
+    if (numSamples < 2) {
+        return 0;
+    }
+
+    // Jiffies only grow from the oldest to the newest sample, so binary search for the latest sample
+    // that still covers the whole window. Skipped samples only shift the start, they never break the window.
+    unsigned long long newestJiffies = getJiffies(numSamples - 1);
+    size_t low = 0;
+    size_t high = numSamples - 1; // The newest sample never covers a non-empty window
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (newestJiffies - getJiffies(middle) >= windowJiffies) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    // low is the first sample inside the window, the one before it is the start (the oldest if none covers it)
+    return low > 0 ? low - 1 : 0;
+}
+
+size_t CounterMatrix::size() const {
+    // When every storage slot is used, the oldest one is the next pending slot and no longer valid
+    return jiffies_.size() < capacity_ ? jiffies_.size() : capacity_;
+}
+
+size_t CounterMatrix::capacity() const {
+    return capacity_;
+}
+
+size_t CounterMatrix::getNumRows() const {
+    return numRows_;
+}
+
+size_t CounterMatrix::getNumColumns() const {
+    return numColumns_;
+}
+
+size_t CounterMatrix::getSlot(size_t index) const {
+    return jiffies_.getPhysicalIndex(jiffies_.size() - size() + index);
+}
@@ -0,0 +1,193 @@
+#include "CpuCollector.h"
+#include "ConfigManager.h"
+#include "ProcCapture.h"
+#include "ProcFile.h"
+#include "ProcParse.h"
+#include "Printer.h"
+#include <cstring>
+#include <string>
+
+CpuCollector::CpuCollector()
+    : statReader_(ConfigManager::getInstance().getProcPath("stat")), numCores_(0), jiffiesPerSecond_(100), periodJiffies_(1) {
+}
+
+const char* CpuCollector::getName() const {
+    return "cpu";
+}
+
+int CpuCollector::getNumCores() const {
+    return numCores_;
+}
+
+void CpuCollector::init(unsigned long long jiffiesPerSecond, unsigned long long periodJiffies) {
+    PRINT_INFO(2, "Initializing CPU usage...");
+
+    jiffiesPerSecond_ = jiffiesPerSecond;
+    periodJiffies_ = periodJiffies;
+    initNumCores();
+
+    // Allocate the counter history and results once, the sampler parses directly into them
+    cpuUsageCalculator_.reset(numCores_, periodJiffies_);
+    coreUsagePercent_.assign(cpuUsageCalculator_.getNumRows() * cpuUsageCalculator_.getNumWindows(), -1.0);
+
+    checkWindow("Average period", cpuUsageCalculator_.getWindowJiffies(0));
+    for (size_t window = 1; window < cpuUsageCalculator_.getNumWindows(); ++window) {
+        checkWindow("Average window", cpuUsageCalculator_.getWindowJiffies(window));
+    }
+
+    if (statReader_.isOpen()) {
+        // Read CPU statistics from /proc/stat
+        unsigned long long totalUser, totalUserLow, totalSys, totalIdle;
+        statReader_.read(&totalUser, &totalUserLow, &totalSys, &totalIdle, 1);
+        PRINT_INFO(2, "Initial stats: totalUser: " + std::to_string(totalUser) +
+                      ", totalUserLow: " + std::to_string(totalUserLow) +
+                      ", totalSys: " + std::to_string(totalSys) +
+                      ", totalIdle: " + std::to_string(totalIdle));
+        PRINT_INFO(2, "CPU usage initialized.");
+    } else {
+        PRINT_WARNING(-1, "Failed to open " + statReader_.getPath() + " for initialization.");
+    }
+    // Start the history so the first sample already has a usage
+    addDataPointToBuffer();
+}
+
+bool CpuCollector::reconfigure(unsigned long long periodJiffies) {
+    bool windowsApplied = cpuUsageCalculator_.reconfigure(periodJiffies);
+    periodJiffies_ = periodJiffies;
+    for (size_t window = 0; window < cpuUsageCalculator_.getNumWindows(); ++window) {
+        checkWindow(window == 0 ? "Average period" : "Average window", cpuUsageCalculator_.getWindowJiffies(window));
+    }
+    return windowsApplied;
+}
+
+void CpuCollector::checkWindow(const std::string& name, unsigned long long windowJiffies) const {
+    // Check if the window is shorter than update period
+    if (windowJiffies < periodJiffies_) {
+        PRINT_WARNING(-1, "Warning: " + name + " (" + std::to_string(windowJiffies) +
+                          ") is shorter than update period (" + std::to_string(periodJiffies_) + ").");
+    }
+
+    // Check if the window is not divisible by update period
+    if (periodJiffies_ != 0 && windowJiffies % periodJiffies_ != 0) {
+        PRINT_WARNING(-1, "Warning: " + name + " (" + std::to_string(windowJiffies) +
+                          ") is not divisible by update period (" + std::to_string(periodJiffies_) + ").");
+    }
+}
+
+void CpuCollector::initNumCores() {
+    // Read the number of CPU cores from /proc/cpuinfo
+    int numCoresCpuInfo = 0;
+    ProcFile cpuinfo(ConfigManager::getInstance().getProcPath("cpuinfo"), 65536);
+    if (cpuinfo.isOpen() && cpuinfo.read()) {
+        const char* p = cpuinfo.data();
+        const char* end = p + cpuinfo.size();
+        while (p < end) {
+            if (end - p >= 9 && std::memcmp(p, "processor", 9) == 0) {
+                numCoresCpuInfo++;
+            }
+            ProcParse::nextLine(p, end);
+        }
+    } else {
+        PRINT_WARNING(-1, "Failed to open " + cpuinfo.getPath() + " to get the number of CPU cores.");
+    }
+
+    // Read the number of CPU cores from /proc/stat
+    int numCoresProcStat = -1; //Start at -1 because we count the first line "cpu" which is just the total
+    int cpuLines = statReader_.countCpuLines();
+    if (cpuLines >= 0) {
+        numCoresProcStat += cpuLines;
+    } else {
+        PRINT_WARNING(-1, "Failed to open " + statReader_.getPath() + " to get the number of CPU cores.");
+    }
+
+    // Check if the number of cores matches
+    if (numCoresProcStat != numCoresCpuInfo) {
+        PRINT_WARNING(-1, "Number of CPU cores detected by /proc/cpuinfo is " + std::to_string(numCoresCpuInfo) + " and by /proc/stat is " + std::to_string(numCoresProcStat) + ".");
+    }
+
+    // We will always chose to use /proc/stat
+    numCores_ = numCoresProcStat > 0 ? numCoresProcStat : 0;
+}
+
+void CpuCollector::initSnapshot(SystemInfoData& data) {
+    data.cpu_num_processors = numCores_;
+    data.cpu_usage_percent = -1.0;
+    data.cpu_real_time_step = 0.0;
+    data.cpu_usage_percent_per_core.assign(numCores_, -1.0);
+    data.cpu_real_time_step_per_core.assign(numCores_, 0.0);
+
+    size_t numWindows = cpuUsageCalculator_.getNumWindows();
+    data.cpu_window_jiffies.resize(numWindows);
+    for (size_t window = 0; window < numWindows; ++window) {
+        data.cpu_window_jiffies[window] = cpuUsageCalculator_.getWindowJiffies(window);
+    }
+    data.cpu_usage_percent_per_window.assign(numWindows, -1.0);
+    data.cpu_real_time_step_per_window.assign(numWindows, 0.0);
+    data.cpu_usage_percent_per_window_per_core.assign(numWindows * numCores_, -1.0);
+}
+
+bool CpuCollector::collect(SystemInfoData& data) {
+    // Sample /proc/stat into the counter history
+    if (!addDataPointToBuffer()) {
+        return false;
+    }
+
+    // Calculate CPU usage results for the total CPU and every core in one pass per window, all from the same history
+    size_t numRows = cpuUsageCalculator_.getNumRows();
+    size_t totalRow = CpuUsageCalculator::getRowForCore(CpuUsageCalculator::TOTAL_CPU_USAGE_INDEX);
+    for (size_t window = 0; window < cpuUsageCalculator_.getNumWindows(); ++window) {
+        double* usagePercent = coreUsagePercent_.data() + window * numRows;
+        unsigned long long jiffiesPassed = cpuUsageCalculator_.calculateCpuUsagePercentForWindow(window, usagePercent);
+        double timeStep = static_cast<double>(jiffiesPassed) / jiffiesPerSecond_; // Every core shares the time step
+
+        data.cpu_window_jiffies[window] = cpuUsageCalculator_.getWindowJiffies(window); // Window lengths may be reloaded
+        data.cpu_usage_percent_per_window[window] = usagePercent[totalRow];
+        data.cpu_real_time_step_per_window[window] = timeStep;
+        double* windowCoreUsagePercent = data.cpu_usage_percent_per_window_per_core.data() + window * numCores_;
+        for (int core = 0; core < numCores_; ++core) {
+            windowCoreUsagePercent[core] = usagePercent[CpuUsageCalculator::getRowForCore(core)];
+        }
+    }
+
+    // Window 0 also fills the average_period_jiffies fields
+    data.cpu_usage_percent = data.cpu_usage_percent_per_window[0];
+    data.cpu_real_time_step = data.cpu_real_time_step_per_window[0];
+    for (int core = 0; core < numCores_; ++core) {
+        data.cpu_usage_percent_per_core[core] = data.cpu_usage_percent_per_window_per_core[core];
+        data.cpu_real_time_step_per_core[core] = data.cpu_real_time_step;
+    }
+    return true;
+}
+
+bool CpuCollector::addDataPointToBuffer() {
+    // Check if the file is open
+    if (!statReader_.isOpen()) {
+        PRINT_INFO_RATE_LIMITED(2, "Error: " + statReader_.getPath() + " is not open.");
+        return false;
+    }
+
+    // Parse the total line and one line per core straight into the counter history
+    int rowsRead = statReader_.read(cpuUsageCalculator_.getPendingColumn(CpuUsageCalculator::USER_COLUMN),
+                                    cpuUsageCalculator_.getPendingColumn(CpuUsageCalculator::USER_LOW_COLUMN),
+                                    cpuUsageCalculator_.getPendingColumn(CpuUsageCalculator::SYS_COLUMN),
+                                    cpuUsageCalculator_.getPendingColumn(CpuUsageCalculator::IDLE_COLUMN),
+                                    static_cast<int>(cpuUsageCalculator_.getNumRows()));
+    if (rowsRead <= 0) {
+        PRINT_INFO_RATE_LIMITED(2, "Error: Failed to read CPU statistics from " + statReader_.getPath() + ".");
+        return false;
+    }
+
+    if (static_cast<size_t>(rowsRead) < cpuUsageCalculator_.getNumRows()) {
+        PRINT_INFO_RATE_LIMITED(2, "Core data is only available for " + std::to_string(rowsRead - 1) + " of " + std::to_string(numCores_) + " cores.");
+    }
+
+    // Get the current jiffy and commit the data point
+    cpuUsageCalculator_.commitDataPoint(getCurrentJiffy(), static_cast<size_t>(rowsRead));
+
+    return true;
+}
+
+unsigned long long CpuCollector::getCurrentJiffy() const {
+    // The time of the sample, which is the recorded one when replaying a capture
+    return static_cast<unsigned long long>(ProcCapture::getInstance().getSampleNanos()) / (1000000000ULL / jiffiesPerSecond_);
+}
@@ -1,130 +1,185 @@
 #include "CpuUsageCalculator.h"
 #include "ConfigManager.h"
 #include "Printer.h"
+#include <algorithm>
 #include <cmath> // For std::ceil function
+#include <stdexcept>
 
 // Initialize static variables
-std::map<int, CpuUsageCalculator*> CpuUsageCalculator::coreInstances_;
-std::mutex CpuUsageCalculator::mutex_;
 const int CpuUsageCalculator::TOTAL_CPU_USAGE_INDEX = -1;
 
-CpuUsageCalculator::CpuUsageCalculator() {
-    // Retrieve jiffies values from ConfigManager
-    unsigned long long averagePeriodJiffies = static_cast<unsigned long long>(ConfigManager::getInstance().getAveragePeriodJiffies());
-    unsigned long long updatePeriodJiffies = static_cast<unsigned long long>(ConfigManager::getInstance().getUpdatePeriodJiffies());
+CpuUsageCalculator::CpuUsageCalculator() : bufferSize_(0) {
+}
 
+void CpuUsageCalculator::reset(int numCores, unsigned long long updatePeriodJiffies) {
     // Calculate buffer size
     if (updatePeriodJiffies == 0) {
         // Handle potential division by zero if updatePeriodJiffies is zero
         throw std::runtime_error("Update period jiffies cannot be zero.");
     }
 
-    // Calculate the buffer size
-    bufferSize_ = static_cast<std::size_t>(std::ceil(static_cast<double>(averagePeriodJiffies) / updatePeriodJiffies)) + 1;
+    windowsJiffies_ = getConfiguredWindowsJiffies();
+    unsigned long long longestWindowJiffies = *std::max_element(windowsJiffies_.begin(), windowsJiffies_.end());
 
-    // Initialize buffer with calculated size
-    //buffer_.resize(bufferSize_);
-    currentIndex_ = 0;
-    largestOccupiedIndex_ = 0;
-}
+    // Calculate the buffer size, one history shared by every window
+    bufferSize_ = static_cast<std::size_t>(std::ceil(static_cast<double>(longestWindowJiffies) / updatePeriodJiffies)) + 1;
 
-CpuUsageCalculator::~CpuUsageCalculator() {
-    // Destructor implementation
+    // Allocate the whole history up front (one row for the total plus one per core), it never reallocates afterwards
+    size_t numRows = getRowForCore(numCores > 0 ? numCores : 0);
+    counters_.reset(NUM_COLUMNS, numRows, bufferSize_);
 }
 
-CpuUsageCalculator& CpuUsageCalculator::getInstanceForCore(int core) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (coreInstances_.find(core) == coreInstances_.end()) {
-        coreInstances_[core] = new CpuUsageCalculator();
+bool CpuUsageCalculator::reconfigure(unsigned long long updatePeriodJiffies) {
+    // Called on the update thread, so a zero period is clamped like the scheduler does instead of throwing
+    if (updatePeriodJiffies == 0) {
+        updatePeriodJiffies = 1;
+    }
+
+    std::vector<unsigned long long> windowsJiffies = getConfiguredWindowsJiffies();
+    bool windowsApplied = windowsJiffies.size() == windowsJiffies_.size();
+    if (windowsApplied) {
+        windowsJiffies_.swap(windowsJiffies);
     }
-    return *coreInstances_[core];
+    unsigned long long longestWindowJiffies = *std::max_element(windowsJiffies_.begin(), windowsJiffies_.end());
+    bufferSize_ = static_cast<std::size_t>(std::ceil(static_cast<double>(longestWindowJiffies) / updatePeriodJiffies)) + 1;
+    counters_.resize(bufferSize_);
+    return windowsApplied;
 }
 
-CpuUsageCalculator& CpuUsageCalculator::getInstanceForTotal() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (coreInstances_.find(TOTAL_CPU_USAGE_INDEX) == coreInstances_.end()) {
-        coreInstances_[TOTAL_CPU_USAGE_INDEX] = new CpuUsageCalculator();
+unsigned long long* CpuUsageCalculator::getPendingColumn(Column column) {
+    return counters_.getPendingColumn(column);
+}
+
+void CpuUsageCalculator::commitDataPoint(unsigned long long jiffies, size_t rowsWritten) {
+    for (size_t column = 0; column < NUM_COLUMNS; ++column) {
+        unsigned long long* pending = counters_.getPendingColumn(column);
+        const unsigned long long* previous = counters_.size() > 0 ? counters_.getColumn(column, counters_.size() - 1) : nullptr;
+        for (size_t row = rowsWritten; row < counters_.getNumRows(); ++row) {
+            pending[row] = previous ? previous[row] : 0;
+        }
     }
-    return *coreInstances_[TOTAL_CPU_USAGE_INDEX];
+    counters_.commit(jiffies);
+}
+
+CpuUsageResult CpuUsageCalculator::calculateCpuUsagePercentForCore(int core) const {
+    return calculateCpuUsagePercentForCoreWindow(core, 0);
 }
 
-void CpuUsageCalculator::addDataPointForCore(int core, unsigned long long totalUser, unsigned long long totalUserLow,
-                                              unsigned long long totalSys, unsigned long long totalIdle, unsigned long long jiffies) {
-    std::lock_guard<std::mutex> lock(mutex_); // Lock for multithreading
+CpuUsageResult CpuUsageCalculator::calculateCpuUsagePercentForCoreWindow(int core, size_t window) const {
+    // Compare the start of the window with the newest data point
+    CpuUsageResult result = calculateCpuUsagePercentForCore(core, getWindowStartIndex(window), counters_.size() == 0 ? 0 : counters_.size() - 1);
+    result.windowJiffies = getWindowJiffies(window);
+    return result;
+}
+
+CpuUsageResult CpuUsageCalculator::calculateCpuUsagePercentForCore(int core, size_t index1, size_t index2) const {
+    size_t row = getRowForCore(core);
+    if (index1 >= counters_.size() || index2 >= counters_.size() || index1 == index2 || row >= counters_.getNumRows()) {
+        PRINT_WARNING_RATE_LIMITED(-1, "Invalid indices. Variable Values: Core: " + std::to_string(core) +
+                                       ", Buffer current size: " + std::to_string(counters_.size()) +
+                                       "/" + std::to_string(bufferSize_) + ", Index1: " + std::to_string(index1) +
+                                       ", Index2: " + std::to_string(index2));
 
-    DataPoint newDataPoint = {totalUser, totalUserLow, totalSys, totalIdle, jiffies}; // Create data point
+        // The buffer dump is only built when it will be printed
+        PRINT_WARNING_RATE_LIMITED(2, "Buffer Contents:\n" + dumpRow(row));
 
-    // Check if buffer is full
-    if (buffer_.size() >= bufferSize_) {
-        // Remove the oldest data point (FIFO behavior)
-        buffer_.erase(buffer_.begin());
+        return { -1.0, 0, 0 }; // Invalid indices
     }
 
-    // Add the new data point to the end of the buffer
-    buffer_.push_back(newDataPoint);
+    double notIdleDiff = (counters_.getColumn(USER_COLUMN, index2)[row] - counters_.getColumn(USER_COLUMN, index1)[row]) +
+                         (counters_.getColumn(USER_LOW_COLUMN, index2)[row] - counters_.getColumn(USER_LOW_COLUMN, index1)[row]) +
+                         (counters_.getColumn(SYS_COLUMN, index2)[row] - counters_.getColumn(SYS_COLUMN, index1)[row]);
+    double idleDiff = counters_.getColumn(IDLE_COLUMN, index2)[row] - counters_.getColumn(IDLE_COLUMN, index1)[row];
 
-    // Update largestOccupiedIndex_ if necessary
-    if (buffer_.size() > largestOccupiedIndex_) {
-        largestOccupiedIndex_ = buffer_.size() - 1;
-    }
+    double usagePercent = getUsagePercent(notIdleDiff, idleDiff);
+
+    // Calculate the jiffies passed
+    unsigned long long jiffiesPassed = counters_.getJiffies(index2) - counters_.getJiffies(index1);
+
+    return { usagePercent, jiffiesPassed, jiffiesPassed };
 }
 
-CpuUsageResult CpuUsageCalculator::calculateCpuUsagePercentForCore(int core) const {
-    return calculateCpuUsagePercentForCore(core,0,largestOccupiedIndex_);
+CpuUsageResult CpuUsageCalculator::calculateCpuUsagePercentForTotal() const {
+    return calculateCpuUsagePercentForCore(TOTAL_CPU_USAGE_INDEX);
 }
 
-CpuUsageResult CpuUsageCalculator::calculateCpuUsagePercentForCore(int core, size_t index1, size_t index2) const {
-    if (index1 >= bufferSize_ || index2 >= bufferSize_ || index1 == index2) {
-        Printer& printer = Printer::getInstance(); // Get instance of Printer
-
-        // Construct the buffer contents string
-        std::string bufferContents;
-        for (size_t i = 0; i < buffer_.size(); ++i) {
-            const DataPoint& dp = buffer_[i];
-            bufferContents += "Index " + std::to_string(i) + ": Jiffies: " + std::to_string(dp.jiffies) +
-                              ", TotalUser: " + std::to_string(dp.totalUser) +
-                              ", TotalUserLow: " + std::to_string(dp.totalUserLow) +
-                              ", TotalSys: " + std::to_string(dp.totalSys) +
-                              ", TotalIdle: " + std::to_string(dp.totalIdle) + "\n";
-        }
+unsigned long long CpuUsageCalculator::calculateCpuUsagePercent(double* usagePercent) const {
+    return calculateCpuUsagePercentForWindow(0, usagePercent);
+}
 
-        // Print warning with buffer contents
-        printer.printWarning("Invalid indices. Variable Values: Buffer current size: " + std::to_string(buffer_.size()) +
-                             "/" + std::to_string(bufferSize_) + ", Index1: " + std::to_string(index1) +
-                             ", Index2: " + std::to_string(index2) + "\nBuffer Contents:\n" + bufferContents, __LINE__, __FILE__, -1);
+unsigned long long CpuUsageCalculator::calculateCpuUsagePercentForWindow(size_t window, double* usagePercent) const {
+    return calculateCpuUsagePercent(getWindowStartIndex(window), counters_.size() == 0 ? 0 : counters_.size() - 1, usagePercent);
+}
 
-        return { -1.0, 0 }; // Invalid indices
+unsigned long long CpuUsageCalculator::calculateCpuUsagePercent(size_t index1, size_t index2, double* usagePercent) const {
+    size_t numRows = counters_.getNumRows();
+    if (index1 >= counters_.size() || index2 >= counters_.size() || index1 == index2) {
+        for (size_t row = 0; row < numRows; ++row) {
+            usagePercent[row] = -1.0;
+        }
+        return 0;
     }
 
-    const DataPoint& dataPoint1 = buffer_[index1];
-    const DataPoint& dataPoint2 = buffer_[index2];
+    const unsigned long long* user1 = counters_.getColumn(USER_COLUMN, index1);
+    const unsigned long long* user2 = counters_.getColumn(USER_COLUMN, index2);
+    const unsigned long long* userLow1 = counters_.getColumn(USER_LOW_COLUMN, index1);
+    const unsigned long long* userLow2 = counters_.getColumn(USER_LOW_COLUMN, index2);
+    const unsigned long long* sys1 = counters_.getColumn(SYS_COLUMN, index1);
+    const unsigned long long* sys2 = counters_.getColumn(SYS_COLUMN, index2);
+    const unsigned long long* idle1 = counters_.getColumn(IDLE_COLUMN, index1);
+    const unsigned long long* idle2 = counters_.getColumn(IDLE_COLUMN, index2);
+
+    // Branch-free loop over contiguous columns so the compiler can vectorize it
+    for (size_t row = 0; row < numRows; ++row) {
+        double notIdleDiff = static_cast<double>((user2[row] - user1[row]) + (userLow2[row] - userLow1[row]) + (sys2[row] - sys1[row]));
+        usagePercent[row] = getUsagePercent(notIdleDiff, static_cast<double>(idle2[row] - idle1[row]));
+    }
 
-    double notIdleDiff = (dataPoint2.totalUser - dataPoint1.totalUser) +
-                         (dataPoint2.totalUserLow - dataPoint1.totalUserLow) +
-                         (dataPoint2.totalSys - dataPoint1.totalSys);
-    double idleDiff = dataPoint2.totalIdle - dataPoint1.totalIdle;
+    return counters_.getJiffies(index2) - counters_.getJiffies(index1);
+}
 
-    double usagePercent = (notIdleDiff + idleDiff > 0) ? (notIdleDiff / (notIdleDiff + idleDiff)) * 100.0 : -1.0;
+std::vector<unsigned long long> CpuUsageCalculator::getConfiguredWindowsJiffies() {
+    ConfigManager& configManager = ConfigManager::getInstance();
 
-    // Calculate the jiffies passed
-    unsigned long long jiffiesPassed = dataPoint2.jiffies - dataPoint1.jiffies;
+    // Window 0 is the average period, the configured windows follow without duplicates
+    std::vector<unsigned long long> windowsJiffies(1, static_cast<unsigned long long>(configManager.getAveragePeriodJiffies()));
+    for (int window : configManager.getAverageWindowsJiffies()) {
+        unsigned long long windowJiffies = static_cast<unsigned long long>(window > 0 ? window : 0);
+        if (windowJiffies > 0 && std::find(windowsJiffies.begin(), windowsJiffies.end(), windowJiffies) == windowsJiffies.end()) {
+            windowsJiffies.push_back(windowJiffies);
+        }
+    }
+    return windowsJiffies;
+}
 
-    return { usagePercent, jiffiesPassed };
+std::string CpuUsageCalculator::dumpRow(size_t row) const {
+    std::string bufferContents;
+    for (size_t i = 0; i < counters_.size() && row < counters_.getNumRows(); ++i) {
+        bufferContents += "Index " + std::to_string(i) + ": Jiffies: " + std::to_string(counters_.getJiffies(i)) +
+                          ", TotalUser: " + std::to_string(counters_.getColumn(USER_COLUMN, i)[row]) +
+                          ", TotalUserLow: " + std::to_string(counters_.getColumn(USER_LOW_COLUMN, i)[row]) +
+                          ", TotalSys: " + std::to_string(counters_.getColumn(SYS_COLUMN, i)[row]) +
+                          ", TotalIdle: " + std::to_string(counters_.getColumn(IDLE_COLUMN, i)[row]) + "\n";
+    }
+    return bufferContents;
 }
 
-void CpuUsageCalculator::addDataPointForTotal(unsigned long long totalUser, unsigned long long totalUserLow,
-                                              unsigned long long totalSys, unsigned long long totalIdle, unsigned long long jiffies) {
-    addDataPointForCore(TOTAL_CPU_USAGE_INDEX, totalUser, totalUserLow, totalSys, totalIdle, jiffies);
+size_t CpuUsageCalculator::getNumWindows() const {
+    return windowsJiffies_.size();
 }
 
-CpuUsageResult CpuUsageCalculator::calculateCpuUsagePercentForTotal(size_t index1, size_t index2) const {
-    return calculateCpuUsagePercentForCore(TOTAL_CPU_USAGE_INDEX, index1, index2);
+unsigned long long CpuUsageCalculator::getWindowJiffies(size_t window) const {
+    return window < windowsJiffies_.size() ? windowsJiffies_[window] : 0;
 }
 
-CpuUsageResult CpuUsageCalculator::calculateCpuUsagePercentForTotal() const {
-    return calculateCpuUsagePercentForCore(TOTAL_CPU_USAGE_INDEX, 0, largestOccupiedIndex_);
+size_t CpuUsageCalculator::getWindowStartIndex(size_t window) const {
+    return counters_.findWindowStart(getWindowJiffies(window));
+}
+
+size_t CpuUsageCalculator::getNumRows() const {
+    return counters_.getNumRows();
 }
 
-size_t CpuUsageCalculator::getWrappedIndex(size_t index) const {
-    return index % bufferSize_;
+size_t CpuUsageCalculator::getRowForCore(int core) {
+    return static_cast<size_t>(core - TOTAL_CPU_USAGE_INDEX);
 }
@@ -0,0 +1,158 @@
+#include "DeadlineTimer.h"
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <ctime>
+
+static const long long NANOS_PER_SECOND = 1000000000LL;
+static const size_t MAX_EVENT_FDS = 64; // One bit each in the events of waitNextDeadline()
+
+DeadlineTimer::DeadlineTimer() : fd_(-1), periodNs_(0), nextDeadlineNs_(0), policy_(SKIP), pollFds_(1) {
+    pollFds_[0].fd = -1;
+    pollFds_[0].events = POLLIN;
+}
+
+DeadlineTimer::~DeadlineTimer() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool DeadlineTimer::start(long long periodNs, OverrunPolicy policy, long long alignNs) {
+    if (fd_ < 0) {
+        fd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+        if (fd_ < 0) {
+            return false;
+        }
+        pollFds_[0].fd = fd_;
+    }
+
+    periodNs_ = periodNs > 0 ? periodNs : 1;
+    policy_ = policy;
+
+    // Put the grid on a multiple of alignNs (e.g. a jiffy boundary)
+    long long now = getMonotonicNanos();
+    if (alignNs <= 0) {
+        alignNs = 1;
+    }
+    nextDeadlineNs_ = (now / alignNs + 1) * alignNs;
+    return true;
+}
+
+bool DeadlineTimer::waitNextDeadline(TickInfo& tick, unsigned long long* events) {
+    if (fd_ < 0) {
+        return false;
+    }
+
+    long long now = getMonotonicNanos();
+    tick.missedTicks = 0;
+
+    if (now < nextDeadlineNs_) {
+        // Sleep until the absolute deadline
+        struct itimerspec spec = {};
+        spec.it_value.tv_sec = static_cast<time_t>(nextDeadlineNs_ / NANOS_PER_SECOND);
+        spec.it_value.tv_nsec = static_cast<long>(nextDeadlineNs_ % NANOS_PER_SECOND);
+        if (::timerfd_settime(fd_, TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+            return false;
+        }
+
+        if (events != nullptr && pollFds_.size() > 1) {
+            // Arming the timer again on the next call resets its expirations, so an event may leave one unread
+            *events = 0;
+            if (!waitTimerOrEvents(*events)) {
+                return false;
+            }
+            if (*events != 0) {
+                return true;
+            }
+        } else {
+            uint64_t expirations;
+            while (::read(fd_, &expirations, sizeof(expirations)) < 0) {
+                if (errno != EINTR) {
+                    return false;
+                }
+            }
+        }
+        now = getMonotonicNanos();
+    } else if (policy_ == SKIP && now - nextDeadlineNs_ >= periodNs_) {
+        // Jump to the most recent deadline on the grid, dropping the ones in between
+        unsigned long long behind = static_cast<unsigned long long>((now - nextDeadlineNs_) / periodNs_);
+        tick.missedTicks = behind;
+        nextDeadlineNs_ += static_cast<long long>(behind) * periodNs_;
+    }
+
+    tick.deadlineNs = nextDeadlineNs_;
+    tick.latenessNs = now - nextDeadlineNs_;
+    nextDeadlineNs_ += periodNs_;
+    return true;
+}
+
+bool DeadlineTimer::waitTimerOrEvents(unsigned long long& events) {
+    for (;;) {
+        if (::poll(pollFds_.data(), static_cast<nfds_t>(pollFds_.size()), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        for (size_t i = 1; i < pollFds_.size(); ++i) {
+            if (pollFds_[i].revents & POLLPRI) {
+                events |= 1ULL << (i - 1);
+            }
+            if (pollFds_[i].revents & (POLLERR | POLLNVAL)) {
+                pollFds_[i].fd = -1; // poll() ignores it from now on instead of returning right away every time
+            }
+        }
+        if (events != 0) {
+            return true;
+        }
+
+        if (pollFds_[0].revents & POLLIN) {
+            uint64_t expirations;
+            if (::read(fd_, &expirations, sizeof(expirations)) >= 0) {
+                return true;
+            }
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+}
+
+bool DeadlineTimer::addEventFd(int fd) {
+    if (pollFds_.size() - 1 >= MAX_EVENT_FDS) {
+        return false;
+    }
+    struct pollfd eventFd = {};
+    eventFd.fd = fd;
+    eventFd.events = POLLPRI;
+    pollFds_.push_back(eventFd);
+    return true;
+}
+
+void DeadlineTimer::setPeriod(long long periodNs, OverrunPolicy policy) {
+    periodNs = periodNs > 0 ? periodNs : 1;
+    nextDeadlineNs_ += periodNs - periodNs_;
+    periodNs_ = periodNs;
+    policy_ = policy;
+}
+
+long long DeadlineTimer::getPeriodNs() const {
+    return periodNs_;
+}
+
+DeadlineTimer::OverrunPolicy DeadlineTimer::getOverrunPolicy() const {
+    return policy_;
+}
+
+long long DeadlineTimer::getMonotonicNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * NANOS_PER_SECOND + ts.tv_nsec;
+}
+
+DeadlineTimer::OverrunPolicy DeadlineTimer::parseOverrunPolicy(const std::string& policy) {
+    return policy == "catch_up" ? CATCH_UP : SKIP;
+}
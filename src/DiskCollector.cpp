@@ -0,0 +1,238 @@
+#include "DiskCollector.h"
+#include "ConfigManager.h"
+#include "Printer.h"
+#include "ProcParse.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const size_t DISKSTATS_BUFFER_SIZE = 16384;
+static const double BYTES_PER_SECTOR = 512.0; // diskstats counts 512-byte sectors whatever the device's block size
+
+// Name of a device line ("   8       0 sda 1234 ..."), p is left after the name
+static void parseDeviceName(const char*& p, const char* end, const char*& nameBegin, size_t& nameLength) {
+    ProcParse::skipToken(p, end); // major
+    ProcParse::skipToken(p, end); // minor
+    ProcParse::skipSpaces(p, end);
+    nameBegin = p;
+    ProcParse::skipToken(p, end);
+    nameLength = static_cast<size_t>(p - nameBegin);
+}
+
+// A partition follows its disk and is named after it: sda1 after sda, nvme0n1p1 after nvme0n1. After a disk whose
+// name ends in a digit the "p" is required, loop10 after loop1 and nbd12 after nbd1 are disks of their own.
+static bool isPartitionOf(const char* name, const char* disk) {
+    size_t diskLength = std::strlen(disk);
+    if (diskLength == 0 || std::strncmp(name, disk, diskLength) != 0) {
+        return false;
+    }
+    const char* suffix = name + diskLength;
+    if (disk[diskLength - 1] >= '0' && disk[diskLength - 1] <= '9') {
+        if (*suffix != 'p') {
+            return false;
+        }
+        ++suffix;
+    }
+    if (*suffix == '\0') {
+        return false;
+    }
+    for (; *suffix != '\0'; ++suffix) {
+        if (*suffix < '0' || *suffix > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+DiskCollector::DiskCollector() : DiskCollector(ConfigManager::getInstance().getProcPath("diskstats")) {
+}
+
+DiskCollector::DiskCollector(const std::string& path) : file_(path, DISKSTATS_BUFFER_SIZE), includePartitions_(false) {
+}
+
+const char* DiskCollector::getName() const {
+    return "disks";
+}
+
+void DiskCollector::init(unsigned long long jiffiesPerSecond, unsigned long long periodJiffies) {
+    int maxDevices = ConfigManager::getInstance().getMaxDiskDevices();
+    slots_.init(maxDevices > 0 ? static_cast<size_t>(maxDevices) : 0, "block device", "system_info.disks.max_devices");
+    readFilters();
+    inFlight_.assign(slots_.size(), 0);
+    counters_.init(NUM_COLUMNS, slots_.size(), jiffiesPerSecond, periodJiffies);
+
+    PRINT_INFO(2, "Disk collector reporting up to " + std::to_string(slots_.size()) + " devices.");
+}
+
+bool DiskCollector::reconfigure(unsigned long long periodJiffies) {
+    readFilters();
+    return counters_.reconfigure(periodJiffies);
+}
+
+void DiskCollector::readFilters() {
+    ConfigManager& configManager = ConfigManager::getInstance();
+    slots_.setFilters(configManager.getDiskDevices(), configManager.getExcludedDiskDevices());
+    includePartitions_ = configManager.getDiskPartitionsIncluded();
+}
+
+void DiskCollector::initSnapshot(SystemInfoData& data) {
+    DiskDeviceInfo empty;
+    empty.name[0] = '\0';
+    empty.read_iops = -1.0;
+    empty.write_iops = -1.0;
+    empty.read_bytes_per_second = -1.0;
+    empty.write_bytes_per_second = -1.0;
+    empty.await_ms = -1.0;
+    empty.queue_depth = -1.0;
+    empty.utilization_percent = -1.0;
+    empty.in_flight = 0;
+    empty.real_time_step = 0.0;
+    data.disk_devices.assign(slots_.size(), empty);
+    data.disk_utilization_percent_per_window.assign(counters_.getNumWindows() * slots_.size(), -1.0);
+    data.disk_await_ms_per_window.assign(counters_.getNumWindows() * slots_.size(), -1.0);
+
+    // Assign the slots and take the first sample right away
+    collect(data);
+}
+
+bool DiskCollector::collect(SystemInfoData& data) {
+    if (slots_.size() == 0) {
+        return true;
+    }
+
+    unsigned long long jiffies = counters_.getCurrentJiffy();
+    if (!file_.read() || (!parse() && !(buildLineTable(jiffies) && parse()))) {
+        PRINT_WARNING_RATE_LIMITED(-1, "Failed to update block devices from " + file_.getPath() + ".");
+        return false;
+    }
+    counters_.commit(jiffies);
+
+    fillSnapshot(data);
+    return true;
+}
+
+bool DiskCollector::parse() {
+    const char* p = file_.data();
+    const char* end = p + file_.size();
+
+    // Slots whose device has no line keep zeros
+    counters_.clearPending();
+    std::fill(inFlight_.begin(), inFlight_.end(), 0LL);
+    unsigned long long* columns[NUM_COLUMNS];
+    for (size_t column = 0; column < NUM_COLUMNS; ++column) {
+        columns[column] = counters_.getPendingColumn(column);
+    }
+
+    size_t lineIndex = 0;
+    while (p < end) {
+        const char* name;
+        size_t nameLength;
+        parseDeviceName(p, end, name, nameLength);
+        if (!slots_.matchesLine(lineIndex, name, nameLength)) {
+            return false;
+        }
+
+        // reads merged sectors ms, writes merged sectors ms, in_flight io_ms weighted_io_ms, then discards and flushes
+        int slot = slots_.getLineSlot(lineIndex);
+        if (slot >= 0) {
+            columns[READS_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+            ProcParse::skipToken(p, end);
+            columns[SECTORS_READ_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+            columns[READ_MS_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+            columns[WRITES_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+            ProcParse::skipToken(p, end);
+            columns[SECTORS_WRITTEN_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+            columns[WRITE_MS_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+            inFlight_[slot] = static_cast<long long>(ProcParse::parseUnsigned(p, end));
+            columns[IO_MS_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+            columns[WEIGHTED_IO_MS_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+        }
+        ProcParse::nextLine(p, end);
+        ++lineIndex;
+    }
+    return lineIndex == slots_.getNumLines();
+}
+
+bool DiskCollector::buildLineTable(unsigned long long jiffies) {
+    const char* p = file_.data();
+    const char* end = p + file_.size();
+
+    slots_.clearLines();
+    char name[NamedSlotTable::NAME_SIZE];
+    char lastDisk[NamedSlotTable::NAME_SIZE] = "";
+    while (p < end) {
+        const char* nameBegin;
+        size_t nameLength;
+        parseDeviceName(p, end, nameBegin, nameLength);
+        if (nameLength == 0) {
+            return false;
+        }
+
+        size_t copyLength = std::min(nameLength, sizeof(name) - 1);
+        std::memcpy(name, nameBegin, copyLength);
+        name[copyLength] = '\0';
+        bool partition = isPartitionOf(name, lastDisk);
+        slots_.addLine(nameBegin, nameLength, (includePartitions_ || !partition) && slots_.matchesFilters(name));
+        if (!partition) {
+            std::memcpy(lastDisk, name, sizeof(lastDisk));
+        }
+        ProcParse::nextLine(p, end);
+    }
+    slots_.assignSlots(jiffies);
+    return true;
+}
+
+void DiskCollector::fillSnapshot(SystemInfoData& data) {
+    size_t numSlots = slots_.size();
+    double jiffiesPerSecond = static_cast<double>(counters_.getJiffiesPerSecond());
+
+    for (size_t window = 0; window < counters_.getNumWindows(); ++window) {
+        size_t windowStart = counters_.findWindowStart(window);
+        double* utilizationPercent = data.disk_utilization_percent_per_window.data() + window * numSlots;
+        double* awaitMs = data.disk_await_ms_per_window.data() + window * numSlots;
+
+        for (size_t index = 0; index < numSlots; ++index) {
+            const char* name = slots_.getName(index);
+            DiskDeviceInfo& info = data.disk_devices[index];
+            utilizationPercent[index] = -1.0;
+            awaitMs[index] = -1.0;
+            if (window == 0) {
+                std::snprintf(info.name, sizeof(info.name), "%s", name);
+                info.read_iops = -1.0;
+                info.write_iops = -1.0;
+                info.read_bytes_per_second = -1.0;
+                info.write_bytes_per_second = -1.0;
+                info.await_ms = -1.0;
+                info.queue_depth = -1.0;
+                info.utilization_percent = -1.0;
+                info.in_flight = name[0] != '\0' ? inFlight_[index] : 0;
+                info.real_time_step = 0.0;
+            }
+
+            unsigned long long deltas[NUM_COLUMNS];
+            unsigned long long jiffiesPassed;
+            if (name[0] == '\0' || !counters_.getDeltas(windowStart, index, slots_.getFirstJiffies(index), deltas, jiffiesPassed)) {
+                continue;
+            }
+
+            // The same arithmetic as iostat: await over completed requests, utilization and queue depth over wall time
+            double seconds = static_cast<double>(jiffiesPassed) / jiffiesPerSecond;
+            unsigned long long requests = deltas[READS_COLUMN] + deltas[WRITES_COLUMN];
+            double await = requests > 0 ? static_cast<double>(deltas[READ_MS_COLUMN] + deltas[WRITE_MS_COLUMN]) / requests : 0.0;
+            double elapsedMs = seconds * 1000.0;
+            utilizationPercent[index] = std::min(100.0, 100.0 * static_cast<double>(deltas[IO_MS_COLUMN]) / elapsedMs);
+            awaitMs[index] = await;
+
+            if (window == 0) {
+                info.read_iops = static_cast<double>(deltas[READS_COLUMN]) / seconds;
+                info.write_iops = static_cast<double>(deltas[WRITES_COLUMN]) / seconds;
+                info.read_bytes_per_second = static_cast<double>(deltas[SECTORS_READ_COLUMN]) * BYTES_PER_SECTOR / seconds;
+                info.write_bytes_per_second = static_cast<double>(deltas[SECTORS_WRITTEN_COLUMN]) * BYTES_PER_SECTOR / seconds;
+                info.await_ms = await;
+                info.queue_depth = static_cast<double>(deltas[WEIGHTED_IO_MS_COLUMN]) / elapsedMs;
+                info.utilization_percent = utilizationPercent[index];
+                info.real_time_step = seconds;
+            }
+        }
+    }
+}
@@ -0,0 +1,367 @@
+#include "HistoryStore.h"
+#include "SnapshotFields.h"
+#include <algorithm>
+#include <cstring>
+
+const long long HistoryStore::TIME_RESOLUTION_NS = 1000000LL;
+
+static const size_t MIN_BLOCK_BYTES = 64;
+static const uint32_t FIRST_POINT_BITS = 128; // Raw timestamp and value
+static const uint32_t MAX_POINT_BITS = 36 + 77; // Widest timestamp ('1111' + 32) and value ('11' + 5 + 6 + 64)
+
+// Appends the count low bits of value to a zero-filled block, most significant bit first
+static void putBits(uint8_t* bytes, uint32_t& bitLength, uint64_t value, int count) {
+    while (count > 0) {
+        int used = static_cast<int>(bitLength & 7);
+        int take = std::min(count, 8 - used);
+        uint8_t chunk = static_cast<uint8_t>((value >> (count - take)) & ((1u << take) - 1));
+        bytes[bitLength >> 3] |= static_cast<uint8_t>(chunk << (8 - used - take));
+        bitLength += static_cast<uint32_t>(take);
+        count -= take;
+    }
+}
+
+static uint64_t getBits(const uint8_t* bytes, uint32_t& position, int count) {
+    uint64_t value = 0;
+    while (count > 0) {
+        int used = static_cast<int>(position & 7);
+        int take = std::min(count, 8 - used);
+        uint64_t chunk = (bytes[position >> 3] >> (8 - used - take)) & ((1u << take) - 1);
+        value = (value << take) | chunk;
+        position += static_cast<uint32_t>(take);
+        count -= take;
+    }
+    return value;
+}
+
+static long long floorDivide(long long value, long long divisor) {
+    long long quotient = value / divisor;
+    return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+}
+
+// Feeds every metric of a snapshot, in schema order, to its series
+class HistoryStore::Appender {
+public:
+    Appender(HistoryStore& store, long long time) : store_(store), time_(time), series_(0) {}
+
+    void visitInt(const SnapshotFieldName&, long long value) {
+        int64_t fixed = static_cast<int64_t>(value);
+        uint64_t bits;
+        std::memcpy(&bits, &fixed, sizeof(bits));
+        add(bits);
+    }
+
+    void visitDouble(const SnapshotFieldName&, double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        add(bits);
+    }
+
+private:
+    void add(uint64_t bits) {
+        if (series_ < store_.series_.size()) {
+            store_.appendPoint(series_, time_, bits);
+        }
+        ++series_;
+    }
+
+    HistoryStore& store_;
+    long long time_;
+    size_t series_;
+};
+
+HistoryStore::HistoryStore() : blockBytes_(0), blocksPerSeries_(0) {
+}
+
+void HistoryStore::init(const SnapshotSchema& schema, size_t budgetBytes, size_t blockBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::vector<SnapshotSchema::Field>& fields = schema.getFields();
+    blockBytes_ = std::max(blockBytes, MIN_BLOCK_BYTES);
+    blocksPerSeries_ = fields.empty() ? 0 : std::max<size_t>(2, budgetBytes / (fields.size() * blockBytes_));
+
+    series_.clear();
+    series_.reserve(fields.size());
+    for (size_t i = 0; i < fields.size(); ++i) {
+        Series series = {};
+        series.name = fields[i].name;
+        series.isInteger = fields[i].type == SnapshotSchema::INT64;
+        series.firstBlock = i * blocksPerSeries_;
+        series.previousLeading = -1;
+        series_.push_back(series);
+    }
+    blocks_.assign(fields.size() * blocksPerSeries_, Block{ 0, 0, 0, 0 });
+    storage_.assign(blocks_.size() * blockBytes_, 0);
+}
+
+bool HistoryStore::isEnabled() const {
+    return !series_.empty();
+}
+
+void HistoryStore::append(const SystemInfoData& data) {
+    if (series_.empty()) {
+        return;
+    }
+    // The deadline on the jiffy grid keeps the deltas regular, most timestamps then cost a single bit
+    long long time = floorDivide(data.time_stamp_ns - data.sample_lateness_ns, TIME_RESOLUTION_NS);
+    std::lock_guard<std::mutex> lock(mutex_);
+    Appender appender(*this, time);
+    forEachSnapshotField(data, appender);
+}
+
+void HistoryStore::startBlock(Series& series, long long time, uint64_t value) {
+    size_t blockIndex = series.firstBlock + series.currentBlock;
+    Block& block = blocks_[blockIndex];
+    uint8_t* bytes = &storage_[blockIndex * blockBytes_];
+    std::memset(bytes, 0, blockBytes_);
+
+    // The oldest block of the series is overwritten, its points are gone
+    block.bitLength = 0;
+    putBits(bytes, block.bitLength, static_cast<uint64_t>(time), 64);
+    putBits(bytes, block.bitLength, value, 64);
+    block.numPoints = 1;
+    block.minTime = time;
+    block.maxTime = time;
+
+    series.previousTime = time;
+    series.previousDelta = 0;
+    series.previousValue = value;
+    series.previousLeading = -1;
+    series.previousTrailing = 0;
+}
+
+void HistoryStore::appendPoint(size_t seriesIndex, long long time, uint64_t value) {
+    Series& series = series_[seriesIndex];
+    Block* block = &blocks_[series.firstBlock + series.currentBlock];
+    if (block->numPoints == 0) {
+        startBlock(series, time, value);
+        return;
+    }
+
+    long long delta = time - series.previousTime;
+    long long deltaOfDelta = delta - series.previousDelta;
+    if (block->bitLength + MAX_POINT_BITS > blockBytes_ * 8 || deltaOfDelta < INT32_MIN || deltaOfDelta > INT32_MAX) {
+        // Move on to the next block of the ring, which starts over with raw values
+        series.currentBlock = (series.currentBlock + 1) % blocksPerSeries_;
+        startBlock(series, time, value);
+        return;
+    }
+
+    uint8_t* bytes = &storage_[(series.firstBlock + series.currentBlock) * blockBytes_];
+    uint32_t& bits = block->bitLength;
+
+    // Timestamp: delta of delta in the smallest bucket it fits
+    if (deltaOfDelta == 0) {
+        putBits(bytes, bits, 0, 1);
+    } else if (deltaOfDelta >= -63 && deltaOfDelta <= 64) {
+        putBits(bytes, bits, 2, 2);
+        putBits(bytes, bits, static_cast<uint64_t>(deltaOfDelta + 63), 7);
+    } else if (deltaOfDelta >= -255 && deltaOfDelta <= 256) {
+        putBits(bytes, bits, 6, 3);
+        putBits(bytes, bits, static_cast<uint64_t>(deltaOfDelta + 255), 9);
+    } else if (deltaOfDelta >= -2047 && deltaOfDelta <= 2048) {
+        putBits(bytes, bits, 14, 4);
+        putBits(bytes, bits, static_cast<uint64_t>(deltaOfDelta + 2047), 12);
+    } else {
+        putBits(bytes, bits, 15, 4);
+        putBits(bytes, bits, static_cast<uint32_t>(static_cast<int32_t>(deltaOfDelta)), 32);
+    }
+
+    // Value: XOR with the previous one, reusing the previous window of meaningful bits when it fits
+    uint64_t xorValue = value ^ series.previousValue;
+    if (xorValue == 0) {
+        putBits(bytes, bits, 0, 1);
+    } else {
+        int leading = std::min(__builtin_clzll(xorValue), 31);
+        int trailing = __builtin_ctzll(xorValue);
+        if (series.previousLeading >= 0 && leading >= series.previousLeading && trailing >= series.previousTrailing) {
+            putBits(bytes, bits, 2, 2);
+            putBits(bytes, bits, xorValue >> series.previousTrailing, 64 - series.previousLeading - series.previousTrailing);
+        } else {
+            int meaningful = 64 - leading - trailing;
+            putBits(bytes, bits, 3, 2);
+            putBits(bytes, bits, static_cast<uint64_t>(leading), 5);
+            putBits(bytes, bits, static_cast<uint64_t>(meaningful - 1), 6);
+            putBits(bytes, bits, xorValue >> trailing, meaningful);
+            series.previousLeading = leading;
+            series.previousTrailing = trailing;
+        }
+    }
+
+    ++block->numPoints;
+    block->minTime = std::min(block->minTime, time);
+    block->maxTime = std::max(block->maxTime, time);
+    series.previousTime = time;
+    series.previousDelta = delta;
+    series.previousValue = value;
+}
+
+void HistoryStore::decodeBlock(const uint8_t* bytes, const Block& block, bool isInteger, std::vector<HistoryPoint>& points) {
+    uint32_t position = 0;
+    long long time = static_cast<long long>(getBits(bytes, position, 64));
+    uint64_t value = getBits(bytes, position, 64);
+    long long delta = 0;
+    int leading = 0;
+    int trailing = 0;
+
+    for (uint32_t i = 0; i < block.numPoints; ++i) {
+        if (i > 0) {
+            long long deltaOfDelta;
+            if (getBits(bytes, position, 1) == 0) {
+                deltaOfDelta = 0;
+            } else if (getBits(bytes, position, 1) == 0) {
+                deltaOfDelta = static_cast<long long>(getBits(bytes, position, 7)) - 63;
+            } else if (getBits(bytes, position, 1) == 0) {
+                deltaOfDelta = static_cast<long long>(getBits(bytes, position, 9)) - 255;
+            } else if (getBits(bytes, position, 1) == 0) {
+                deltaOfDelta = static_cast<long long>(getBits(bytes, position, 12)) - 2047;
+            } else {
+                deltaOfDelta = static_cast<int32_t>(static_cast<uint32_t>(getBits(bytes, position, 32)));
+            }
+            delta += deltaOfDelta;
+            time += delta;
+
+            if (getBits(bytes, position, 1) != 0) {
+                if (getBits(bytes, position, 1) != 0) {
+                    leading = static_cast<int>(getBits(bytes, position, 5));
+                    int meaningful = static_cast<int>(getBits(bytes, position, 6)) + 1;
+                    trailing = 64 - leading - meaningful;
+                }
+                value ^= getBits(bytes, position, 64 - leading - trailing) << trailing;
+            }
+        }
+
+        HistoryPoint point;
+        point.timeNs = time * TIME_RESOLUTION_NS;
+        if (isInteger) {
+            int64_t fixed;
+            std::memcpy(&fixed, &value, sizeof(fixed));
+            point.value = static_cast<double>(fixed);
+        } else {
+            std::memcpy(&point.value, &value, sizeof(point.value));
+        }
+        points.push_back(point);
+    }
+}
+
+template<typename Function>
+void HistoryStore::forEachPoint(int seriesIndex, long long startNs, long long endNs, Function function) const {
+    if (seriesIndex < 0 || static_cast<size_t>(seriesIndex) >= series_.size() || startNs >= endNs) {
+        return;
+    }
+
+    // Copy the blocks overlapping the range, oldest first, and decode them once the sampler can go on
+    std::vector<Block> blocks;
+    std::vector<uint8_t> bytes;
+    bool isInteger;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const Series& series = series_[seriesIndex];
+        isInteger = series.isInteger;
+        for (size_t i = 1; i <= blocksPerSeries_; ++i) {
+            size_t blockIndex = series.firstBlock + (series.currentBlock + i) % blocksPerSeries_;
+            const Block& block = blocks_[blockIndex];
+            if (block.numPoints == 0 || block.maxTime * TIME_RESOLUTION_NS < startNs || block.minTime * TIME_RESOLUTION_NS >= endNs) {
+                continue;
+            }
+            blocks.push_back(block);
+            const uint8_t* blockBytes = &storage_[blockIndex * blockBytes_];
+            bytes.insert(bytes.end(), blockBytes, blockBytes + (block.bitLength + 7) / 8);
+        }
+    }
+
+    std::vector<HistoryPoint> points;
+    size_t offset = 0;
+    for (const Block& block : blocks) {
+        points.clear();
+        decodeBlock(&bytes[offset], block, isInteger, points);
+        offset += (block.bitLength + 7) / 8;
+        for (const HistoryPoint& point : points) {
+            if (point.timeNs >= startNs && point.timeNs < endNs) {
+                function(point);
+            }
+        }
+    }
+}
+
+size_t HistoryStore::query(int series, long long startNs, long long endNs, std::vector<HistoryPoint>& points) const {
+    size_t before = points.size();
+    forEachPoint(series, startNs, endNs, [&points](const HistoryPoint& point) {
+        points.push_back(point);
+    });
+    return points.size() - before;
+}
+
+size_t HistoryStore::queryAggregated(int series, long long startNs, long long endNs, long long bucketNs,
+                                     std::vector<HistoryAggregate>& aggregates) const {
+    if (bucketNs <= 0) {
+        return 0;
+    }
+
+    size_t before = aggregates.size();
+    HistoryAggregate current = {};
+    double sum = 0;
+    forEachPoint(series, startNs, endNs, [&](const HistoryPoint& point) {
+        long long bucketStart = startNs + (point.timeNs - startNs) / bucketNs * bucketNs;
+        if (current.count > 0 && bucketStart != current.startNs) {
+            current.mean = sum / current.count;
+            aggregates.push_back(current);
+            current.count = 0;
+        }
+        if (current.count == 0) {
+            current.startNs = bucketStart;
+            current.min = point.value;
+            current.max = point.value;
+            sum = 0;
+        }
+        current.lastNs = point.timeNs;
+        current.min = std::min(current.min, point.value);
+        current.max = std::max(current.max, point.value);
+        current.last = point.value;
+        sum += point.value;
+        ++current.count;
+    });
+    if (current.count > 0) {
+        current.mean = sum / current.count;
+        aggregates.push_back(current);
+    }
+    return aggregates.size() - before;
+}
+
+int HistoryStore::findSeries(const std::string& metric) const {
+    for (size_t i = 0; i < series_.size(); ++i) {
+        if (series_[i].name == metric) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+const std::string& HistoryStore::getSeriesName(int series) const {
+    return series_.at(static_cast<size_t>(series)).name;
+}
+
+size_t HistoryStore::getNumSeries() const {
+    return series_.size();
+}
+
+size_t HistoryStore::getMemoryBudget() const {
+    return storage_.size();
+}
+
+size_t HistoryStore::getMemoryUsed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t used = 0;
+    for (const Block& block : blocks_) {
+        used += (block.bitLength + 7) / 8;
+    }
+    return used;
+}
+
+unsigned long long HistoryStore::getNumPoints() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unsigned long long numPoints = 0;
+    for (const Block& block : blocks_) {
+        numPoints += block.numPoints;
+    }
+    return numPoints;
+}
@@ -24,8 +24,11 @@ JsonManager::JsonManager(const std::string& configFile) : configFilePath(configF
 
 void JsonManager::loadConfigFile() {
     // Load the JSON configuration from the file and replace environment variables
-    config = readConfigFile(configFilePath);
-    config = replaceEnvironmentVariables(config);
+    config = parseConfigFile(configFilePath);
+}
+
+nlohmann::json JsonManager::parseConfigFile(const std::string& configFile) {
+    return replaceEnvironmentVariables(readConfigFile(configFile));
 }
 
 const nlohmann::json& JsonManager::getConfig() const {
@@ -0,0 +1,124 @@
+#include "LatencyHistogram.h"
+#include <cmath>
+#include <cstring>
+
+const int LatencyHistogram::SUB_BUCKET_BITS;
+const long long LatencyHistogram::SUB_BUCKETS;
+const int LatencyHistogram::MAX_EXPONENT;
+const long long LatencyHistogram::MAX_VALUE_NS;
+const size_t LatencyHistogram::NUM_BUCKETS;
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::record(long long valueNs) {
+    if (valueNs < 0) {
+        valueNs = 0;
+    } else if (valueNs > MAX_VALUE_NS) {
+        valueNs = MAX_VALUE_NS;
+    }
+    ++buckets_[getBucketIndex(valueNs)];
+    if (count_ == 0 || valueNs < min_) {
+        min_ = valueNs;
+    }
+    if (count_ == 0 || valueNs > max_) {
+        max_ = valueNs;
+    }
+    ++count_;
+    sum_ += static_cast<double>(valueNs);
+    sumOfSquares_ += static_cast<double>(valueNs) * static_cast<double>(valueNs);
+}
+
+void LatencyHistogram::reset() {
+    std::memset(buckets_, 0, sizeof(buckets_));
+    count_ = 0;
+    min_ = 0;
+    max_ = 0;
+    sum_ = 0;
+    sumOfSquares_ = 0;
+}
+
+unsigned long long LatencyHistogram::getCount() const {
+    return count_;
+}
+
+long long LatencyHistogram::getMin() const {
+    return min_;
+}
+
+long long LatencyHistogram::getMax() const {
+    return max_;
+}
+
+double LatencyHistogram::getMean() const {
+    return count_ == 0 ? 0.0 : sum_ / static_cast<double>(count_);
+}
+
+double LatencyHistogram::getStdDev() const {
+    if (count_ == 0) {
+        return 0.0;
+    }
+    double mean = getMean();
+    double variance = sumOfSquares_ / static_cast<double>(count_) - mean * mean;
+    return variance > 0 ? std::sqrt(variance) : 0.0;
+}
+
+long long LatencyHistogram::getValueAtPercentile(double percentile) const {
+    long long value;
+    getValuesAtPercentiles(&percentile, 1, &value);
+    return value;
+}
+
+void LatencyHistogram::getValuesAtPercentiles(const double* percentiles, size_t count, long long* values) const {
+    size_t next = 0;
+    unsigned long long seen = 0;
+    unsigned long long target = 0;
+    if (count > 0) {
+        target = getTargetCount(percentiles[0]);
+    }
+    for (size_t index = 0; index < NUM_BUCKETS && next < count && count_ > 0; ++index) {
+        seen += buckets_[index];
+        // Several percentiles may fall into the same bucket
+        while (next < count && seen >= target) {
+            long long upperBound = getBucketUpperBound(index);
+            values[next] = upperBound < max_ ? upperBound : max_;
+            if (++next < count) {
+                target = getTargetCount(percentiles[next]);
+            }
+        }
+    }
+    for (; next < count; ++next) {
+        values[next] = max_; // Nothing recorded, or a percentile above 100
+    }
+}
+
+unsigned long long LatencyHistogram::getTargetCount(double percentile) const {
+    // Number of values at or below the percentile, at least one so that 0 % is the minimum
+    double target = std::ceil(percentile / 100.0 * static_cast<double>(count_));
+    if (target < 1.0) {
+        return 1;
+    }
+    return target > static_cast<double>(count_) ? count_ + 1 : static_cast<unsigned long long>(target);
+}
+
+size_t LatencyHistogram::getBucketIndex(long long valueNs) {
+    unsigned long long value = static_cast<unsigned long long>(valueNs);
+    if (value < static_cast<unsigned long long>(SUB_BUCKETS)) {
+        return static_cast<size_t>(value); // One bucket per nanosecond below SUB_BUCKETS
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    int shift = exponent - SUB_BUCKET_BITS;
+    size_t subBucket = static_cast<size_t>((value >> shift) - SUB_BUCKETS);
+    return static_cast<size_t>(SUB_BUCKETS) + static_cast<size_t>(shift) * static_cast<size_t>(SUB_BUCKETS) + subBucket;
+}
+
+long long LatencyHistogram::getBucketUpperBound(size_t index) {
+    if (index < static_cast<size_t>(SUB_BUCKETS)) {
+        return static_cast<long long>(index);
+    }
+    size_t shift = (index - static_cast<size_t>(SUB_BUCKETS)) / static_cast<size_t>(SUB_BUCKETS);
+    long long subBucket = static_cast<long long>((index - static_cast<size_t>(SUB_BUCKETS)) % static_cast<size_t>(SUB_BUCKETS));
+    long long lowerBound = (SUB_BUCKETS + subBucket) << shift;
+    return lowerBound + (1LL << shift) - 1;
+}
@@ -0,0 +1,36 @@
+#include "LoadAverageCollector.h"
+#include "ConfigManager.h"
+#include "Printer.h"
+#include "ProcParse.h"
+
+static const size_t LOADAVG_BUFFER_SIZE = 128;
+
+LoadAverageCollector::LoadAverageCollector() : LoadAverageCollector(ConfigManager::getInstance().getProcPath("loadavg")) {
+}
+
+LoadAverageCollector::LoadAverageCollector(const std::string& path) : file_(path, LOADAVG_BUFFER_SIZE) {
+}
+
+const char* LoadAverageCollector::getName() const {
+    return "load_average";
+}
+
+void LoadAverageCollector::initSnapshot(SystemInfoData& data) {
+    data.load_avg_1min = 0;
+    data.load_avg_5min = 0;
+    data.load_avg_15min = 0;
+
+    // Cheap enough to take a first sample right away, so readers never see zeros
+    collect(data);
+}
+
+bool LoadAverageCollector::collect(SystemInfoData& data) {
+    if (!file_.read()) {
+        PRINT_WARNING_RATE_LIMITED(-1, "Failed to update load averages from " + file_.getPath() + ".");
+        return false;
+    }
+
+    const char* p = file_.data();
+    ProcParse::parseLoadAverages(p, p + file_.size(), data.load_avg_1min, data.load_avg_5min, data.load_avg_15min);
+    return true;
+}
@@ -0,0 +1,135 @@
+#include "MemoryCollector.h"
+#include "ConfigManager.h"
+#include "Printer.h"
+#include "ProcParse.h"
+#include <cstddef>
+#include <cstring>
+
+// Keys of /proc/meminfo that are reported, and where they go
+struct MemInfoKey {
+    const char* key;
+    std::ptrdiff_t offset;
+};
+
+static const MemInfoKey MEMINFO_KEYS[] = {
+    { "MemTotal", offsetof(MemoryInfo, total_bytes) },
+    { "MemFree", offsetof(MemoryInfo, free_bytes) },
+    { "MemAvailable", offsetof(MemoryInfo, available_bytes) },
+    { "Buffers", offsetof(MemoryInfo, buffers_bytes) },
+    { "Cached", offsetof(MemoryInfo, cached_bytes) },
+    { "Shmem", offsetof(MemoryInfo, shmem_bytes) },
+    { "SReclaimable", offsetof(MemoryInfo, slab_reclaimable_bytes) },
+    { "Dirty", offsetof(MemoryInfo, dirty_bytes) },
+    { "Writeback", offsetof(MemoryInfo, writeback_bytes) },
+    { "Committed_AS", offsetof(MemoryInfo, committed_as_bytes) },
+    { "SwapTotal", offsetof(MemoryInfo, swap_total_bytes) },
+    { "SwapFree", offsetof(MemoryInfo, swap_free_bytes) },
+    { "SwapCached", offsetof(MemoryInfo, swap_cached_bytes) },
+    { "HugePages_Total", offsetof(MemoryInfo, huge_pages_total) },
+    { "HugePages_Free", offsetof(MemoryInfo, huge_pages_free) },
+    { "Hugepagesize", offsetof(MemoryInfo, huge_page_size_bytes) },
+};
+
+static const size_t MEMINFO_BUFFER_SIZE = 8192;
+
+MemoryCollector::MemoryCollector() : MemoryCollector(ConfigManager::getInstance().getProcPath("meminfo")) {
+}
+
+MemoryCollector::MemoryCollector(const std::string& path) : file_(path, MEMINFO_BUFFER_SIZE), hasMemAvailable_(false) {
+}
+
+const char* MemoryCollector::getName() const {
+    return "memory";
+}
+
+void MemoryCollector::initSnapshot(SystemInfoData& data) {
+    data.total_ram = 0;
+    data.free_ram = 0;
+    data.total_ram_MB = 0;
+    data.free_ram_MB = 0;
+    std::memset(&data.memory, 0, sizeof(data.memory));
+
+    if (!buildLineTable()) {
+        PRINT_WARNING(-1, "Failed to read " + file_.getPath() + " for memory information.");
+    }
+
+    // Cheap enough to take a first sample right away, so readers never see zeros
+    collect(data);
+}
+
+bool MemoryCollector::collect(SystemInfoData& data) {
+    MemoryInfo& memory = data.memory;
+    if (!file_.read() || (!parse(memory) && !(buildLineTable() && parse(memory)))) {
+        PRINT_WARNING_RATE_LIMITED(-1, "Failed to update memory information.");
+        return false;
+    }
+
+    if (!hasMemAvailable_) {
+        memory.available_bytes = estimateAvailableBytes(memory.free_bytes, memory.buffers_bytes, memory.cached_bytes);
+    }
+    memory.used_bytes = memory.total_bytes > memory.available_bytes ? memory.total_bytes - memory.available_bytes : 0;
+    memory.swap_used_bytes = memory.swap_total_bytes > memory.swap_free_bytes ? memory.swap_total_bytes - memory.swap_free_bytes : 0;
+
+    // The legacy fields keep their sysinfo() meaning, free RAM excludes the page cache
+    data.total_ram = static_cast<long>(memory.total_bytes);
+    data.free_ram = static_cast<long>(memory.free_bytes);
+    data.total_ram_MB = static_cast<long>(memory.total_bytes / 1024 / 1024); // Convert to MB
+    data.free_ram_MB = static_cast<long>(memory.free_bytes / 1024 / 1024); // Convert to MB
+    return true;
+}
+
+unsigned long long MemoryCollector::estimateAvailableBytes(unsigned long long freeBytes, unsigned long long buffersBytes, unsigned long long cachedBytes) {
+    return freeBytes + buffersBytes + cachedBytes;
+}
+
+bool MemoryCollector::buildLineTable() {
+    if (!file_.read()) {
+        return false;
+    }
+
+    lineTable_.clear();
+    hasMemAvailable_ = false;
+    const char* p = file_.data();
+    const char* end = p + file_.size();
+    while (p < end) {
+        const char* colon = p;
+        while (colon < end && *colon != ':' && *colon != '\n') {
+            ++colon;
+        }
+
+        LineField field = { nullptr, static_cast<size_t>(colon - p), -1 };
+        for (const MemInfoKey& key : MEMINFO_KEYS) {
+            if (std::strlen(key.key) == field.keyLength && std::memcmp(key.key, p, field.keyLength) == 0) {
+                field.key = key.key;
+                field.offset = key.offset;
+                hasMemAvailable_ = hasMemAvailable_ || field.offset == static_cast<std::ptrdiff_t>(offsetof(MemoryInfo, available_bytes));
+                break;
+            }
+        }
+        lineTable_.push_back(field);
+        ProcParse::nextLine(p, end);
+    }
+    return true;
+}
+
+bool MemoryCollector::parse(MemoryInfo& memory) {
+    const char* p = file_.data();
+    const char* end = p + file_.size();
+    char* base = reinterpret_cast<char*>(&memory);
+
+    for (const LineField& field : lineTable_) {
+        if (p >= end) {
+            return false;
+        }
+        if (field.offset >= 0) {
+            // Make sure the line still holds the key the table expects
+            if (!ProcParse::hasKey(p, end, field.key, field.keyLength)) {
+                return false;
+            }
+            const char* value = p + field.keyLength + 1;
+            *reinterpret_cast<unsigned long long*>(base + field.offset) = ProcParse::parseMemInfoValue(value, end);
+        }
+        ProcParse::nextLine(p, end);
+    }
+    return p >= end;
+}
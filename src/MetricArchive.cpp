@@ -0,0 +1,337 @@
+#include "MetricArchive.h"
+#include "SnapshotFields.h"
+#include "Printer.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+const uint32_t MetricArchive::MAGIC = 0x41535953; // "SYSA"
+const uint16_t MetricArchive::VERSION = 1;
+
+static const size_t STATS_PER_FIELD = 3; // min, max, avg
+
+static size_t alignUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+static long long floorDivide(long long value, long long divisor) {
+    long long quotient = value / divisor;
+    return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+}
+
+// Copies every metric of a snapshot into a row of { v, v, v } statistics
+class MetricArchive::Appender {
+public:
+    explicit Appender(std::vector<double>& stats) : stats_(stats), field_(0) {}
+
+    void visitInt(const SnapshotFieldName&, long long value) {
+        add(static_cast<double>(value));
+    }
+
+    void visitDouble(const SnapshotFieldName&, double value) {
+        add(value);
+    }
+
+private:
+    void add(double value) {
+        size_t offset = field_ * STATS_PER_FIELD;
+        if (offset + STATS_PER_FIELD <= stats_.size()) {
+            stats_[offset] = value;
+            stats_[offset + 1] = value;
+            stats_[offset + 2] = value;
+        }
+        ++field_;
+    }
+
+    std::vector<double>& stats_;
+    size_t field_;
+};
+
+MetricArchive::MetricArchive() : fd_(-1), mapping_(nullptr), mappingSize_(0), writable_(false) {
+}
+
+MetricArchive::~MetricArchive() {
+    close();
+}
+
+bool MetricArchive::mapFile(size_t size, bool writable) {
+    void* mapping = ::mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    mapping_ = static_cast<char*>(mapping);
+    mappingSize_ = size;
+    writable_ = writable;
+    return true;
+}
+
+bool MetricArchive::hasLayout(const ArchiveHeader& expected, const std::vector<ArchiveTierHeader>& tiers) const {
+    const ArchiveHeader* header = reinterpret_cast<const ArchiveHeader*>(mapping_);
+    if (header->magic != MAGIC || header->version != VERSION || header->headerSize != sizeof(ArchiveHeader) ||
+        header->numTiers != expected.numTiers || header->numFields != expected.numFields ||
+        header->schemaHash != expected.schemaHash || header->totalSize != expected.totalSize) {
+        return false;
+    }
+    for (size_t tier = 0; tier < tiers.size(); ++tier) {
+        const ArchiveTierHeader& existing = getTier(tier);
+        if (existing.resolutionNs != tiers[tier].resolutionNs || existing.numRows != tiers[tier].numRows ||
+            existing.dataOffset != tiers[tier].dataOffset) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MetricArchive::open(const std::string& path, const SnapshotSchema& schema, const std::vector<ArchiveTierConfig>& tiers) {
+    close();
+
+    std::vector<ArchiveTierConfig> validTiers;
+    for (const ArchiveTierConfig& tier : tiers) {
+        if (tier.resolutionSeconds <= 0 || tier.rows <= 0) {
+            PRINT_WARNING(-1, "Ignoring archive tier with a resolution of " + std::to_string(tier.resolutionSeconds) +
+                          " s and " + std::to_string(tier.rows) + " rows.");
+            continue;
+        }
+        validTiers.push_back(tier);
+    }
+    if (validTiers.empty()) {
+        PRINT_ERROR(-1, "The archive " + path + " has no valid tiers.");
+        return false;
+    }
+
+    // Lay out the file for this schema and these tiers
+    std::string schemaJson = schema.toJson();
+    ArchiveHeader header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.headerSize = static_cast<uint16_t>(sizeof(ArchiveHeader));
+    header.numTiers = static_cast<uint32_t>(validTiers.size());
+    header.numFields = static_cast<uint32_t>(schema.getFields().size());
+    header.schemaHash = schema.getHash();
+    header.schemaOffset = static_cast<uint32_t>(sizeof(ArchiveHeader) + validTiers.size() * sizeof(ArchiveTierHeader));
+    header.schemaSize = static_cast<uint32_t>(schemaJson.size());
+
+    std::vector<ArchiveTierHeader> tierHeaders;
+    size_t offset = alignUp(header.schemaOffset + schemaJson.size(), 64);
+    size_t rowStride = alignUp(sizeof(ArchiveRowHeader) + header.numFields * STATS_PER_FIELD * sizeof(double), 64);
+    for (const ArchiveTierConfig& tier : validTiers) {
+        ArchiveTierHeader tierHeader;
+        tierHeader.resolutionNs = static_cast<int64_t>(tier.resolutionSeconds) * 1000000000LL;
+        tierHeader.numRows = static_cast<uint64_t>(tier.rows);
+        tierHeader.rowStride = rowStride;
+        tierHeader.dataOffset = offset;
+        tierHeader.currentRowStartNs = -1;
+        offset += rowStride * tierHeader.numRows;
+        tierHeaders.push_back(tierHeader);
+    }
+    header.totalSize = offset;
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        PRINT_ERROR(-1, "Failed to open the archive " + path + ": " + std::string(strerror(errno)));
+        return false;
+    }
+    path_ = path;
+
+    // Continue an archive of the same layout, the history from before a restart is kept
+    struct stat info;
+    if (::fstat(fd_, &info) == 0 && static_cast<uint64_t>(info.st_size) == header.totalSize && mapFile(header.totalSize, true)) {
+        if (hasLayout(header, tierHeaders)) {
+            // The rows the previous writer was consolidating are picked up from the tier headers
+            schema_ = schema;
+            sampleStats_.assign(header.numFields * STATS_PER_FIELD, 0.0);
+            PRINT_INFO(1, "Continuing the archive " + path + ".");
+            return true;
+        }
+        PRINT_WARNING(-1, "The archive " + path + " has another layout, replacing it.");
+        ::munmap(mapping_, mappingSize_);
+        mapping_ = nullptr;
+    }
+
+    // Start over with an empty, zero-filled archive: a row with a count of 0 was never written
+    if (::ftruncate(fd_, 0) != 0 || ::ftruncate(fd_, static_cast<off_t>(header.totalSize)) != 0 || !mapFile(header.totalSize, true)) {
+        PRINT_ERROR(-1, "Failed to create the archive " + path + ": " + std::string(strerror(errno)));
+        close();
+        return false;
+    }
+    std::memcpy(mapping_, &header, sizeof(header));
+    std::memcpy(mapping_ + sizeof(ArchiveHeader), tierHeaders.data(), tierHeaders.size() * sizeof(ArchiveTierHeader));
+    std::memcpy(mapping_ + header.schemaOffset, schemaJson.data(), schemaJson.size());
+    schema_ = schema;
+    sampleStats_.assign(header.numFields * STATS_PER_FIELD, 0.0);
+    PRINT_INFO(1, "Created the archive " + path + " (" + std::to_string(header.totalSize) + " bytes).");
+    return true;
+}
+
+bool MetricArchive::openReadOnly(const std::string& path) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        return false;
+    }
+    path_ = path;
+
+    struct stat info;
+    if (::fstat(fd_, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ArchiveHeader) ||
+        !mapFile(static_cast<size_t>(info.st_size), false)) {
+        close();
+        return false;
+    }
+
+    const ArchiveHeader* header = reinterpret_cast<const ArchiveHeader*>(mapping_);
+    bool valid = header->magic == MAGIC && header->version == VERSION && header->headerSize == sizeof(ArchiveHeader) &&
+                 header->totalSize == mappingSize_ && header->numTiers > 0 &&
+                 sizeof(ArchiveHeader) + header->numTiers * sizeof(ArchiveTierHeader) <= header->schemaOffset &&
+                 static_cast<size_t>(header->schemaOffset) + header->schemaSize <= mappingSize_;
+    for (size_t tier = 0; valid && tier < header->numTiers; ++tier) {
+        const ArchiveTierHeader& tierHeader = getTier(tier);
+        valid = tierHeader.resolutionNs > 0 && tierHeader.numRows > 0 &&
+                tierHeader.rowStride >= sizeof(ArchiveRowHeader) + header->numFields * STATS_PER_FIELD * sizeof(double) &&
+                tierHeader.dataOffset + tierHeader.rowStride * tierHeader.numRows <= mappingSize_;
+    }
+    if (!valid || !schema_.loadJson(std::string(mapping_ + header->schemaOffset, header->schemaSize)) ||
+        schema_.getHash() != header->schemaHash || schema_.getFields().size() != header->numFields) {
+        PRINT_WARNING(1, path + " is not an archive this version can read.");
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MetricArchive::close() {
+    if (mapping_ != nullptr) {
+        if (writable_) {
+            ::msync(mapping_, mappingSize_, MS_SYNC);
+        }
+        ::munmap(mapping_, mappingSize_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+    mapping_ = nullptr;
+    mappingSize_ = 0;
+    writable_ = false;
+}
+
+bool MetricArchive::isOpen() const {
+    return mapping_ != nullptr;
+}
+
+void MetricArchive::append(const SystemInfoData& data) {
+    if (mapping_ == nullptr || !writable_) {
+        return;
+    }
+    long long timeNs = data.time_stamp_ns - data.sample_lateness_ns;
+    Appender appender(sampleStats_);
+    forEachSnapshotField(data, appender);
+    accumulate(0, timeNs, sampleStats_.data(), 1);
+    reinterpret_cast<ArchiveHeader*>(mapping_)->lastUpdateNs = timeNs;
+}
+
+void MetricArchive::accumulate(size_t tier, long long timeNs, const double* stats, uint32_t count) {
+    if (tier >= getNumTiers()) {
+        return;
+    }
+    ArchiveTierHeader& tierHeader = getTier(tier);
+    long long rowStartNs = floorDivide(timeNs, tierHeader.resolutionNs) * tierHeader.resolutionNs;
+    int64_t& currentStartNs = tierHeader.currentRowStartNs;
+
+    if (rowStartNs != currentStartNs) {
+        // The current row is complete, consolidate it into the next tier before moving on
+        if (currentStartNs >= 0) {
+            const char* done = getRow(tier, currentStartNs);
+            const ArchiveRowHeader* doneHeader = reinterpret_cast<const ArchiveRowHeader*>(done);
+            if (doneHeader->startNs == currentStartNs && doneHeader->count > 0) {
+                accumulate(tier + 1, currentStartNs, reinterpret_cast<const double*>(done + sizeof(ArchiveRowHeader)), doneHeader->count);
+            }
+        }
+        currentStartNs = rowStartNs;
+
+        // Start the new row in the slot of the oldest one
+        ArchiveRowHeader* rowHeader = reinterpret_cast<ArchiveRowHeader*>(getRow(tier, rowStartNs));
+        rowHeader->startNs = rowStartNs;
+        rowHeader->count = 0;
+    }
+
+    char* row = getRow(tier, rowStartNs);
+    ArchiveRowHeader* rowHeader = reinterpret_cast<ArchiveRowHeader*>(row);
+    double* rowStats = reinterpret_cast<double*>(row + sizeof(ArchiveRowHeader));
+    size_t numStats = schema_.getFields().size() * STATS_PER_FIELD;
+    if (rowHeader->count == 0) {
+        std::memcpy(rowStats, stats, numStats * sizeof(double));
+    } else {
+        double previousWeight = static_cast<double>(rowHeader->count);
+        double total = previousWeight + count;
+        for (size_t i = 0; i < numStats; i += STATS_PER_FIELD) {
+            rowStats[i] = std::min(rowStats[i], stats[i]);
+            rowStats[i + 1] = std::max(rowStats[i + 1], stats[i + 1]);
+            rowStats[i + 2] = (rowStats[i + 2] * previousWeight + stats[i + 2] * count) / total;
+        }
+    }
+    rowHeader->count += count;
+}
+
+const ArchiveTierHeader& MetricArchive::getTier(size_t tier) const {
+    return reinterpret_cast<const ArchiveTierHeader*>(mapping_ + sizeof(ArchiveHeader))[tier];
+}
+
+ArchiveTierHeader& MetricArchive::getTier(size_t tier) {
+    return reinterpret_cast<ArchiveTierHeader*>(mapping_ + sizeof(ArchiveHeader))[tier];
+}
+
+char* MetricArchive::getRow(size_t tier, long long startNs) const {
+    const ArchiveTierHeader& tierHeader = getTier(tier);
+    long long slot = floorDivide(startNs, tierHeader.resolutionNs) % static_cast<long long>(tierHeader.numRows);
+    if (slot < 0) {
+        slot += static_cast<long long>(tierHeader.numRows);
+    }
+    return mapping_ + tierHeader.dataOffset + static_cast<size_t>(slot) * tierHeader.rowStride;
+}
+
+const SnapshotSchema& MetricArchive::getSchema() const {
+    return schema_;
+}
+
+size_t MetricArchive::getNumTiers() const {
+    return mapping_ != nullptr ? reinterpret_cast<const ArchiveHeader*>(mapping_)->numTiers : 0;
+}
+
+long long MetricArchive::getTierResolutionNs(size_t tier) const {
+    return getTier(tier).resolutionNs;
+}
+
+size_t MetricArchive::getTierRows(size_t tier) const {
+    return static_cast<size_t>(getTier(tier).numRows);
+}
+
+long long MetricArchive::getLastUpdateNs() const {
+    return mapping_ != nullptr ? reinterpret_cast<const ArchiveHeader*>(mapping_)->lastUpdateNs : 0;
+}
+
+size_t MetricArchive::readRows(size_t tier, size_t field, std::vector<ArchiveRow>& rows) const {
+    if (mapping_ == nullptr || tier >= getNumTiers() || field >= schema_.getFields().size()) {
+        return 0;
+    }
+
+    // Walk the tier's span back from the row holding the last sample, oldest row first
+    const ArchiveTierHeader& tierHeader = getTier(tier);
+    long long resolutionNs = tierHeader.resolutionNs;
+    long long newestStartNs = floorDivide(getLastUpdateNs(), resolutionNs) * resolutionNs;
+    size_t before = rows.size();
+    for (long long i = static_cast<long long>(tierHeader.numRows) - 1; i >= 0; --i) {
+        long long startNs = newestStartNs - i * resolutionNs;
+        const char* row = getRow(tier, startNs);
+        const ArchiveRowHeader* rowHeader = reinterpret_cast<const ArchiveRowHeader*>(row);
+        if (rowHeader->startNs != startNs || rowHeader->count == 0) {
+            continue;
+        }
+        const double* stats = reinterpret_cast<const double*>(row + sizeof(ArchiveRowHeader)) + field * STATS_PER_FIELD;
+        rows.push_back({ startNs, rowHeader->count, stats[0], stats[1], stats[2] });
+    }
+    return rows.size() - before;
+}
@@ -0,0 +1,147 @@
+#include "MetricSources.h"
+#include "ConfigManager.h"
+#include "CpuUsageCalculator.h"
+#include "MemoryCollector.h"
+#include "Printer.h"
+#include "ProcParse.h"
+
+static const size_t MEMINFO_BUFFER_SIZE = 8192;
+static const size_t LOADAVG_BUFFER_SIZE = 128;
+
+CpuTotal::CpuTotal() : CpuTotal(ConfigManager::getInstance().getProcPath("stat")) {
+}
+
+CpuTotal::CpuTotal(const std::string& path)
+    : statReader_(path), busyJiffies_(0), idleJiffies_(0), usagePercent_(-1.0), elapsedJiffies_(0), hasSample_(false) {
+}
+
+const char* CpuTotal::getName() {
+    return "cpu_total";
+}
+
+bool CpuTotal::sample() {
+    // Only the aggregate row is parsed, the per-core lines are left unread in the buffer
+    unsigned long long user, nice, system, idle;
+    if (statReader_.read(&user, &nice, &system, &idle, 1) != 1) {
+        PRINT_WARNING_RATE_LIMITED(-1, "Failed to update the total CPU usage from " + statReader_.getPath() + ".");
+        return false;
+    }
+
+    // Counters that went backwards (a replay jumping, a reset) give no usage instead of a wrapped delta
+    unsigned long long busyJiffies = user + nice + system;
+    if (hasSample_ && busyJiffies >= busyJiffies_ && idle >= idleJiffies_ && busyJiffies + idle > busyJiffies_ + idleJiffies_) {
+        elapsedJiffies_ = (busyJiffies + idle) - (busyJiffies_ + idleJiffies_);
+        usagePercent_ = CpuUsageCalculator::getUsagePercent(static_cast<double>(busyJiffies - busyJiffies_), static_cast<double>(idle - idleJiffies_));
+    }
+    busyJiffies_ = busyJiffies;
+    idleJiffies_ = idle;
+    hasSample_ = true;
+    return true;
+}
+
+double CpuTotal::getUsagePercent() const {
+    return usagePercent_;
+}
+
+unsigned long long CpuTotal::getElapsedJiffies() const {
+    return elapsedJiffies_;
+}
+
+MemAvailable::MemAvailable() : MemAvailable(ConfigManager::getInstance().getProcPath("meminfo")) {
+}
+
+MemAvailable::MemAvailable(const std::string& path) : file_(path, MEMINFO_BUFFER_SIZE), totalBytes_(0), availableBytes_(0) {
+}
+
+const char* MemAvailable::getName() {
+    return "mem_available";
+}
+
+bool MemAvailable::sample() {
+    if (!file_.read()) {
+        PRINT_WARNING_RATE_LIMITED(-1, "Failed to update the available memory from " + file_.getPath() + ".");
+        return false;
+    }
+
+    // MemTotal is the first line and MemAvailable the third, the fallback needs the lines up to Cached
+    const char* p = file_.data();
+    const char* end = p + file_.size();
+    unsigned long long total = 0, free = 0, buffers = 0, cached = 0, available = 0;
+    bool hasTotal = false, hasAvailable = false, hasCached = false;
+    while (p < end && !(hasTotal && (hasAvailable || hasCached))) {
+        const char* value = p;
+        if (ProcParse::hasKey(p, end, "MemTotal", 8)) {
+            value += 9;
+            total = ProcParse::parseMemInfoValue(value, end);
+            hasTotal = true;
+        } else if (ProcParse::hasKey(p, end, "MemAvailable", 12)) {
+            value += 13;
+            available = ProcParse::parseMemInfoValue(value, end);
+            hasAvailable = true;
+        } else if (ProcParse::hasKey(p, end, "MemFree", 7)) {
+            value += 8;
+            free = ProcParse::parseMemInfoValue(value, end);
+        } else if (ProcParse::hasKey(p, end, "Buffers", 7)) {
+            value += 8;
+            buffers = ProcParse::parseMemInfoValue(value, end);
+        } else if (ProcParse::hasKey(p, end, "Cached", 6)) {
+            value += 7;
+            cached = ProcParse::parseMemInfoValue(value, end);
+            hasCached = true;
+        }
+        ProcParse::nextLine(p, end);
+    }
+
+    if (!hasTotal) {
+        PRINT_WARNING_RATE_LIMITED(-1, "No MemTotal in " + file_.getPath() + ".");
+        return false;
+    }
+    totalBytes_ = total;
+    availableBytes_ = hasAvailable ? available : MemoryCollector::estimateAvailableBytes(free, buffers, cached);
+    return true;
+}
+
+unsigned long long MemAvailable::getTotalBytes() const {
+    return totalBytes_;
+}
+
+unsigned long long MemAvailable::getAvailableBytes() const {
+    return availableBytes_;
+}
+
+double MemAvailable::getAvailablePercent() const {
+    return totalBytes_ > 0 ? 100.0 * static_cast<double>(availableBytes_) / static_cast<double>(totalBytes_) : 0.0;
+}
+
+LoadAverage::LoadAverage() : LoadAverage(ConfigManager::getInstance().getProcPath("loadavg")) {
+}
+
+LoadAverage::LoadAverage(const std::string& path) : file_(path, LOADAVG_BUFFER_SIZE), load1Min_(0), load5Min_(0), load15Min_(0) {
+}
+
+const char* LoadAverage::getName() {
+    return "load_average";
+}
+
+bool LoadAverage::sample() {
+    if (!file_.read()) {
+        PRINT_WARNING_RATE_LIMITED(-1, "Failed to update load averages from " + file_.getPath() + ".");
+        return false;
+    }
+
+    const char* p = file_.data();
+    ProcParse::parseLoadAverages(p, p + file_.size(), load1Min_, load5Min_, load15Min_);
+    return true;
+}
+
+double LoadAverage::get1Min() const {
+    return load1Min_;
+}
+
+double LoadAverage::get5Min() const {
+    return load5Min_;
+}
+
+double LoadAverage::get15Min() const {
+    return load15Min_;
+}
@@ -0,0 +1,140 @@
+#include "NamedSlotTable.h"
+#include "Printer.h"
+#include <fnmatch.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+const size_t NamedSlotTable::NAME_SIZE;
+
+static void copyName(const char* name, size_t length, char* target) {
+    size_t copyLength = std::min(length, NamedSlotTable::NAME_SIZE - 1);
+    std::memcpy(target, name, copyLength);
+    target[copyLength] = '\0';
+}
+
+NamedSlotTable::NamedSlotTable() {
+}
+
+void NamedSlotTable::init(size_t numSlots, const std::string& kind, const std::string& maxSetting) {
+    kind_ = kind;
+    maxSetting_ = maxSetting;
+    slots_.assign(numSlots, Slot());
+    for (Slot& slot : slots_) {
+        slot.name[0] = '\0';
+        slot.firstJiffies = 0;
+    }
+    lineTable_.clear();
+}
+
+void NamedSlotTable::setFilters(const std::vector<std::string>& patterns, const std::vector<std::string>& excludedPatterns) {
+    patterns_ = patterns;
+    excludedPatterns_ = excludedPatterns;
+    lineTable_.clear();
+}
+
+bool NamedSlotTable::matchesFilters(const char* name) const {
+    for (const std::string& pattern : excludedPatterns_) {
+        if (fnmatch(pattern.c_str(), name, 0) == 0) {
+            return false;
+        }
+    }
+    if (patterns_.empty()) {
+        return true;
+    }
+    for (const std::string& pattern : patterns_) {
+        if (fnmatch(pattern.c_str(), name, 0) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void NamedSlotTable::clearLines() {
+    lineTable_.clear();
+}
+
+void NamedSlotTable::addLine(const char* name, size_t length, bool reported) {
+    LineEntry entry;
+    copyName(name, length, entry.name);
+    entry.slot = -1;
+    entry.reported = reported;
+    lineTable_.push_back(entry);
+}
+
+void NamedSlotTable::assignSlots(unsigned long long jiffies) {
+    // Devices keep their slot as long as they are there, so their history stays valid
+    slotInUse_.assign(slots_.size(), false);
+    for (LineEntry& entry : lineTable_) {
+        entry.slot = -1;
+        if (!entry.reported) {
+            continue;
+        }
+        for (size_t slot = 0; slot < slots_.size(); ++slot) {
+            if (!slotInUse_[slot] && std::strcmp(slots_[slot].name, entry.name) == 0) {
+                entry.slot = static_cast<int>(slot);
+                slotInUse_[slot] = true;
+                break;
+            }
+        }
+    }
+
+    // Free the slots of devices that went away or are filtered out now
+    std::string kind = kind_;
+    if (!kind.empty()) {
+        kind[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(kind[0])));
+    }
+    for (size_t slot = 0; slot < slots_.size(); ++slot) {
+        if (!slotInUse_[slot] && slots_[slot].name[0] != '\0') {
+            PRINT_INFO(1, kind + " " + std::string(slots_[slot].name) + " is no longer reported.");
+            slots_[slot].name[0] = '\0';
+            slots_[slot].firstJiffies = 0;
+        }
+    }
+
+    // Then give the free slots to new devices, in the order of the file
+    for (LineEntry& entry : lineTable_) {
+        if (entry.slot >= 0 || !entry.reported) {
+            continue;
+        }
+        std::vector<bool>::iterator freeSlot = std::find(slotInUse_.begin(), slotInUse_.end(), false);
+        if (freeSlot == slotInUse_.end()) {
+            PRINT_WARNING_RATE_LIMITED(1, "No free slot to report " + kind_ + " " + std::string(entry.name) + ", raise " + maxSetting_ + ".");
+            continue;
+        }
+        *freeSlot = true;
+        entry.slot = static_cast<int>(freeSlot - slotInUse_.begin());
+        Slot& slot = slots_[entry.slot];
+        std::memcpy(slot.name, entry.name, sizeof(slot.name));
+        slot.firstJiffies = jiffies;
+        PRINT_INFO(1, "Reporting " + kind_ + " " + std::string(slot.name) + ".");
+    }
+}
+
+size_t NamedSlotTable::getNumLines() const {
+    return lineTable_.size();
+}
+
+bool NamedSlotTable::matchesLine(size_t line, const char* name, size_t length) const {
+    if (line >= lineTable_.size()) {
+        return false;
+    }
+    const char* tableName = lineTable_[line].name;
+    return std::strlen(tableName) == std::min(length, NAME_SIZE - 1) && std::memcmp(tableName, name, std::strlen(tableName)) == 0;
+}
+
+int NamedSlotTable::getLineSlot(size_t line) const {
+    return lineTable_[line].slot;
+}
+
+size_t NamedSlotTable::size() const {
+    return slots_.size();
+}
+
+const char* NamedSlotTable::getName(size_t slot) const {
+    return slots_[slot].name;
+}
+
+unsigned long long NamedSlotTable::getFirstJiffies(size_t slot) const {
+    return slots_[slot].firstJiffies;
+}
@@ -0,0 +1,196 @@
+#include "NetworkCollector.h"
+#include "ConfigManager.h"
+#include "Printer.h"
+#include "ProcParse.h"
+#include <algorithm>
+#include <cstdio>
+
+static const size_t NET_DEV_BUFFER_SIZE = 8192;
+static const size_t NET_DEV_HEADER_LINES = 2;
+
+// Name of an interface line ("  eth0: 1234 ..."), p is left on the colon
+static void parseInterfaceName(const char*& p, const char* end, const char*& nameBegin, size_t& nameLength) {
+    ProcParse::skipSpaces(p, end);
+    nameBegin = p;
+    while (p < end && *p != ':' && *p != '\n') {
+        ++p;
+    }
+    nameLength = static_cast<size_t>(p - nameBegin);
+}
+
+NetworkCollector::NetworkCollector() : NetworkCollector(ConfigManager::getInstance().getProcPath("net/dev")) {
+}
+
+NetworkCollector::NetworkCollector(const std::string& path) : file_(path, NET_DEV_BUFFER_SIZE) {
+}
+
+const char* NetworkCollector::getName() const {
+    return "network";
+}
+
+void NetworkCollector::init(unsigned long long jiffiesPerSecond, unsigned long long periodJiffies) {
+    int maxInterfaces = ConfigManager::getInstance().getMaxNetworkInterfaces();
+    slots_.init(maxInterfaces > 0 ? static_cast<size_t>(maxInterfaces) : 0, "network interface", "system_info.network.max_interfaces");
+    readFilters();
+    counters_.init(NUM_COLUMNS, slots_.size(), jiffiesPerSecond, periodJiffies);
+
+    PRINT_INFO(2, "Network collector reporting up to " + std::to_string(slots_.size()) + " interfaces.");
+}
+
+bool NetworkCollector::reconfigure(unsigned long long periodJiffies) {
+    readFilters();
+    return counters_.reconfigure(periodJiffies);
+}
+
+void NetworkCollector::readFilters() {
+    ConfigManager& configManager = ConfigManager::getInstance();
+    slots_.setFilters(configManager.getNetworkInterfaces(), configManager.getExcludedNetworkInterfaces());
+}
+
+void NetworkCollector::initSnapshot(SystemInfoData& data) {
+    NetworkInterfaceInfo empty;
+    empty.name[0] = '\0';
+    empty.rx_bytes_per_second = -1.0;
+    empty.rx_packets_per_second = -1.0;
+    empty.rx_errors_per_second = -1.0;
+    empty.rx_dropped_per_second = -1.0;
+    empty.tx_bytes_per_second = -1.0;
+    empty.tx_packets_per_second = -1.0;
+    empty.tx_errors_per_second = -1.0;
+    empty.tx_dropped_per_second = -1.0;
+    empty.real_time_step = 0.0;
+    data.network_interfaces.assign(slots_.size(), empty);
+    data.network_rx_bytes_per_second_per_window.assign(counters_.getNumWindows() * slots_.size(), -1.0);
+    data.network_tx_bytes_per_second_per_window.assign(counters_.getNumWindows() * slots_.size(), -1.0);
+
+    // Assign the slots and take the first sample right away
+    collect(data);
+}
+
+bool NetworkCollector::collect(SystemInfoData& data) {
+    if (slots_.size() == 0) {
+        return true;
+    }
+
+    unsigned long long jiffies = counters_.getCurrentJiffy();
+    if (!file_.read() || (!parse() && !(buildLineTable(jiffies) && parse()))) {
+        PRINT_WARNING_RATE_LIMITED(-1, "Failed to update network interfaces from " + file_.getPath() + ".");
+        return false;
+    }
+    counters_.commit(jiffies);
+
+    fillSnapshot(data);
+    return true;
+}
+
+bool NetworkCollector::parse() {
+    const char* p = file_.data();
+    const char* end = p + file_.size();
+    for (size_t line = 0; line < NET_DEV_HEADER_LINES; ++line) {
+        ProcParse::nextLine(p, end);
+    }
+
+    // Slots whose interface has no line keep zeros
+    counters_.clearPending();
+    unsigned long long* columns[NUM_COLUMNS];
+    for (size_t column = 0; column < NUM_COLUMNS; ++column) {
+        columns[column] = counters_.getPendingColumn(column);
+    }
+
+    size_t lineIndex = 0;
+    while (p < end) {
+        const char* name;
+        size_t nameLength;
+        parseInterfaceName(p, end, name, nameLength);
+        if (p >= end || *p != ':' || !slots_.matchesLine(lineIndex, name, nameLength)) {
+            return false;
+        }
+
+        int slot = slots_.getLineSlot(lineIndex);
+        if (slot >= 0) {
+            // Receive: bytes packets errs drop fifo frame compressed multicast, then transmit: bytes packets errs drop ...
+            ++p;
+            columns[RX_BYTES_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+            columns[RX_PACKETS_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+            columns[RX_ERRORS_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+            columns[RX_DROPPED_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+            for (int field = 0; field < 4; ++field) {
+                ProcParse::skipToken(p, end);
+            }
+            columns[TX_BYTES_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+            columns[TX_PACKETS_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+            columns[TX_ERRORS_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+            columns[TX_DROPPED_COLUMN][slot] = ProcParse::parseUnsigned(p, end);
+        }
+        ProcParse::nextLine(p, end);
+        ++lineIndex;
+    }
+    return lineIndex == slots_.getNumLines();
+}
+
+bool NetworkCollector::buildLineTable(unsigned long long jiffies) {
+    const char* p = file_.data();
+    const char* end = p + file_.size();
+    for (size_t line = 0; line < NET_DEV_HEADER_LINES; ++line) {
+        ProcParse::nextLine(p, end);
+    }
+
+    slots_.clearLines();
+    char name[NamedSlotTable::NAME_SIZE];
+    while (p < end) {
+        const char* nameBegin;
+        size_t nameLength;
+        parseInterfaceName(p, end, nameBegin, nameLength);
+        if (p >= end || *p != ':') {
+            return false;
+        }
+        std::snprintf(name, sizeof(name), "%.*s", static_cast<int>(nameLength), nameBegin);
+        slots_.addLine(nameBegin, nameLength, slots_.matchesFilters(name));
+        ProcParse::nextLine(p, end);
+    }
+    slots_.assignSlots(jiffies);
+    return true;
+}
+
+void NetworkCollector::fillSnapshot(SystemInfoData& data) {
+    size_t numSlots = slots_.size();
+    double jiffiesPerSecond = static_cast<double>(counters_.getJiffiesPerSecond());
+
+    for (size_t window = 0; window < counters_.getNumWindows(); ++window) {
+        size_t windowStart = counters_.findWindowStart(window);
+        double* rxBytesPerSecond = data.network_rx_bytes_per_second_per_window.data() + window * numSlots;
+        double* txBytesPerSecond = data.network_tx_bytes_per_second_per_window.data() + window * numSlots;
+
+        for (size_t index = 0; index < numSlots; ++index) {
+            const char* name = slots_.getName(index);
+            NetworkInterfaceInfo& info = data.network_interfaces[index];
+            double rates[NUM_COLUMNS];
+            std::fill(rates, rates + NUM_COLUMNS, -1.0);
+            double seconds = 0.0;
+
+            unsigned long long deltas[NUM_COLUMNS];
+            unsigned long long jiffiesPassed;
+            if (name[0] != '\0' && counters_.getDeltas(windowStart, index, slots_.getFirstJiffies(index), deltas, jiffiesPassed)) {
+                seconds = static_cast<double>(jiffiesPassed) / jiffiesPerSecond;
+                for (size_t column = 0; column < NUM_COLUMNS; ++column) {
+                    rates[column] = static_cast<double>(deltas[column]) / seconds;
+                }
+            }
+            rxBytesPerSecond[index] = rates[RX_BYTES_COLUMN];
+            txBytesPerSecond[index] = rates[TX_BYTES_COLUMN];
+
+            if (window == 0) {
+                std::snprintf(info.name, sizeof(info.name), "%s", name);
+                info.rx_bytes_per_second = rates[RX_BYTES_COLUMN];
+                info.rx_packets_per_second = rates[RX_PACKETS_COLUMN];
+                info.rx_errors_per_second = rates[RX_ERRORS_COLUMN];
+                info.rx_dropped_per_second = rates[RX_DROPPED_COLUMN];
+                info.tx_bytes_per_second = rates[TX_BYTES_COLUMN];
+                info.tx_packets_per_second = rates[TX_PACKETS_COLUMN];
+                info.tx_errors_per_second = rates[TX_ERRORS_COLUMN];
+                info.tx_dropped_per_second = rates[TX_DROPPED_COLUMN];
+                info.real_time_step = seconds;
+            }
+        }
+    }
+}
@@ -0,0 +1,239 @@
+#include "PressureCollector.h"
+#include "ConfigManager.h"
+#include "Printer.h"
+#include "ProcCapture.h"
+#include "ProcParse.h"
+#include <fcntl.h>
+#include <linux/magic.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+static const size_t PRESSURE_BUFFER_SIZE = 256;
+static const char* const RESOURCE_NAMES[PressureCollector::NUM_RESOURCES] = { "cpu", "memory", "io" };
+
+// One "some" or "full" line: "some avg10=0.12 avg60=0.05 avg300=0.01 total=123456", p is left at the next line
+static void parsePressureLine(const char*& p, const char* end, double& avg10, double& avg60, double& avg300,
+                              unsigned long long& totalUs) {
+    ProcParse::skipToken(p, end);
+    double* averages[] = { &avg10, &avg60, &avg300 };
+    for (double* average : averages) {
+        while (p < end && *p != '=' && *p != '\n') {
+            ++p;
+        }
+        if (p < end && *p == '=') {
+            ++p;
+        }
+        *average = ProcParse::parseDecimal(p, end);
+    }
+    while (p < end && *p != '=' && *p != '\n') {
+        ++p;
+    }
+    if (p < end && *p == '=') {
+        ++p;
+    }
+    totalUs = ProcParse::parseUnsigned(p, end);
+    ProcParse::nextLine(p, end);
+}
+
+// Share of elapsedNs the stall total grew by, in percent
+static double getStallPercent(unsigned long long previousUs, unsigned long long currentUs, long long elapsedNs) {
+    if (currentUs < previousUs) {
+        return 0.0;
+    }
+    return 100.0 * static_cast<double>(currentUs - previousUs) * 1000.0 / static_cast<double>(elapsedNs);
+}
+
+PressureCollector::PressureCollector() : PressureCollector(ConfigManager::getInstance().getProcPath("pressure")) {
+}
+
+PressureCollector::PressureCollector(const std::string& directory) : directory_(directory) {
+    for (int resource = 0; resource < NUM_RESOURCES; ++resource) {
+        files_[resource] = ProcFile(directory_ + "/" + RESOURCE_NAMES[resource], PRESSURE_BUFFER_SIZE);
+        available_[resource] = true;
+        totals_[resource].someUs = 0;
+        totals_[resource].fullUs = 0;
+        totals_[resource].sampleNs = 0;
+        triggerEvents_[resource] = 0;
+    }
+}
+
+PressureCollector::~PressureCollector() {
+    for (int fd : triggerFds_) {
+        ::close(fd);
+    }
+}
+
+const char* PressureCollector::getName() const {
+    return "pressure";
+}
+
+void PressureCollector::init() {
+    const std::vector<PressureTriggerConfig>& triggers = ConfigManager::getInstance().getPressureTriggers();
+    if (triggers.empty()) {
+        return;
+    }
+    if (ProcCapture::getInstance().isReplaying()) {
+        PRINT_INFO(1, "Not registering pressure triggers while replaying a capture.");
+        return;
+    }
+
+    for (const PressureTriggerConfig& trigger : triggers) {
+        int resource = parseResource(trigger.resource);
+        if (resource < 0 || (trigger.type != "some" && trigger.type != "full")) {
+            PRINT_WARNING(-1, "Ignoring pressure trigger \"" + trigger.type + "\" of unknown resource \"" + trigger.resource +
+                          "\", expected some or full of cpu, memory or io.");
+            continue;
+        }
+
+        std::string path = directory_ + "/" + trigger.resource;
+        int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            PRINT_WARNING(-1, "Failed to open " + path + " for a pressure trigger: " + std::string(strerror(errno)));
+            continue;
+        }
+
+        // The files of a synthetic procfs root are regular files, which the trigger would overwrite
+        struct statfs fileSystem;
+        if (::fstatfs(fd, &fileSystem) != 0 || fileSystem.f_type != PROC_SUPER_MAGIC) {
+            PRINT_WARNING(-1, "Not registering a pressure trigger on " + path + ", which is not on procfs.");
+            ::close(fd);
+            continue;
+        }
+
+        // The kernel expects "<some|full> <stall us> <window us>" as a null-terminated string
+        std::string specification = trigger.type + " " + std::to_string(trigger.stallUs) + " " + std::to_string(trigger.windowUs);
+        if (::write(fd, specification.c_str(), specification.size() + 1) < 0) {
+            PRINT_WARNING(-1, "Failed to register pressure trigger \"" + specification + "\" on " + path + ": " +
+                          std::string(strerror(errno)));
+            ::close(fd);
+            continue;
+        }
+
+        triggerFds_.push_back(fd);
+        triggerResources_.push_back(static_cast<Resource>(resource));
+        PRINT_INFO(2, "Registered pressure trigger \"" + specification + "\" on " + path + ".");
+    }
+}
+
+const std::vector<int>& PressureCollector::getTriggerFds() const {
+    return triggerFds_;
+}
+
+void PressureCollector::addTriggerEvents(unsigned long long events) {
+    for (size_t i = 0; i < triggerResources_.size() && i < 64; ++i) {
+        if (events & (1ULL << i)) {
+            ++triggerEvents_[triggerResources_[i]];
+        }
+    }
+}
+
+void PressureCollector::initSnapshot(SystemInfoData& data) {
+    for (int resource = 0; resource < NUM_RESOURCES; ++resource) {
+        PressureInfo& pressure = getPressure(data, static_cast<Resource>(resource));
+        pressure.some_avg10 = -1;
+        pressure.some_avg60 = -1;
+        pressure.some_avg300 = -1;
+        pressure.some_total_us = -1;
+        pressure.some_stall_percent = -1;
+        pressure.full_avg10 = -1;
+        pressure.full_avg60 = -1;
+        pressure.full_avg300 = -1;
+        pressure.full_total_us = -1;
+        pressure.full_stall_percent = -1;
+        pressure.real_time_step = 0;
+        pressure.trigger_events = 0;
+
+        // The first read tells whether the kernel reports the resource at all, so later samples skip the ones it does not
+        if (!files_[resource].read()) {
+            available_[resource] = false;
+            PRINT_INFO(1, "No pressure stall information in " + files_[resource].getPath() + ", reporting -1.");
+            continue;
+        }
+        parse(static_cast<Resource>(resource), pressure);
+    }
+}
+
+bool PressureCollector::collect(SystemInfoData& data) {
+    bool success = true;
+    for (int resource = 0; resource < NUM_RESOURCES; ++resource) {
+        PressureInfo& pressure = getPressure(data, static_cast<Resource>(resource));
+        pressure.trigger_events = triggerEvents_[resource];
+        if (!available_[resource]) {
+            continue;
+        }
+
+        if (!files_[resource].read()) {
+            PRINT_WARNING_RATE_LIMITED(-1, "Failed to update pressure stall information from " + files_[resource].getPath() + ".");
+            success = false;
+        } else if (!parse(static_cast<Resource>(resource), pressure)) {
+            success = false;
+        }
+    }
+    return success;
+}
+
+bool PressureCollector::parse(Resource resource, PressureInfo& pressure) {
+    const char* p = files_[resource].data();
+    const char* end = p + files_[resource].size();
+    long long sampleNs = ProcCapture::getInstance().getSampleNanos();
+    Totals& totals = totals_[resource];
+
+    // "full" is missing for the CPU before Linux 5.13, its values stay at -1 then
+    bool hasSome = false;
+    bool hasFull = false;
+    unsigned long long someUs = 0;
+    unsigned long long fullUs = 0;
+    while (p < end) {
+        if (end - p >= 4 && std::memcmp(p, "some", 4) == 0) {
+            parsePressureLine(p, end, pressure.some_avg10, pressure.some_avg60, pressure.some_avg300, someUs);
+            hasSome = true;
+        } else if (end - p >= 4 && std::memcmp(p, "full", 4) == 0) {
+            parsePressureLine(p, end, pressure.full_avg10, pressure.full_avg60, pressure.full_avg300, fullUs);
+            hasFull = true;
+        } else {
+            ProcParse::nextLine(p, end);
+        }
+    }
+    if (!hasSome) {
+        PRINT_WARNING_RATE_LIMITED(-1, "Unexpected contents of " + files_[resource].getPath() + ".");
+        return false;
+    }
+
+    // Stall rates between this sample and the previous one
+    long long elapsedNs = sampleNs - totals.sampleNs;
+    bool hasPrevious = totals.sampleNs != 0 && elapsedNs > 0;
+    pressure.some_total_us = static_cast<long long>(someUs);
+    pressure.some_stall_percent = hasPrevious ? getStallPercent(totals.someUs, someUs, elapsedNs) : -1;
+    if (hasFull) {
+        pressure.full_total_us = static_cast<long long>(fullUs);
+        pressure.full_stall_percent = hasPrevious ? getStallPercent(totals.fullUs, fullUs, elapsedNs) : -1;
+    }
+    pressure.real_time_step = hasPrevious ? static_cast<double>(elapsedNs) / 1e9 : 0;
+
+    totals.someUs = someUs;
+    totals.fullUs = fullUs;
+    totals.sampleNs = sampleNs;
+    return true;
+}
+
+PressureInfo& PressureCollector::getPressure(SystemInfoData& data, Resource resource) {
+    switch (resource) {
+    case CPU_RESOURCE:
+        return data.pressure_cpu;
+    case MEMORY_RESOURCE:
+        return data.pressure_memory;
+    default:
+        return data.pressure_io;
+    }
+}
+
+int PressureCollector::parseResource(const std::string& name) {
+    for (int resource = 0; resource < NUM_RESOURCES; ++resource) {
+        if (name == RESOURCE_NAMES[resource]) {
+            return resource;
+        }
+    }
+    return -1;
+}
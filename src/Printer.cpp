@@ -3,10 +3,77 @@
 #include <iostream>
 #include <chrono>
 #include <ctime>
+#include <cstdio>
+#include <cstring>
 
-Printer::Printer() {
+static const size_t DEFAULT_QUEUE_CAPACITY = 1024;
+static const size_t MAX_BATCH_SIZE = 256; // Messages written per flush
+static const std::chrono::milliseconds WRITER_IDLE_WAIT(10); // Backstop in case a wake-up is missed
+static const int DEFAULT_RATE_LIMIT_BURST = 5;
+static const double DEFAULT_RATE_LIMIT_INTERVAL_SECONDS = 10.0;
+
+static long long getSteadyNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+PrinterRateLimit::PrinterRateLimit(const char* filename, int lineNumber)
+    : filename_(filename), lineNumber_(lineNumber), windowStartNs_(0), printedInWindow_(0), suppressed_(0), firstSuppressedNs_(0) {
+    windowStartNs_ = getSteadyNanos();
+}
+
+PrinterRateLimit::~PrinterRateLimit() {
+    if (suppressed_ > 0) {
+        Printer::getInstance().printWarning("The previous message was suppressed " + std::to_string(suppressed_) + " more time(s).",
+                                            lineNumber_, filename_, -1);
+    }
+}
+
+bool PrinterRateLimit::acquire(std::string& suppressedNote) {
+    // The budget follows the printer settings, which a config reload may change
+    Printer& printer = Printer::getInstance();
+    long long burst = printer.getRateLimitBurst() > 0 ? printer.getRateLimitBurst() : 0;
+    if (burst == 0) {
+        return true;
+    }
+    long long intervalNs = static_cast<long long>(printer.getRateLimitIntervalSeconds() * 1e9);
+
+    long long now = getSteadyNanos();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (now - windowStartNs_ >= intervalNs) {
+        windowStartNs_ = now;
+        printedInWindow_ = 0;
+    }
+    if (printedInWindow_ >= burst) {
+        if (suppressed_ == 0) {
+            firstSuppressedNs_ = now;
+        }
+        ++suppressed_;
+        return false;
+    }
+
+    ++printedInWindow_;
+    if (suppressed_ > 0) {
+        char seconds[32];
+        std::snprintf(seconds, sizeof(seconds), "%.1f", static_cast<double>(now - firstSuppressedNs_) / 1e9);
+        suppressedNote = " (repeated " + std::to_string(suppressed_) + " more time(s) in the last " + seconds + " s)";
+        suppressed_ = 0;
+    }
+    return true;
+}
+
+Printer::Printer()
+    : settings_(nullptr), async(false), queueCapacity(DEFAULT_QUEUE_CAPACITY), overflowPolicy(DROP_ON_OVERFLOW), writerRunning_(false), writerSleeping_(false),
+      queuedCount_(0), droppedCount_(0), writtenCount_(0) {
     // Initialize settings from the ConfigManager
     initializeSettings();
+
+    if (async) {
+        startWriter();
+    }
+}
+
+Printer::~Printer() {
+    stopWriter();
 }
 
 Printer& Printer::getInstance() {
@@ -17,65 +84,211 @@ Printer& Printer::getInstance() {
 void Printer::initializeSettings() {
     // Get configuration from the ConfigManager
     const nlohmann::json& config = ConfigManager::getInstance().getConfig();
-    verbosity = ConfigManager::getInstance().getVerbosity();
+    settingsVersions_.push_back(readSettings());
+    settings_.store(settingsVersions_.back().get(), std::memory_order_release);
+
+    // The queue and writer thread are set up once
+    if (config.contains("printer")) {
+        const nlohmann::json& printerConfig = config["printer"];
+        async = printerConfig.value("async", false);
+        queueCapacity = printerConfig.value("queue_capacity", DEFAULT_QUEUE_CAPACITY);
+        overflowPolicy = printerConfig.value("overflow_policy", std::string("drop")) == "block" ? BLOCK_ON_OVERFLOW : DROP_ON_OVERFLOW;
+    }
+}
+
+std::unique_ptr<PrinterSettings> Printer::readSettings() const {
+    const nlohmann::json& config = ConfigManager::getInstance().getConfig();
+    std::unique_ptr<PrinterSettings> settings(new PrinterSettings());
+    settings->verbosity = ConfigManager::getInstance().getVerbosity();
     // Extract other printing settings
     if (config.contains("printer")) {
         const nlohmann::json& printerConfig = config["printer"];
-        printLineNumber = printerConfig.value("print_line_number", false);
-        printCurrentTime = printerConfig.value("print_current_time", false);
-        prefix = printerConfig.value("prefix", "");
-        suffix = printerConfig.value("suffix", "");
-        infoColor = printerConfig.value("info_color", "white");
-        warningColor = printerConfig.value("warning_color", "yellow");
-        errorColor = printerConfig.value("error_color", "red");
+        settings->printLineNumber = printerConfig.value("print_line_number", false);
+        settings->printCurrentTime = printerConfig.value("print_current_time", false);
+        settings->prefix = printerConfig.value("prefix", "");
+        settings->suffix = printerConfig.value("suffix", "");
+        settings->infoColor = printerConfig.value("info_color", "white");
+        settings->warningColor = printerConfig.value("warning_color", "yellow");
+        settings->errorColor = printerConfig.value("error_color", "red");
+        settings->rateLimitBurst = printerConfig.value("rate_limit_burst", DEFAULT_RATE_LIMIT_BURST);
+        settings->rateLimitIntervalSeconds = printerConfig.value("rate_limit_interval_seconds", DEFAULT_RATE_LIMIT_INTERVAL_SECONDS);
     } else {
         // Use default values if the printing section is not found
-        printLineNumber = false;
-        printCurrentTime = false;
-        prefix = "";
-        suffix = "";
-        infoColor = "white";
-        warningColor = "yellow";
-        errorColor = "red";
+        settings->printLineNumber = false;
+        settings->printCurrentTime = false;
+        settings->prefix = "";
+        settings->suffix = "";
+        settings->infoColor = "white";
+        settings->warningColor = "yellow";
+        settings->errorColor = "red";
+        settings->rateLimitBurst = DEFAULT_RATE_LIMIT_BURST;
+        settings->rateLimitIntervalSeconds = DEFAULT_RATE_LIMIT_INTERVAL_SECONDS;
     }
+    return settings;
+}
+
+void Printer::reloadSettings() {
+    std::lock_guard<std::mutex> lock(reloadMutex_);
+    settingsVersions_.push_back(readSettings());
+    settings_.store(settingsVersions_.back().get(), std::memory_order_release);
+}
+
+int Printer::getRateLimitBurst() const {
+    return settings_.load(std::memory_order_acquire)->rateLimitBurst;
+}
+
+double Printer::getRateLimitIntervalSeconds() const {
+    return settings_.load(std::memory_order_acquire)->rateLimitIntervalSeconds;
 }
 
 
 void Printer::print(const std::string& message, int lineNumber, const std::string& filename, int debugThreshold) const {
-    if (verbosity < debugThreshold) {
+    const PrinterSettings* settings = settings_.load(std::memory_order_acquire);
+    if (settings->verbosity < debugThreshold) {
         // If the verbosity level is below the debug threshold, don't print
         return;
     }
-    printWithColor(message, "", lineNumber, filename, infoColor);
+    printWithColor(message, "", lineNumber, filename, settings->infoColor);
 }
 
 void Printer::printWarning(const std::string& message, int lineNumber, const std::string& filename, int debugThreshold) const {
-    if (verbosity < debugThreshold) {
+    const PrinterSettings* settings = settings_.load(std::memory_order_acquire);
+    if (settings->verbosity < debugThreshold) {
         // If the verbosity level is below the debug threshold, don't print
         return;
     }
-    printWithColor(message, "WARNING", lineNumber, filename, warningColor);
+    printWithColor(message, "WARNING", lineNumber, filename, settings->warningColor);
 }
 
 void Printer::printError(const std::string& message, int lineNumber, const std::string& filename, int debugThreshold) const {
-    if (verbosity < debugThreshold) {
+    const PrinterSettings* settings = settings_.load(std::memory_order_acquire);
+    if (settings->verbosity < debugThreshold) {
         // If the verbosity level is below the debug threshold, don't print
         return;
     }
-    printWithColor(message, "ERROR", lineNumber, filename, errorColor);
+    printWithColor(message, "ERROR", lineNumber, filename, settings->errorColor);
 }
 
 void Printer::printWithColor(const std::string& message, const std::string& status, int lineNumber, const std::string& filename, const std::string& color) const {
     std::string messageString = buildMessageString(message, status, lineNumber, filename);
-    std::cout << colorizeString(messageString, color) << std::endl;
+    std::string record = colorizeString(messageString, color);
+    writeRecord(record);
+}
+
+void Printer::writeRecord(std::string& record) const {
+    if (!writerRunning_.load(std::memory_order_acquire)) {
+        std::cout << record << std::endl;
+        return;
+    }
+
+    while (!queue_.tryPush(record)) {
+        if (overflowPolicy == DROP_ON_OVERFLOW) {
+            droppedCount_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // Block policy: wait for the writer to make room, or write directly if it is shutting down
+        if (!writerRunning_.load(std::memory_order_acquire)) {
+            std::cout << record << std::endl;
+            return;
+        }
+        wakeCondition_.notify_one();
+        std::this_thread::yield();
+    }
+    queuedCount_.fetch_add(1, std::memory_order_relaxed);
+
+    if (writerSleeping_.load()) {
+        wakeCondition_.notify_one();
+    }
+}
+
+void Printer::startWriter() {
+    queue_.reset(queueCapacity > 0 ? queueCapacity : 1);
+    writerRunning_ = true;
+    writerThread_ = std::thread([this]() {
+        this->writerLoop();
+    });
+}
+
+void Printer::stopWriter() {
+    if (!writerThread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        writerRunning_ = false;
+    }
+    wakeCondition_.notify_one();
+    writerThread_.join();
+}
+
+void Printer::writerLoop() {
+    std::string record;
+    std::string batch;
+    unsigned long long reportedDropped = 0;
+
+    while (true) {
+        // Take whatever is queued and write it with a single flush
+        batch.clear();
+        size_t numRecords = 0;
+        while (numRecords < MAX_BATCH_SIZE && queue_.tryPop(record)) {
+            batch += record;
+            batch += '\n';
+            ++numRecords;
+        }
+
+        unsigned long long dropped = droppedCount_.load(std::memory_order_relaxed);
+        if (dropped != reportedDropped) {
+            batch += colorizeString(buildMessageString("Dropped " + std::to_string(dropped - reportedDropped) +
+                                                       " message(s), the print queue was full.", "WARNING", -1, ""),
+                                     settings_.load(std::memory_order_acquire)->warningColor);
+            batch += '\n';
+            reportedDropped = dropped;
+        }
+
+        if (!batch.empty()) {
+            std::cout.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+            std::cout.flush();
+            writtenCount_.fetch_add(numRecords, std::memory_order_release);
+            continue;
+        }
+
+        // The queue is drained, so stopping loses nothing
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        if (!writerRunning_) {
+            break;
+        }
+        writerSleeping_ = true;
+        wakeCondition_.wait_for(lock, WRITER_IDLE_WAIT, [this]() {
+            return queue_.size() > 0 || !writerRunning_;
+        });
+        writerSleeping_ = false;
+    }
+}
+
+void Printer::flush() const {
+    unsigned long long queued = queuedCount_.load(std::memory_order_relaxed);
+    while (writerRunning_.load(std::memory_order_acquire) && writtenCount_.load(std::memory_order_acquire) < queued) {
+        wakeCondition_.notify_one();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+unsigned long long Printer::getQueuedCount() const {
+    return queuedCount_.load(std::memory_order_relaxed);
+}
+
+unsigned long long Printer::getDroppedCount() const {
+    return droppedCount_.load(std::memory_order_relaxed);
 }
 
 std::string Printer::buildMessageString(const std::string& message, const std::string& status, int lineNumber, const std::string& filename) const {
+    const PrinterSettings& settings = *settings_.load(std::memory_order_acquire);
     std::string messageString;
     std::string trimmedFilename = filename;
+    const std::string& prefix = settings.prefix;
 
     // Include the current time within curly braces before everything else
-    if (printCurrentTime) {
+    if (settings.printCurrentTime) {
         std::string currentTime = getCurrentTime();
         messageString += "{" + currentTime + "} ";
     }
@@ -122,14 +335,18 @@ std::string Printer::getCurrentTime() const{
 
 
 std::string Printer::colorizeString(const std::string& message, const std::string& color) const {
-    std::string colorCode = getColorCode(color);
-    std::string resetCode = "\033[0m";
-    return colorCode + message + resetCode;
+    std::string colored = getColorCode(color);
+    colored += message;
+    colored += "\033[0m"; // Reset
+    return colored;
 }
 
-std::string Printer::getColorCode(const std::string& color) const {
+const char* Printer::getColorCode(const std::string& color) {
     // Map color names to ANSI color codes
-    std::unordered_map<std::string, std::string> colorMap = {
+    static const struct {
+        const char* name;
+        const char* code;
+    } colorCodes[] = {
         {"black", "\033[30m"},
         {"red", "\033[31m"},
         {"green", "\033[32m"},
@@ -140,9 +357,10 @@ std::string Printer::getColorCode(const std::string& color) const {
         {"white", "\033[37m"}
     };
 
-    if (colorMap.find(color) != colorMap.end()) {
-        return colorMap[color];
-    } else {
-        return ""; // Return an empty string for unknown colors
+    for (const auto& colorCode : colorCodes) {
+        if (color == colorCode.name) {
+            return colorCode.code;
+        }
     }
+    return ""; // Return an empty string for unknown colors
 }
@@ -0,0 +1,416 @@
+#include "ProcCapture.h"
+#include "ConfigManager.h"
+#include "Printer.h"
+#include <cerrno>
+#include <cstring>
+
+static const char CAPTURE_MAGIC[4] = {'S', 'Y', 'S', 'C'};
+static const unsigned long long CAPTURE_VERSION = 1;
+static const size_t CAPTURE_FILE_BUFFER_SIZE = 1 << 20;
+
+// Largest path and file contents a record may hold, larger sizes are taken as corruption before anything is
+// allocated for them. procfs files and listings stay far below this.
+static const unsigned long long MAX_PATH_BYTES = 4096;
+static const unsigned long long MAX_CONTENTS_BYTES = 64ULL << 20;
+
+// A 'D' record only resumes copying unchanged bytes after this many of them, shorter runs go out as literals
+static const size_t MIN_UNCHANGED_RUN = 4;
+
+ProcCapture& ProcCapture::getInstance() {
+    static ProcCapture instance;
+    return instance;
+}
+
+ProcCapture::ProcCapture()
+    : mode_(OFF), file_(nullptr), lastReadNs_(0), lastDeadlineNs_(0), lastTimeStampNs_(0), sampleNs_(0),
+      pendingTick_(), pendingTimeStampNs_(0), hasPendingTick_(false), ticks_(0) {
+    ConfigManager& configManager = ConfigManager::getInstance();
+    const std::string& mode = configManager.getCaptureMode();
+    if (mode == "record") {
+        reopen(RECORD, configManager.getCapturePath());
+    } else if (mode == "replay") {
+        reopen(REPLAY, configManager.getCapturePath());
+    } else if (mode != "off") {
+        PRINT_WARNING(-1, "Unknown system_info.capture.mode " + mode + ", reading procfs directly.");
+    }
+}
+
+ProcCapture::~ProcCapture() {
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+bool ProcCapture::reopen(Mode mode, const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    mode_ = OFF;
+    capturePath_ = path;
+    pathIds_.clear();
+    paths_.clear();
+    lastReadNs_ = 0;
+    lastDeadlineNs_ = 0;
+    lastTimeStampNs_ = 0;
+    sampleNs_ = 0;
+    pendingTick_ = TickInfo();
+    pendingTimeStampNs_ = 0;
+    hasPendingTick_ = false;
+    ticks_ = 0;
+
+    if (mode == RECORD) {
+        if (!openRecording(path)) {
+            return false;
+        }
+        PRINT_INFO(1, "Recording procfs reads to " + path + ".");
+    } else if (mode == REPLAY) {
+        if (!openReplay(path)) {
+            return false;
+        }
+        PRINT_INFO(1, "Replaying procfs reads from " + path + ".");
+    }
+    mode_ = mode;
+    return true;
+}
+
+bool ProcCapture::openRecording(const std::string& path) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        PRINT_ERROR(-1, "Failed to create the capture file " + path + ": " + std::string(strerror(errno)));
+        return false;
+    }
+    fileBuffer_.resize(CAPTURE_FILE_BUFFER_SIZE);
+    std::setvbuf(file_, fileBuffer_.data(), _IOFBF, fileBuffer_.size());
+
+    recordBuffer_.assign(CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    putVarint(CAPTURE_VERSION);
+    writeRecord();
+    return true;
+}
+
+bool ProcCapture::openReplay(const std::string& path) {
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) {
+        PRINT_ERROR(-1, "Failed to open the capture file " + path + ": " + std::string(strerror(errno)));
+        return false;
+    }
+    fileBuffer_.resize(CAPTURE_FILE_BUFFER_SIZE);
+    std::setvbuf(file_, fileBuffer_.data(), _IOFBF, fileBuffer_.size());
+
+    char magic[sizeof(CAPTURE_MAGIC)];
+    unsigned long long version = 0;
+    if (!getBytes(magic, sizeof(magic)) || std::memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) != 0 ||
+        !getVarint(version) || version != CAPTURE_VERSION) {
+        PRINT_ERROR(-1, path + " is not a capture file of this version.");
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+
+    // The reads recorded before the first tick are the ones the collectors make while initializing
+    readUntilTick();
+    return true;
+}
+
+ProcCapture::Mode ProcCapture::getMode() const {
+    return mode_;
+}
+
+bool ProcCapture::isRecording() const {
+    return mode_ == RECORD;
+}
+
+bool ProcCapture::isReplaying() const {
+    return mode_ == REPLAY;
+}
+
+long long ProcCapture::getSampleNanos() const {
+    return mode_ == REPLAY ? sampleNs_ : DeadlineTimer::getMonotonicNanos();
+}
+
+int ProcCapture::getPathId(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unordered_map<std::string, int>::const_iterator found = pathIds_.find(path);
+    if (found != pathIds_.end()) {
+        return found->second;
+    }
+    if (mode_ != RECORD) {
+        return -1;
+    }
+
+    int pathId = static_cast<int>(paths_.size());
+    pathIds_[path] = pathId;
+    PathState state = {path, std::string(), 0, 0, false};
+    paths_.push_back(state);
+
+    recordBuffer_.assign(1, 'P');
+    putVarint(static_cast<unsigned long long>(pathId));
+    putVarint(path.size());
+    recordBuffer_.append(path);
+    writeRecord();
+    return pathId;
+}
+
+void ProcCapture::recordRead(int pathId, const char* data, size_t size, int error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (mode_ != RECORD || pathId < 0 || static_cast<size_t>(pathId) >= paths_.size()) {
+        return;
+    }
+    PathState& state = paths_[pathId];
+    long long readNs = DeadlineTimer::getMonotonicNanos();
+
+    // Most of a procfs file is the same from one read to the next, so only the changed bytes are written
+    if (error == 0 && state.seen && state.error == 0) {
+        const std::string& previous = state.data;
+        recordBuffer_.assign(1, 'D');
+        putVarint(static_cast<unsigned long long>(pathId));
+        putSignedVarint(readNs - lastReadNs_);
+        putVarint(size);
+        size_t position = 0;
+        while (position < size) {
+            size_t unchangedStart = position;
+            while (position < size && position < previous.size() && data[position] == previous[position]) {
+                ++position;
+            }
+            size_t literalStart = position;
+            while (position < size) {
+                size_t run = 0;
+                while (run < MIN_UNCHANGED_RUN && position + run < size && position + run < previous.size() &&
+                       data[position + run] == previous[position + run]) {
+                    ++run;
+                }
+                if (run == MIN_UNCHANGED_RUN || (run > 0 && position + run == size)) {
+                    break;
+                }
+                ++position;
+            }
+            putVarint(literalStart - unchangedStart);
+            putVarint(position - literalStart);
+            recordBuffer_.append(data + literalStart, position - literalStart);
+        }
+    } else {
+        recordBuffer_.clear();
+    }
+    if (recordBuffer_.empty() || recordBuffer_.size() > size + 16) {
+        recordBuffer_.assign(1, 'R');
+        putVarint(static_cast<unsigned long long>(pathId));
+        putSignedVarint(readNs - lastReadNs_);
+        putVarint(static_cast<unsigned long long>(error));
+        putVarint(error == 0 ? size : 0);
+        if (error == 0) {
+            recordBuffer_.append(data, size);
+        }
+    }
+    writeRecord();
+
+    lastReadNs_ = readNs;
+    state.seen = true;
+    state.error = error;
+    state.readNs = readNs;
+    if (error == 0) {
+        state.data.assign(data, size);
+    } else {
+        state.data.clear();
+    }
+}
+
+void ProcCapture::recordTick(const TickInfo& tick, long long timeStampNs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (mode_ != RECORD) {
+        return;
+    }
+    recordBuffer_.assign(1, 'T');
+    putSignedVarint(tick.deadlineNs - lastDeadlineNs_);
+    putSignedVarint(tick.latenessNs);
+    putVarint(tick.missedTicks);
+    putSignedVarint(timeStampNs - lastTimeStampNs_);
+    writeRecord();
+    lastDeadlineNs_ = tick.deadlineNs;
+    lastTimeStampNs_ = timeStampNs;
+    ++ticks_;
+}
+
+void ProcCapture::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (mode_ == RECORD && file_) {
+        std::fflush(file_);
+    }
+}
+
+bool ProcCapture::canOpen(int pathId) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pathId < 0 || static_cast<size_t>(pathId) >= paths_.size() || !paths_[pathId].seen) {
+        errno = ENOENT;
+        return false;
+    }
+    if (paths_[pathId].error != 0) {
+        errno = paths_[pathId].error;
+        return false;
+    }
+    return true;
+}
+
+bool ProcCapture::replayRead(int pathId, std::vector<char>& buffer, size_t& length) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    length = 0;
+    if (pathId < 0 || static_cast<size_t>(pathId) >= paths_.size() || !paths_[pathId].seen) {
+        errno = ENOENT;
+        return false;
+    }
+    const PathState& state = paths_[pathId];
+    sampleNs_ = state.readNs;
+    if (state.error != 0) {
+        errno = state.error;
+        return false;
+    }
+
+    // Keep the room ProcFile expects after the contents, as a real read leaves it
+    if (buffer.size() <= state.data.size()) {
+        buffer.resize(state.data.size() + 1);
+    }
+    std::memcpy(buffer.data(), state.data.data(), state.data.size());
+    length = state.data.size();
+    return true;
+}
+
+bool ProcCapture::nextTick(TickInfo& tick, long long& timeStampNs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (mode_ != REPLAY || !hasPendingTick_) {
+        return false;
+    }
+    tick = pendingTick_;
+    timeStampNs = pendingTimeStampNs_;
+    ++ticks_;
+    readUntilTick();
+    return true;
+}
+
+bool ProcCapture::readUntilTick() {
+    hasPendingTick_ = false;
+    while (true) {
+        int type = getc_unlocked(file_);
+        if (type == EOF) {
+            return false;
+        }
+
+        unsigned long long pathId = 0;
+        unsigned long long size = 0;
+        long long readDeltaNs = 0;
+        bool valid = true;
+        if (type == 'P') {
+            valid = getVarint(pathId) && getVarint(size) && pathId == paths_.size() && size <= MAX_PATH_BYTES;
+            if (valid) {
+                PathState state = {std::string(size, '\0'), std::string(), 0, 0, false};
+                valid = getBytes(&state.path[0], size);
+                pathIds_[state.path] = static_cast<int>(pathId);
+                paths_.push_back(state);
+            }
+        } else if (type == 'R') {
+            unsigned long long error = 0;
+            valid = getVarint(pathId) && pathId < paths_.size() && getSignedVarint(readDeltaNs) && getVarint(error) && getVarint(size) &&
+                    size <= MAX_CONTENTS_BYTES;
+            if (valid) {
+                PathState& state = paths_[pathId];
+                state.data.resize(size);
+                valid = getBytes(&state.data[0], size);
+                state.error = static_cast<int>(error);
+            }
+        } else if (type == 'D') {
+            valid = getVarint(pathId) && pathId < paths_.size() && getSignedVarint(readDeltaNs) && getVarint(size) &&
+                    size <= MAX_CONTENTS_BYTES;
+            if (valid) {
+                PathState& state = paths_[pathId];
+                decodeBuffer_.resize(size);
+                size_t position = 0;
+                while (valid && position < size) {
+                    unsigned long long unchanged = 0;
+                    unsigned long long literal = 0;
+                    valid = getVarint(unchanged) && getVarint(literal) && unchanged + literal > 0 &&
+                            position + unchanged <= state.data.size() && position + unchanged + literal <= size;
+                    if (valid) {
+                        std::memcpy(&decodeBuffer_[position], state.data.data() + position, unchanged);
+                        position += unchanged;
+                        valid = getBytes(&decodeBuffer_[position], literal);
+                        position += literal;
+                    }
+                }
+                state.data.swap(decodeBuffer_);
+                state.error = 0;
+            }
+        } else if (type == 'T') {
+            long long deadlineDeltaNs = 0;
+            long long timeStampDeltaNs = 0;
+            valid = getSignedVarint(deadlineDeltaNs) && getSignedVarint(pendingTick_.latenessNs) &&
+                    getVarint(pendingTick_.missedTicks) && getSignedVarint(timeStampDeltaNs);
+            if (valid) {
+                lastDeadlineNs_ += deadlineDeltaNs;
+                lastTimeStampNs_ += timeStampDeltaNs;
+                pendingTick_.deadlineNs = lastDeadlineNs_;
+                pendingTimeStampNs_ = lastTimeStampNs_;
+                hasPendingTick_ = true;
+                return true;
+            }
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            PRINT_WARNING(-1, "The capture file " + capturePath_ + " is truncated or corrupt after " + std::to_string(ticks_) + " ticks.");
+            return false;
+        }
+        if (type == 'R' || type == 'D') {
+            lastReadNs_ += readDeltaNs;
+            paths_[pathId].readNs = lastReadNs_;
+            paths_[pathId].seen = true;
+        }
+    }
+}
+
+void ProcCapture::putVarint(unsigned long long value) {
+    while (value >= 0x80) {
+        recordBuffer_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    recordBuffer_.push_back(static_cast<char>(value));
+}
+
+void ProcCapture::putSignedVarint(long long value) {
+    // Zigzag, so small negative deltas stay short
+    putVarint((static_cast<unsigned long long>(value) << 1) ^ static_cast<unsigned long long>(value >> 63));
+}
+
+void ProcCapture::writeRecord() {
+    if (std::fwrite(recordBuffer_.data(), 1, recordBuffer_.size(), file_) != recordBuffer_.size()) {
+        PRINT_ERROR_RATE_LIMITED(-1, "Failed to write to the capture file " + capturePath_ + ": " + std::string(strerror(errno)));
+    }
+}
+
+bool ProcCapture::getVarint(unsigned long long& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = getc_unlocked(file_);
+        if (byte == EOF) {
+            return false;
+        }
+        value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ProcCapture::getSignedVarint(long long& value) {
+    unsigned long long encoded;
+    if (!getVarint(encoded)) {
+        return false;
+    }
+    value = static_cast<long long>(encoded >> 1) ^ -static_cast<long long>(encoded & 1);
+    return true;
+}
+
+bool ProcCapture::getBytes(char* data, size_t size) {
+    return size == 0 || std::fread(data, 1, size, file_) == size;
+}
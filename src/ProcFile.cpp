@@ -0,0 +1,181 @@
+#include "ProcFile.h"
+#include "ProcCapture.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+ProcFile::ProcFile(const std::string& path, size_t initialBufferSize)
+    : fd_(-1), captureId_(-1), replaying_(false), buffer_(initialBufferSize > 0 ? initialBufferSize : 1), length_(0) {
+    if (!path.empty()) {
+        open(path);
+    }
+}
+
+ProcFile::~ProcFile() {
+    close();
+}
+
+ProcFile::ProcFile(ProcFile&& other)
+    : path_(std::move(other.path_)), fd_(other.fd_), captureId_(other.captureId_), replaying_(other.replaying_),
+      buffer_(std::move(other.buffer_)), length_(other.length_) {
+    other.fd_ = -1;
+    other.captureId_ = -1;
+    other.replaying_ = false;
+    other.length_ = 0;
+}
+
+ProcFile& ProcFile::operator=(ProcFile&& other) {
+    if (this != &other) {
+        close();
+        path_ = std::move(other.path_);
+        fd_ = other.fd_;
+        captureId_ = other.captureId_;
+        replaying_ = other.replaying_;
+        buffer_ = std::move(other.buffer_);
+        length_ = other.length_;
+        other.fd_ = -1;
+        other.captureId_ = -1;
+        other.replaying_ = false;
+        other.length_ = 0;
+    }
+    return *this;
+}
+
+bool ProcFile::open(const std::string& path) {
+    close();
+    path_ = path;
+    ProcCapture& capture = ProcCapture::getInstance();
+    if (capture.isReplaying()) {
+        captureId_ = capture.getPathId(path_);
+        replaying_ = capture.canOpen(captureId_);
+        return replaying_;
+    }
+
+    fd_ = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (capture.isRecording()) {
+        // A failed open is recorded as a failed read, so the replay fails to open it as well
+        captureId_ = capture.getPathId(path_);
+        if (fd_ < 0) {
+            int error = errno;
+            capture.recordRead(captureId_, nullptr, 0, error);
+            errno = error;
+        }
+    }
+    return fd_ >= 0;
+}
+
+void ProcFile::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    captureId_ = -1;
+    replaying_ = false;
+    length_ = 0;
+}
+
+bool ProcFile::isOpen() const {
+    return fd_ >= 0 || replaying_;
+}
+
+const std::string& ProcFile::getPath() const {
+    return path_;
+}
+
+const char* ProcFile::data() const {
+    return buffer_.data();
+}
+
+size_t ProcFile::size() const {
+    return length_;
+}
+
+bool ProcFile::read() {
+    if (replaying_) {
+        return ProcCapture::getInstance().replayRead(captureId_, buffer_, length_);
+    }
+    if (fd_ < 0) {
+        errno = EBADF;
+        return false;
+    }
+    if (buffer_.empty()) {
+        buffer_.resize(1);
+    }
+
+    // procfs generates the file on each read, so it has to be read in one call to be consistent.
+    // If the buffer came back full the file may have been truncated: grow it and read again.
+    while (true) {
+        ssize_t bytesRead = ::pread(fd_, buffer_.data(), buffer_.size(), 0);
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            length_ = 0;
+            if (captureId_ >= 0) {
+                int error = errno;
+                ProcCapture::getInstance().recordRead(captureId_, nullptr, 0, error);
+                errno = error;
+            }
+            return false;
+        }
+        if (static_cast<size_t>(bytesRead) < buffer_.size()) {
+            length_ = static_cast<size_t>(bytesRead);
+            if (captureId_ >= 0) {
+                ProcCapture::getInstance().recordRead(captureId_, buffer_.data(), length_, 0);
+            }
+            return true;
+        }
+        buffer_.resize(buffer_.size() * 2);
+    }
+}
+
+bool ProcFile::listDirectory(const std::string& path, std::vector<std::string>& names) {
+    names.clear();
+    ProcCapture& capture = ProcCapture::getInstance();
+
+    // The listing goes through the capture as one read of the directory path, one name per line
+    std::string listing;
+    if (capture.isReplaying()) {
+        std::vector<char> buffer;
+        size_t length = 0;
+        if (!capture.replayRead(capture.getPathId(path), buffer, length)) {
+            return false;
+        }
+        listing.assign(buffer.data(), length);
+    } else {
+        DIR* directory = opendir(path.c_str());
+        if (!directory) {
+            if (capture.isRecording()) {
+                int error = errno;
+                capture.recordRead(capture.getPathId(path), nullptr, 0, error);
+                errno = error;
+            }
+            return false;
+        }
+        struct dirent* entry;
+        while ((entry = readdir(directory)) != nullptr) {
+            if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0) {
+                names.push_back(entry->d_name);
+            }
+        }
+        closedir(directory);
+        if (!capture.isRecording()) {
+            return true;
+        }
+        for (const std::string& name : names) {
+            listing += name;
+            listing += '\n';
+        }
+        capture.recordRead(capture.getPathId(path), listing.data(), listing.size(), 0);
+        return true;
+    }
+
+    size_t begin = 0;
+    for (size_t end = listing.find('\n'); end != std::string::npos; begin = end + 1, end = listing.find('\n', begin)) {
+        names.push_back(listing.substr(begin, end - begin));
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+#include "ProcStatReader.h"
+#include "ProcParse.h"
+#include <cstring>
+
+ProcStatReader::ProcStatReader(const std::string& path) : file_(path, INITIAL_BUFFER_SIZE) {
+}
+
+bool ProcStatReader::isOpen() const {
+    return file_.isOpen();
+}
+
+const std::string& ProcStatReader::getPath() const {
+    return file_.getPath();
+}
+
+const char* ProcStatReader::data() const {
+    return file_.data();
+}
+
+size_t ProcStatReader::size() const {
+    return file_.size();
+}
+
+int ProcStatReader::read(unsigned long long* user, unsigned long long* nice, unsigned long long* sys,
+                         unsigned long long* idle, int maxRows) {
+    if (!file_.read()) {
+        return -1;
+    }
+
+    const char* p = file_.data();
+    const char* end = p + file_.size();
+    int row = 0;
+
+    // The cpu lines are always the first lines of the file, stop at the first line that is not one
+    while (row < maxRows && end - p > 3 && std::memcmp(p, "cpu", 3) == 0) {
+        ProcParse::skipToken(p, end); // Skip the "cpu" / "cpuN" label
+        user[row] = ProcParse::parseUnsigned(p, end);
+        nice[row] = ProcParse::parseUnsigned(p, end);
+        sys[row] = ProcParse::parseUnsigned(p, end);
+        idle[row] = ProcParse::parseUnsigned(p, end);
+        ProcParse::nextLine(p, end);
+        ++row;
+    }
+
+    return row;
+}
+
+int ProcStatReader::countCpuLines() {
+    if (!file_.read()) {
+        return -1;
+    }
+
+    const char* p = file_.data();
+    const char* end = p + file_.size();
+    int count = 0;
+
+    while (end - p > 3 && std::memcmp(p, "cpu", 3) == 0) {
+        ProcParse::nextLine(p, end);
+        ++count;
+    }
+
+    return count;
+}
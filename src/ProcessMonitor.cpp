@@ -0,0 +1,288 @@
+#include "ProcessMonitor.h"
+#include "ConfigManager.h"
+#include "Printer.h"
+#include "ProcParse.h"
+#include <fnmatch.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+static void copyProcessName(const char* begin, const char* end, char* name, size_t nameSize) {
+    size_t length = static_cast<size_t>(end - begin);
+    if (length > nameSize - 1) {
+        length = nameSize - 1;
+    }
+    std::memcpy(name, begin, length);
+    name[length] = '\0';
+}
+
+ProcessMonitor::ProcessMonitor()
+    : procRoot_(ConfigManager::getInstance().getProcfsRoot()), rescanPeriodJiffies_(0), lastRescanJiffies_(0), rescanDue_(true), pageSize_(4096) {
+}
+
+const char* ProcessMonitor::getName() const {
+    return "processes";
+}
+
+void ProcessMonitor::init(unsigned long long jiffiesPerSecond, unsigned long long periodJiffies) {
+    ConfigManager& configManager = ConfigManager::getInstance();
+    pids_ = configManager.getWatchedProcessPids();
+    namePatterns_ = configManager.getWatchedProcessNames();
+    int rescanPeriod = configManager.getProcessRescanPeriodJiffies();
+    rescanPeriodJiffies_ = static_cast<unsigned long long>(rescanPeriod > 0 ? rescanPeriod : 0);
+    rescanDue_ = true;
+
+    long pageSize = sysconf(_SC_PAGESIZE);
+    pageSize_ = pageSize > 0 ? pageSize : 4096;
+
+    // Nothing to reserve slots for when no process is configured
+    int maxProcesses = configManager.getMaxWatchedProcesses();
+    size_t numSlots = (pids_.empty() && namePatterns_.empty()) || maxProcesses <= 0 ? 0 : static_cast<size_t>(maxProcesses);
+    slots_.clear();
+    slots_.resize(numSlots);
+    for (Slot& slot : slots_) {
+        slot.pid = 0;
+        slot.name[0] = '\0';
+        slot.firstJiffies = 0;
+        slot.rssBytes = 0;
+        slot.numThreads = 0;
+    }
+
+    counters_.init(NUM_COLUMNS, numSlots, jiffiesPerSecond, periodJiffies);
+
+    PRINT_INFO(2, "Process monitor watching up to " + std::to_string(numSlots) + " processes.");
+}
+
+bool ProcessMonitor::reconfigure(unsigned long long periodJiffies) {
+    int rescanPeriod = ConfigManager::getInstance().getProcessRescanPeriodJiffies();
+    rescanPeriodJiffies_ = static_cast<unsigned long long>(rescanPeriod > 0 ? rescanPeriod : 0);
+    return counters_.reconfigure(periodJiffies);
+}
+
+void ProcessMonitor::initSnapshot(SystemInfoData& data) {
+    ProcessInfo empty;
+    empty.pid = 0;
+    empty.name[0] = '\0';
+    empty.cpu_usage_percent = -1.0;
+    empty.cpu_real_time_step = 0.0;
+    empty.rss_bytes = 0;
+    empty.num_threads = 0;
+    data.processes.assign(slots_.size(), empty);
+    data.process_cpu_usage_percent_per_window.assign(counters_.getNumWindows() * slots_.size(), -1.0);
+
+    // Find the processes and take the first sample right away
+    collect(data);
+}
+
+bool ProcessMonitor::collect(SystemInfoData& data) {
+    if (slots_.empty()) {
+        return true;
+    }
+
+    unsigned long long jiffies = counters_.getCurrentJiffy();
+    if (rescanDue_ || jiffies - lastRescanJiffies_ >= rescanPeriodJiffies_) {
+        rescan(jiffies);
+    }
+
+    // Sample every watched process into its row of the pending slot, free rows stay at zero
+    unsigned long long* utime = counters_.getPendingColumn(UTIME_COLUMN);
+    unsigned long long* stime = counters_.getPendingColumn(STIME_COLUMN);
+    for (size_t index = 0; index < slots_.size(); ++index) {
+        Slot& slot = slots_[index];
+        utime[index] = 0;
+        stime[index] = 0;
+        if (slot.pid != 0 && !sampleSlot(slot, &utime[index], &stime[index])) {
+            PRINT_INFO(1, "Process " + std::string(slot.name) + " (" + std::to_string(slot.pid) + ") exited.");
+            release(slot);
+            rescanDue_ = true; // A replacement may already be running
+        }
+    }
+    counters_.commit(jiffies);
+
+    fillSnapshot(data);
+    return true;
+}
+
+void ProcessMonitor::fillSnapshot(SystemInfoData& data) {
+    size_t numSlots = slots_.size();
+    for (size_t index = 0; index < numSlots; ++index) {
+        const Slot& slot = slots_[index];
+        ProcessInfo& info = data.processes[index];
+        info.pid = slot.pid;
+        std::memcpy(info.name, slot.name, sizeof(info.name));
+        info.rss_bytes = slot.rssBytes;
+        info.num_threads = slot.numThreads;
+        info.cpu_usage_percent = -1.0;
+        info.cpu_real_time_step = 0.0;
+    }
+
+    for (size_t window = 0; window < counters_.getNumWindows(); ++window) {
+        size_t windowStart = counters_.findWindowStart(window);
+        double* usagePercent = data.process_cpu_usage_percent_per_window.data() + window * numSlots;
+
+        for (size_t index = 0; index < numSlots; ++index) {
+            const Slot& slot = slots_[index];
+            unsigned long long deltas[NUM_COLUMNS];
+            unsigned long long jiffiesPassed;
+            usagePercent[index] = -1.0;
+            if (slot.pid == 0 || !counters_.getDeltas(windowStart, index, slot.firstJiffies, deltas, jiffiesPassed)) {
+                continue;
+            }
+
+            // utime and stime count in clock ticks, the same unit as the sample jiffies
+            usagePercent[index] = static_cast<double>(deltas[UTIME_COLUMN] + deltas[STIME_COLUMN]) / jiffiesPassed * 100.0;
+            if (window == 0) {
+                data.processes[index].cpu_usage_percent = usagePercent[index];
+                data.processes[index].cpu_real_time_step = static_cast<double>(jiffiesPassed) / counters_.getJiffiesPerSecond();
+            }
+        }
+    }
+}
+
+bool ProcessMonitor::sampleSlot(Slot& slot, unsigned long long* utime, unsigned long long* stime) {
+    // Reads of a kept-open /proc/<pid> file fail with ESRCH once the process exited, even if the PID is reused
+    if (!slot.statFile.read() || slot.statFile.size() == 0 || !slot.statmFile.read()) {
+        return false;
+    }
+
+    // The command name may contain spaces and parentheses, the fields start after the last ')'
+    const char* begin = slot.statFile.data();
+    const char* end = begin + slot.statFile.size();
+    const char* p = end;
+    while (p > begin && *(p - 1) != ')') {
+        --p;
+    }
+    if (p == begin) {
+        return false;
+    }
+
+    // Fields after the name: state ppid pgrp session tty_nr tpgid flags minflt cminflt majflt cmajflt utime stime
+    // cutime cstime priority nice num_threads
+    for (int field = 0; field < 11; ++field) {
+        ProcParse::skipToken(p, end);
+    }
+    *utime = ProcParse::parseUnsigned(p, end);
+    *stime = ProcParse::parseUnsigned(p, end);
+    for (int field = 0; field < 4; ++field) {
+        ProcParse::skipToken(p, end);
+    }
+    slot.numThreads = static_cast<int>(ProcParse::parseUnsigned(p, end));
+
+    // statm: size resident shared text lib data dt, in pages
+    const char* m = slot.statmFile.data();
+    const char* mEnd = m + slot.statmFile.size();
+    ProcParse::skipToken(m, mEnd);
+    slot.rssBytes = static_cast<long long>(ProcParse::parseUnsigned(m, mEnd)) * pageSize_;
+    return true;
+}
+
+void ProcessMonitor::rescan(unsigned long long jiffies) {
+    lastRescanJiffies_ = jiffies;
+    rescanDue_ = false;
+
+    bool haveFreeSlot = false;
+    for (const Slot& slot : slots_) {
+        haveFreeSlot = haveFreeSlot || slot.pid == 0;
+    }
+    if (!haveFreeSlot) {
+        return;
+    }
+
+    for (int pid : pids_) {
+        if (pid > 0 && !isWatched(pid)) {
+            watch(pid, jiffies);
+        }
+    }
+
+    if (namePatterns_.empty()) {
+        return;
+    }
+
+    // Walking /proc opens one file per process, which is why it only happens every rescan_period_jiffies
+    if (!ProcFile::listDirectory(procRoot_, procEntries_)) {
+        PRINT_WARNING_RATE_LIMITED(-1, "Failed to open " + procRoot_ + " to look for watched processes: " + std::string(strerror(errno)));
+        return;
+    }
+    for (const std::string& entry : procEntries_) {
+        if (entry[0] < '1' || entry[0] > '9') {
+            continue;
+        }
+        int pid = std::atoi(entry.c_str());
+        if (isWatched(pid) || !commFile_.open(procRoot_ + "/" + entry + "/comm") || !commFile_.read()) {
+            continue;
+        }
+
+        char name[sizeof(ProcessInfo::name)];
+        const char* commEnd = commFile_.data() + commFile_.size();
+        if (commEnd > commFile_.data() && *(commEnd - 1) == '\n') {
+            --commEnd;
+        }
+        copyProcessName(commFile_.data(), commEnd, name, sizeof(name));
+
+        for (const std::string& pattern : namePatterns_) {
+            if (fnmatch(pattern.c_str(), name, 0) == 0) {
+                watch(pid, jiffies);
+                break;
+            }
+        }
+    }
+    commFile_.close();
+}
+
+bool ProcessMonitor::isWatched(int pid) const {
+    for (const Slot& slot : slots_) {
+        if (slot.pid == pid) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ProcessMonitor::watch(int pid, unsigned long long jiffies) {
+
+    for (Slot& slot : slots_) {
+        if (slot.pid != 0) {
+            continue;
+        }
+
+        std::string directory = procRoot_ + "/" + std::to_string(pid);
+        if (!slot.statFile.open(directory + "/stat") || !slot.statmFile.open(directory + "/statm") || !slot.statFile.read()) {
+            release(slot);
+            return false;
+        }
+
+        // The name sits between the first '(' and the last ')' of /proc/<pid>/stat
+        const char* begin = slot.statFile.data();
+        const char* end = begin + slot.statFile.size();
+        const char* nameBegin = std::find(begin, end, '(');
+        const char* nameEnd = end;
+        while (nameEnd > nameBegin && *(nameEnd - 1) != ')') {
+            --nameEnd;
+        }
+        if (nameBegin == end || nameEnd <= nameBegin + 1) {
+            release(slot);
+            return false;
+        }
+        copyProcessName(nameBegin + 1, nameEnd - 1, slot.name, sizeof(slot.name));
+
+        slot.pid = pid;
+        slot.firstJiffies = jiffies;
+        PRINT_INFO(1, "Watching process " + std::string(slot.name) + " (" + std::to_string(pid) + ").");
+        return true;
+    }
+
+    PRINT_WARNING_RATE_LIMITED(1, "No free slot to watch process " + std::to_string(pid) + ", raise system_info.processes.max_processes.");
+    return false;
+}
+
+void ProcessMonitor::release(Slot& slot) {
+    slot.statFile.close();
+    slot.statmFile.close();
+    slot.pid = 0;
+    slot.name[0] = '\0';
+    slot.firstJiffies = 0;
+    slot.rssBytes = 0;
+    slot.numThreads = 0;
+}
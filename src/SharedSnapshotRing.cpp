@@ -0,0 +1,302 @@
+#include "SharedSnapshotRing.h"
+#include "Printer.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+const uint32_t SharedSnapshotRing::MAGIC = 0x52535953; // "SYSR"
+const uint16_t SharedSnapshotRing::VERSION = 1;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "The shared ring needs address-free atomics to work across processes");
+
+static const size_t SLOT_ALIGNMENT = 64; // One cache line, so neighbouring slots never share one
+static const unsigned int MAX_READ_LATEST_ATTEMPTS = 1000; // A publish takes microseconds, this is far longer
+
+static size_t alignUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+static bool isProcessAlive(int pid) {
+    return pid > 0 && (::kill(pid, 0) == 0 || errno == EPERM);
+}
+
+// True if a live process other than this one is publishing into the ring currently named name
+static bool isPublishedByOtherProcess(const std::string& name, int& writerPid) {
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    bool published = false;
+    if (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(SharedRingHeader)) {
+        void* mapping = ::mmap(nullptr, sizeof(SharedRingHeader), PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping != MAP_FAILED) {
+            const SharedRingHeader* header = static_cast<const SharedRingHeader*>(mapping);
+            writerPid = header->writerPid;
+            published = header->magic.load(std::memory_order_acquire) == SharedSnapshotRing::MAGIC &&
+                        header->state.load(std::memory_order_acquire) == SharedSnapshotRing::ACTIVE &&
+                        writerPid != ::getpid() && isProcessAlive(writerPid);
+            ::munmap(mapping, sizeof(SharedRingHeader));
+        }
+    }
+    ::close(fd);
+    return published;
+}
+
+SharedSnapshotRing::SharedSnapshotRing() : fd_(-1), mapping_(nullptr), mappingSize_(0), header_(nullptr) {
+}
+
+SharedSnapshotRing::~SharedSnapshotRing() {
+    close();
+}
+
+bool SharedSnapshotRing::create(const std::string& name, const SnapshotSchema& schema, unsigned int numSlots) {
+    close();
+    if (numSlots == 0) {
+        numSlots = 1;
+    }
+
+    int writerPid = 0;
+    if (isPublishedByOtherProcess(name, writerPid)) {
+        PRINT_ERROR(-1, "Shared memory " + name + " is already published by process " + std::to_string(writerPid) + ".");
+        return false;
+    }
+
+    // Readers still mapping a stale ring keep their mapping, they see it closed or its writer gone and reopen
+    ::shm_unlink(name.c_str());
+    fd_ = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        PRINT_ERROR(-1, "Failed to create shared memory " + name + ": " + std::string(strerror(errno)));
+        return false;
+    }
+
+    std::string schemaJson = schema.toJson();
+    size_t schemaOffset = alignUp(sizeof(SharedRingHeader), SLOT_ALIGNMENT);
+    size_t slotsOffset = alignUp(schemaOffset + schemaJson.size(), SLOT_ALIGNMENT);
+    size_t slotStride = alignUp(sizeof(SharedRingSlot) + schema.getSize(), SLOT_ALIGNMENT);
+    size_t totalSize = slotsOffset + slotStride * numSlots;
+
+    // The object is zero filled, so every slot starts with sequence 0 (never written)
+    if (::ftruncate(fd_, static_cast<off_t>(totalSize)) != 0) {
+        PRINT_ERROR(-1, "Failed to size shared memory " + name + ": " + std::string(strerror(errno)));
+        ::close(fd_);
+        fd_ = -1;
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+    void* mapping = ::mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        PRINT_ERROR(-1, "Failed to map shared memory " + name + ": " + std::string(strerror(errno)));
+        ::close(fd_);
+        fd_ = -1;
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+
+    name_ = name;
+    mapping_ = static_cast<char*>(mapping);
+    mappingSize_ = totalSize;
+    schema_ = schema;
+    header_ = reinterpret_cast<SharedRingHeader*>(mapping_);
+    header_->version = VERSION;
+    header_->headerSize = static_cast<uint16_t>(sizeof(SharedRingHeader));
+    header_->numSlots = numSlots;
+    header_->slotStride = static_cast<uint32_t>(slotStride);
+    header_->snapshotSize = static_cast<uint32_t>(schema.getSize());
+    header_->schemaOffset = static_cast<uint32_t>(schemaOffset);
+    header_->schemaSize = static_cast<uint32_t>(schemaJson.size());
+    header_->slotsOffset = static_cast<uint32_t>(slotsOffset);
+    header_->schemaHash = schema.getHash();
+    header_->totalSize = totalSize;
+    header_->writerPid = ::getpid();
+    header_->state.store(ACTIVE, std::memory_order_relaxed);
+    header_->publishedCount.store(0, std::memory_order_relaxed);
+    std::memcpy(mapping_ + schemaOffset, schemaJson.data(), schemaJson.size());
+    header_->magic.store(MAGIC, std::memory_order_release);
+
+    PRINT_INFO(1, "Publishing snapshots to shared memory " + name + " (" + std::to_string(numSlots) + " slots, " +
+               std::to_string(totalSize) + " bytes).");
+    return true;
+}
+
+void SharedSnapshotRing::close() {
+    if (mapping_ == nullptr) {
+        return;
+    }
+    header_->state.store(CLOSED, std::memory_order_release);
+
+    // Only unlink the name if it still refers to this ring and not to one of a newer writer
+    int fd = ::shm_open(name_.c_str(), O_RDONLY, 0);
+    if (fd >= 0) {
+        struct stat current, own;
+        if (::fstat(fd, &current) == 0 && ::fstat(fd_, &own) == 0 && current.st_ino == own.st_ino) {
+            ::shm_unlink(name_.c_str());
+        }
+        ::close(fd);
+    }
+
+    ::munmap(mapping_, mappingSize_);
+    ::close(fd_);
+    fd_ = -1;
+    mapping_ = nullptr;
+    mappingSize_ = 0;
+    header_ = nullptr;
+}
+
+bool SharedSnapshotRing::isOpen() const {
+    return mapping_ != nullptr;
+}
+
+void SharedSnapshotRing::publish(const SystemInfoData& data) {
+    if (mapping_ == nullptr) {
+        return;
+    }
+
+    // Single writer: mark the slot odd, serialize, then make both the slot and the new count visible
+    uint64_t index = header_->publishedCount.load(std::memory_order_relaxed);
+    char* slotBytes = mapping_ + header_->slotsOffset + (index % header_->numSlots) * header_->slotStride;
+    SharedRingSlot* slot = reinterpret_cast<SharedRingSlot*>(slotBytes);
+    slot->sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    schema_.write(data, slotBytes + sizeof(SharedRingSlot), header_->snapshotSize);
+    slot->sequence.store(2 * index + 2, std::memory_order_release);
+    header_->publishedCount.store(index + 1, std::memory_order_release);
+}
+
+SharedSnapshotReader::SharedSnapshotReader() : fd_(-1), mapping_(nullptr), mappingSize_(0), header_(nullptr) {
+}
+
+SharedSnapshotReader::~SharedSnapshotReader() {
+    close();
+}
+
+bool SharedSnapshotReader::open(const std::string& name) {
+    close();
+    fd_ = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd_ < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (::fstat(fd_, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SharedRingHeader)) {
+        close(); // Not created yet, or still being sized by the writer
+        return false;
+    }
+    void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        return false;
+    }
+    mapping_ = static_cast<const char*>(mapping);
+    mappingSize_ = static_cast<size_t>(info.st_size);
+    header_ = reinterpret_cast<const SharedRingHeader*>(mapping_);
+
+    if (header_->magic.load(std::memory_order_acquire) != SharedSnapshotRing::MAGIC ||
+        header_->version != SharedSnapshotRing::VERSION || header_->headerSize != sizeof(SharedRingHeader) ||
+        header_->totalSize != mappingSize_ || header_->numSlots == 0 ||
+        static_cast<size_t>(header_->schemaOffset) + header_->schemaSize > mappingSize_ ||
+        static_cast<size_t>(header_->slotsOffset) + static_cast<size_t>(header_->slotStride) * header_->numSlots > mappingSize_ ||
+        sizeof(SharedRingSlot) + header_->snapshotSize > header_->slotStride) {
+        PRINT_WARNING(1, "Shared memory " + name + " is not a snapshot ring this version can read.");
+        close();
+        return false;
+    }
+
+    std::string schemaJson(mapping_ + header_->schemaOffset, header_->schemaSize);
+    if (!schema_.loadJson(schemaJson) || schema_.getHash() != header_->schemaHash || schema_.getSize() != header_->snapshotSize) {
+        PRINT_WARNING(1, "Shared memory " + name + " has an unreadable snapshot schema.");
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SharedSnapshotReader::close() {
+    if (mapping_ != nullptr) {
+        ::munmap(const_cast<char*>(mapping_), mappingSize_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+    mapping_ = nullptr;
+    mappingSize_ = 0;
+    header_ = nullptr;
+}
+
+bool SharedSnapshotReader::isOpen() const {
+    return mapping_ != nullptr;
+}
+
+bool SharedSnapshotReader::isWriterActive() const {
+    return header_ != nullptr && header_->state.load(std::memory_order_acquire) == SharedSnapshotRing::ACTIVE &&
+           isProcessAlive(header_->writerPid);
+}
+
+const SnapshotSchema& SharedSnapshotReader::getSchema() const {
+    return schema_;
+}
+
+unsigned int SharedSnapshotReader::getNumSlots() const {
+    return header_ != nullptr ? header_->numSlots : 0;
+}
+
+unsigned long long SharedSnapshotReader::getPublishedCount() const {
+    return header_ != nullptr ? header_->publishedCount.load(std::memory_order_acquire) : 0;
+}
+
+const SharedRingSlot* SharedSnapshotReader::getSlot(unsigned long long index) const {
+    return reinterpret_cast<const SharedRingSlot*>(mapping_ + header_->slotsOffset + (index % header_->numSlots) * header_->slotStride);
+}
+
+size_t SharedSnapshotReader::read(unsigned long long index, void* buffer, size_t capacity) const {
+    if (header_ == nullptr || buffer == nullptr || capacity < header_->snapshotSize) {
+        return 0;
+    }
+
+    // The slot must hold exactly this snapshot, complete, before and after the copy
+    uint64_t expected = 2 * static_cast<uint64_t>(index) + 2;
+    const SharedRingSlot* slot = getSlot(index);
+    if (slot->sequence.load(std::memory_order_acquire) != expected) {
+        return 0; // Not published yet, being overwritten, or already overwritten
+    }
+    std::memcpy(buffer, reinterpret_cast<const char*>(slot) + sizeof(SharedRingSlot), header_->snapshotSize);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot->sequence.load(std::memory_order_relaxed) != expected) {
+        return 0;
+    }
+    return header_->snapshotSize;
+}
+
+size_t SharedSnapshotReader::readLatest(void* buffer, size_t capacity, unsigned long long* index) const {
+    if (header_ == nullptr || buffer == nullptr || capacity < header_->snapshotSize) {
+        return 0;
+    }
+
+    // The latest slot is only rewritten once the writer went around the whole ring, so this rarely retries. A writer
+    // that died while publishing leaves the slot incomplete for good, so the retries stop once it is gone or after a bound.
+    for (unsigned int attempt = 0; attempt < MAX_READ_LATEST_ATTEMPTS; ++attempt) {
+        uint64_t count = header_->publishedCount.load(std::memory_order_acquire);
+        if (count == 0) {
+            return 0;
+        }
+        size_t written = read(count - 1, buffer, capacity);
+        if (written != 0) {
+            if (index != nullptr) {
+                *index = count - 1;
+            }
+            return written;
+        }
+        if (!isWriterActive()) {
+            return 0;
+        }
+        std::this_thread::yield();
+    }
+    return 0;
+}
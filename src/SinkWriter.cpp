@@ -0,0 +1,224 @@
+#include "SinkWriter.h"
+#include "DeadlineTimer.h"
+#include "Printer.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+static const std::chrono::milliseconds WRITER_IDLE_WAIT(50);
+
+SinkWriter::SinkWriter(const SinkConfig& config)
+    : config_(config), submittedCount_(0), writtenCount_(0), failedCount_(0), queueFullCount_(0), running_(false), flushRequested_(false),
+      batchRecords_(0), lastWriteNs_(0), fd_(-1), fileBytes_(0), fileOpenedNs_(0) {
+}
+
+SinkWriter::~SinkWriter() {
+    stop();
+}
+
+bool SinkWriter::start(const SnapshotSchema& schema) {
+    stop();
+    sink_ = SnapshotSink::create(config_.format);
+    if (!sink_) {
+        PRINT_ERROR(-1, "Unknown sink format \"" + config_.format + "\", expected csv, jsonl or binary.");
+        return false;
+    }
+    schema_ = schema;
+    fileHeader_.clear();
+    sink_->formatFileHeader(schema_, fileHeader_); // Once, rotation then only copies it
+
+    // Every buffer the sampler will ever use is allocated here, one per queue cell
+    freeBuffers_.reset(static_cast<size_t>(config_.queueCapacity > 0 ? config_.queueCapacity : 1));
+    filledBuffers_.reset(freeBuffers_.capacity());
+    for (size_t i = 0; i < freeBuffers_.capacity(); ++i) {
+        std::vector<char> buffer(schema_.getSize());
+        freeBuffers_.tryPush(buffer);
+    }
+    batch_.clear();
+    batch_.reserve(static_cast<size_t>(config_.batchBytes > 0 ? config_.batchBytes : 0) + fileHeader_.size() + schema_.getSize() * 32);
+    batchRecords_ = 0;
+    lastWriteNs_ = DeadlineTimer::getMonotonicNanos();
+
+    running_ = true;
+    thread_ = std::thread([this]() {
+        this->writerLoop();
+    });
+    PRINT_INFO(1, "Writing " + config_.format + " snapshots to " + config_.directory + "/" + config_.prefix + "-*." + sink_->getExtension());
+    return true;
+}
+
+void SinkWriter::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        running_ = false;
+    }
+    wakeCondition_.notify_one();
+    thread_.join();
+}
+
+void SinkWriter::submit(const SystemInfoData& data) {
+    if (!running_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::vector<char> buffer;
+    if (!freeBuffers_.tryPop(buffer)) {
+        queueFullCount_.fetch_add(1, std::memory_order_relaxed); // The writer is behind by a whole queue, nothing to wait for
+        return;
+    }
+    schema_.write(data, buffer.data(), buffer.size());
+    filledBuffers_.tryPush(buffer); // Never full, it has a cell for every buffer
+    submittedCount_.fetch_add(1, std::memory_order_release);
+}
+
+void SinkWriter::flush() {
+    // Only queued snapshots count, they are done once written or once their write failed
+    unsigned long long submitted = submittedCount_.load(std::memory_order_acquire);
+    while (thread_.joinable() && writtenCount_.load(std::memory_order_acquire) + failedCount_.load(std::memory_order_acquire) < submitted) {
+        flushRequested_ = true;
+        wakeCondition_.notify_one();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+const SinkConfig& SinkWriter::getConfig() const {
+    return config_;
+}
+
+unsigned long long SinkWriter::getWrittenCount() const {
+    return writtenCount_.load(std::memory_order_relaxed);
+}
+
+unsigned long long SinkWriter::getDroppedCount() const {
+    return queueFullCount_.load(std::memory_order_relaxed) + failedCount_.load(std::memory_order_relaxed);
+}
+
+void SinkWriter::writerLoop() {
+    long long flushNs = static_cast<long long>(config_.flushSeconds * 1e9);
+    size_t batchBytes = static_cast<size_t>(config_.batchBytes > 0 ? config_.batchBytes : 0);
+
+    while (true) {
+        size_t drained = drainQueue();
+        bool stopping = !running_.load(std::memory_order_acquire);
+        if (!batch_.empty() && (batch_.size() >= batchBytes || stopping || flushRequested_.exchange(false) ||
+                                DeadlineTimer::getMonotonicNanos() - lastWriteNs_ >= flushNs)) {
+            writeBatch();
+        }
+        if (drained > 0 || filledBuffers_.size() > 0) {
+            continue;
+        }
+
+        // The queue is drained, so stopping loses nothing
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        if (!running_) {
+            if (filledBuffers_.size() == 0) {
+                break;
+            }
+            continue;
+        }
+        wakeCondition_.wait_for(lock, WRITER_IDLE_WAIT);
+    }
+    if (!batch_.empty()) {
+        writeBatch();
+    }
+    closeFile();
+}
+
+size_t SinkWriter::drainQueue() {
+    // Stop at a full block, so batch_ stays within the capacity reserved in start()
+    size_t batchBytes = static_cast<size_t>(config_.batchBytes > 0 ? config_.batchBytes : 0);
+    std::vector<char> buffer;
+    size_t drained = 0;
+    while (batch_.size() < batchBytes && filledBuffers_.tryPop(buffer)) {
+        sink_->formatRecord(schema_, buffer.data(), batch_);
+        freeBuffers_.tryPush(buffer);
+        ++batchRecords_;
+        ++drained;
+    }
+    return drained;
+}
+
+void SinkWriter::writeBatch() {
+    long long now = DeadlineTimer::getMonotonicNanos();
+    lastWriteNs_ = now;
+
+    // Rotate at block boundaries, a file never ends in the middle of a record
+    if (fd_ >= 0 && ((config_.rotateBytes > 0 && fileBytes_ >= config_.rotateBytes) ||
+                     (config_.rotateSeconds > 0 && now - fileOpenedNs_ >= static_cast<long long>(config_.rotateSeconds) * 1000000000LL))) {
+        closeFile();
+    }
+    if (fd_ < 0 && !openFile()) {
+        failedCount_.fetch_add(batchRecords_, std::memory_order_release);
+        batch_.clear();
+        batchRecords_ = 0;
+        return;
+    }
+
+    const char* data = batch_.data();
+    size_t remaining = batch_.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(fd_, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            PRINT_ERROR_RATE_LIMITED(-1, "Failed to write " + config_.format + " snapshots: " + std::string(strerror(errno)));
+            closeFile(); // Try a new file for the next block
+            failedCount_.fetch_add(batchRecords_, std::memory_order_release);
+            batch_.clear();
+            batchRecords_ = 0;
+            return;
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+
+    fileBytes_ += static_cast<long long>(batch_.size());
+    writtenCount_.fetch_add(batchRecords_, std::memory_order_release);
+    batch_.clear();
+    batchRecords_ = 0;
+}
+
+bool SinkWriter::openFile() {
+    char timeText[32];
+    time_t now = std::time(nullptr);
+    struct tm localTime;
+    localtime_r(&now, &localTime);
+    std::strftime(timeText, sizeof(timeText), "%Y%m%d-%H%M%S", &localTime);
+
+    // Files rotated within the same second get a counter
+    std::string base = config_.directory + "/" + config_.prefix + "-" + timeText;
+    std::string path = base + "." + sink_->getExtension();
+    for (int attempt = 1; attempt < 1000; ++attempt) {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ >= 0 || errno != EEXIST) {
+            break;
+        }
+        path = base + "-" + std::to_string(attempt) + "." + sink_->getExtension();
+    }
+    if (fd_ < 0) {
+        PRINT_ERROR_RATE_LIMITED(-1, "Failed to create " + path + ": " + std::string(strerror(errno)));
+        return false;
+    }
+    fileOpenedNs_ = DeadlineTimer::getMonotonicNanos();
+    PRINT_INFO(2, "Writing snapshots to " + path);
+
+    // Each file describes itself, so the header goes in front of the first block
+    fileBytes_ = 0;
+    if (!fileHeader_.empty()) {
+        batch_.insert(0, fileHeader_);
+    }
+    return true;
+}
+
+void SinkWriter::closeFile() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
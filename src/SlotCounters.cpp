@@ -0,0 +1,96 @@
+#include "SlotCounters.h"
+#include "CpuUsageCalculator.h"
+#include "ProcCapture.h"
+#include <algorithm>
+#include <cmath>
+
+SlotCounters::SlotCounters() : jiffiesPerSecond_(100), periodJiffies_(1) {
+}
+
+void SlotCounters::init(size_t numColumns, size_t numSlots, unsigned long long jiffiesPerSecond, unsigned long long periodJiffies) {
+    jiffiesPerSecond_ = jiffiesPerSecond;
+    periodJiffies_ = periodJiffies > 0 ? periodJiffies : 1;
+    windowsJiffies_ = CpuUsageCalculator::getConfiguredWindowsJiffies();
+    counters_.reset(numColumns, numSlots, getHistorySize());
+}
+
+bool SlotCounters::reconfigure(unsigned long long periodJiffies) {
+    std::vector<unsigned long long> windowsJiffies = CpuUsageCalculator::getConfiguredWindowsJiffies();
+    bool windowsApplied = windowsJiffies.size() == windowsJiffies_.size();
+    if (windowsApplied) {
+        windowsJiffies_.swap(windowsJiffies);
+    }
+    periodJiffies_ = periodJiffies > 0 ? periodJiffies : 1;
+    counters_.resize(getHistorySize());
+    return windowsApplied;
+}
+
+size_t SlotCounters::getHistorySize() const {
+    unsigned long long longestWindowJiffies = *std::max_element(windowsJiffies_.begin(), windowsJiffies_.end());
+    return static_cast<size_t>(std::ceil(static_cast<double>(longestWindowJiffies) / periodJiffies_)) + 1;
+}
+
+unsigned long long SlotCounters::getCurrentJiffy() const {
+    return static_cast<unsigned long long>(ProcCapture::getInstance().getSampleNanos()) / (1000000000ULL / jiffiesPerSecond_);
+}
+
+unsigned long long SlotCounters::getJiffiesPerSecond() const {
+    return jiffiesPerSecond_;
+}
+
+size_t SlotCounters::getNumWindows() const {
+    return windowsJiffies_.size();
+}
+
+size_t SlotCounters::getNumSlots() const {
+    return counters_.getNumRows();
+}
+
+unsigned long long* SlotCounters::getPendingColumn(size_t column) {
+    return counters_.getPendingColumn(column);
+}
+
+void SlotCounters::clearPending() {
+    for (size_t column = 0; column < counters_.getNumColumns(); ++column) {
+        unsigned long long* rows = counters_.getPendingColumn(column);
+        std::fill(rows, rows + counters_.getNumRows(), 0ULL);
+    }
+}
+
+void SlotCounters::commit(unsigned long long jiffies) {
+    counters_.commit(jiffies);
+}
+
+size_t SlotCounters::findWindowStart(size_t window) const {
+    return counters_.findWindowStart(windowsJiffies_[window]);
+}
+
+bool SlotCounters::getDeltas(size_t windowStart, size_t slot, unsigned long long firstJiffies, unsigned long long* deltas,
+                             unsigned long long& jiffiesPassed) const {
+    jiffiesPassed = 0;
+    if (counters_.size() == 0) {
+        return false;
+    }
+    size_t newest = counters_.size() - 1;
+    unsigned long long newestJiffies = counters_.getJiffies(newest);
+
+    // Samples before the owner was first seen belong to whatever used the slot before it
+    size_t start = windowStart;
+    if (counters_.getJiffies(start) < firstJiffies) {
+        start = newestJiffies > firstJiffies ? counters_.findWindowStart(newestJiffies - firstJiffies) : newest;
+    }
+    if (start >= newest || newestJiffies <= counters_.getJiffies(start)) {
+        return false;
+    }
+
+    for (size_t column = 0; column < counters_.getNumColumns(); ++column) {
+        unsigned long long first = counters_.getColumn(column, start)[slot];
+        unsigned long long last = counters_.getColumn(column, newest)[slot];
+        if (last < first) {
+            return false;
+        }
+        deltas[column] = last - first;
+    }
+    jiffiesPassed = newestJiffies - counters_.getJiffies(start);
+    return true;
+}
@@ -0,0 +1,197 @@
+#include "SnapshotSchema.h"
+#include "SnapshotFields.h"
+#include <nlohmann/json.hpp>
+#include <cstring>
+
+const uint32_t SnapshotSchema::MAGIC = 0x4d535953; // "SYSM"
+const uint16_t SnapshotSchema::VERSION = 1;
+
+static const size_t FIELD_SIZE = 8;
+
+// Collects the name, type and offset of every metric
+class SchemaBuilder {
+public:
+    explicit SchemaBuilder(std::vector<SnapshotSchema::Field>& fields) : fields_(fields) {}
+
+    void visitInt(const SnapshotFieldName& name, long long) {
+        add(name, SnapshotSchema::INT64);
+    }
+
+    void visitDouble(const SnapshotFieldName& name, double) {
+        add(name, SnapshotSchema::DOUBLE);
+    }
+
+private:
+    void add(const SnapshotFieldName& name, SnapshotSchema::FieldType type) {
+        std::string fullName = name.group;
+        if (name.index >= 0) {
+            fullName += "[" + std::to_string(name.index) + "]";
+        }
+        if (name.subIndex >= 0) {
+            fullName += "[" + std::to_string(name.subIndex) + "]";
+        }
+        fullName += ".";
+        fullName += name.name;
+
+        uint32_t offset = static_cast<uint32_t>(sizeof(SnapshotHeader) + fields_.size() * FIELD_SIZE);
+        fields_.push_back({ fullName, type, offset });
+    }
+
+    std::vector<SnapshotSchema::Field>& fields_;
+};
+
+// Writes every metric into consecutive 8-byte slots, stopping at the end of the buffer
+class SnapshotWriter {
+public:
+    SnapshotWriter(char* begin, char* end) : cursor_(begin), end_(end), overflow_(false) {}
+
+    void visitInt(const SnapshotFieldName&, long long value) {
+        int64_t fixed = static_cast<int64_t>(value);
+        put(&fixed);
+    }
+
+    void visitDouble(const SnapshotFieldName&, double value) {
+        put(&value);
+    }
+
+    char* getCursor() const { return cursor_; }
+    bool overflowed() const { return overflow_; }
+
+private:
+    void put(const void* value) {
+        if (end_ - cursor_ < static_cast<std::ptrdiff_t>(FIELD_SIZE)) {
+            overflow_ = true;
+            return;
+        }
+        std::memcpy(cursor_, value, FIELD_SIZE); // memcpy, the caller's buffer does not have to be aligned
+        cursor_ += FIELD_SIZE;
+    }
+
+    char* cursor_;
+    char* end_;
+    bool overflow_;
+};
+
+SnapshotSchema::SnapshotSchema() : size_(sizeof(SnapshotHeader)), hash_(0) {
+}
+
+void SnapshotSchema::build(const SystemInfoData& shape) {
+    fields_.clear();
+    SchemaBuilder builder(fields_);
+    forEachSnapshotField(shape, builder);
+    size_ = sizeof(SnapshotHeader) + fields_.size() * FIELD_SIZE;
+
+    hash_ = computeHash(fields_);
+}
+
+uint64_t SnapshotSchema::computeHash(const std::vector<Field>& fields) {
+    // FNV-1a over the version and every field, so any change of the layout changes the hash
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const void* bytes, size_t length) {
+        const unsigned char* p = static_cast<const unsigned char*>(bytes);
+        for (size_t i = 0; i < length; ++i) {
+            hash = (hash ^ p[i]) * 1099511628211ULL;
+        }
+    };
+    mix(&VERSION, sizeof(VERSION));
+    for (const Field& field : fields) {
+        mix(field.name.data(), field.name.size() + 1);
+        mix(&field.type, sizeof(field.type));
+        mix(&field.offset, sizeof(field.offset));
+    }
+    return hash;
+}
+
+size_t SnapshotSchema::getSize() const {
+    return size_;
+}
+
+uint64_t SnapshotSchema::getHash() const {
+    return hash_;
+}
+
+const std::vector<SnapshotSchema::Field>& SnapshotSchema::getFields() const {
+    return fields_;
+}
+
+const SnapshotSchema::Field* SnapshotSchema::findField(const std::string& name) const {
+    for (const Field& field : fields_) {
+        if (field.name == name) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+size_t SnapshotSchema::write(const SystemInfoData& data, void* buffer, size_t capacity) const {
+    if (buffer == nullptr || capacity < size_) {
+        return 0;
+    }
+
+    char* begin = static_cast<char*>(buffer);
+    SnapshotHeader header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.headerSize = static_cast<uint16_t>(sizeof(SnapshotHeader));
+    header.numFields = static_cast<uint32_t>(fields_.size());
+    header.totalSize = static_cast<uint32_t>(size_);
+    header.schemaHash = hash_;
+    std::memcpy(begin, &header, sizeof(header));
+
+    SnapshotWriter writer(begin + sizeof(SnapshotHeader), begin + size_);
+    forEachSnapshotField(data, writer);
+    if (writer.overflowed() || writer.getCursor() != begin + size_) {
+        return 0; // The snapshot does not have the shape the schema was built for
+    }
+    return size_;
+}
+
+std::string SnapshotSchema::toJson() const {
+    nlohmann::json schema;
+    schema["version"] = VERSION;
+    schema["hash"] = hash_;
+    schema["size"] = size_;
+    nlohmann::json fields = nlohmann::json::array();
+    for (const Field& field : fields_) {
+        fields.push_back({ { "name", field.name }, { "type", field.type == INT64 ? "int64" : "double" }, { "offset", field.offset } });
+    }
+    schema["fields"] = fields;
+    return schema.dump();
+}
+
+bool SnapshotSchema::loadJson(const std::string& schemaJson) {
+    std::vector<Field> fields;
+    uint64_t hash;
+    size_t size;
+    try {
+        nlohmann::json schema = nlohmann::json::parse(schemaJson);
+        if (schema.at("version").get<uint16_t>() != VERSION) {
+            return false;
+        }
+        hash = schema.at("hash").get<uint64_t>();
+        size = schema.at("size").get<size_t>();
+        // Readers copy every field from its offset, so only the layout build() writes is accepted: consecutive
+        // 8 byte fields right after the header, each of a known type
+        for (const nlohmann::json& field : schema.at("fields")) {
+            std::string typeName = field.at("type").get<std::string>();
+            if (typeName != "int64" && typeName != "double") {
+                return false;
+            }
+            uint32_t offset = field.at("offset").get<uint32_t>();
+            if (offset != sizeof(SnapshotHeader) + fields.size() * FIELD_SIZE) {
+                return false;
+            }
+            fields.push_back({ field.at("name").get<std::string>(), typeName == "int64" ? INT64 : DOUBLE, offset });
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    if (computeHash(fields) != hash || size != sizeof(SnapshotHeader) + fields.size() * FIELD_SIZE) {
+        return false;
+    }
+    fields_.swap(fields);
+    size_ = size;
+    hash_ = hash;
+    return true;
+}
@@ -0,0 +1,109 @@
+#include "SnapshotSink.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+const uint32_t BinarySink::MAGIC = 0x42535953; // "SYSB"
+const uint16_t BinarySink::VERSION = 1;
+
+// Appends the value of a field as text, or "null" for a non-finite double if nullText is set
+static void appendValue(const SnapshotSchema::Field& field, const char* snapshot, const char* nullText, std::string& out) {
+    char text[32];
+    int length;
+    if (field.type == SnapshotSchema::INT64) {
+        int64_t value;
+        std::memcpy(&value, snapshot + field.offset, sizeof(value));
+        length = std::snprintf(text, sizeof(text), "%lld", static_cast<long long>(value));
+    } else {
+        double value;
+        std::memcpy(&value, snapshot + field.offset, sizeof(value));
+        if (nullText != nullptr && !std::isfinite(value)) {
+            out += nullText;
+            return;
+        }
+        length = std::snprintf(text, sizeof(text), "%.10g", value);
+    }
+    out.append(text, static_cast<size_t>(length));
+}
+
+std::unique_ptr<SnapshotSink> SnapshotSink::create(const std::string& format) {
+    if (format == "csv") {
+        return std::unique_ptr<SnapshotSink>(new CsvSink());
+    }
+    if (format == "jsonl") {
+        return std::unique_ptr<SnapshotSink>(new JsonLinesSink());
+    }
+    if (format == "binary") {
+        return std::unique_ptr<SnapshotSink>(new BinarySink());
+    }
+    return std::unique_ptr<SnapshotSink>();
+}
+
+const char* CsvSink::getExtension() const {
+    return "csv";
+}
+
+void CsvSink::formatFileHeader(const SnapshotSchema& schema, std::string& out) const {
+    const std::vector<SnapshotSchema::Field>& fields = schema.getFields();
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (i > 0) {
+            out += ',';
+        }
+        out += fields[i].name;
+    }
+    out += '\n';
+}
+
+void CsvSink::formatRecord(const SnapshotSchema& schema, const char* snapshot, std::string& out) const {
+    const std::vector<SnapshotSchema::Field>& fields = schema.getFields();
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (i > 0) {
+            out += ',';
+        }
+        appendValue(fields[i], snapshot, nullptr, out);
+    }
+    out += '\n';
+}
+
+const char* JsonLinesSink::getExtension() const {
+    return "jsonl";
+}
+
+void JsonLinesSink::formatFileHeader(const SnapshotSchema&, std::string&) const {
+    // Every line names its metrics, no header needed
+}
+
+void JsonLinesSink::formatRecord(const SnapshotSchema& schema, const char* snapshot, std::string& out) const {
+    const std::vector<SnapshotSchema::Field>& fields = schema.getFields();
+    out += '{';
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (i > 0) {
+            out += ',';
+        }
+        out += '"';
+        out += fields[i].name; // Metric names never need escaping
+        out += "\":";
+        appendValue(fields[i], snapshot, "null", out);
+    }
+    out += "}\n";
+}
+
+const char* BinarySink::getExtension() const {
+    return "bin";
+}
+
+void BinarySink::formatFileHeader(const SnapshotSchema& schema, std::string& out) const {
+    std::string schemaJson = schema.toJson();
+    BinarySinkHeader header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.headerSize = static_cast<uint16_t>(sizeof(BinarySinkHeader));
+    header.schemaSize = static_cast<uint32_t>(schemaJson.size());
+    header.recordSize = static_cast<uint32_t>(schema.getSize());
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    out += schemaJson;
+}
+
+void BinarySink::formatRecord(const SnapshotSchema& schema, const char* snapshot, std::string& out) const {
+    out.append(snapshot, schema.getSize());
+}
@@ -1,6 +1,7 @@
 #include "SystemInfo.h"
 #include "Printer.h"
 #include "ConfigManager.h"
+#include "ProcCapture.h"
 #include <sys/sysinfo.h>
 #include <unistd.h>
 #include <vector>
@@ -15,6 +16,9 @@
 #include <atomic>
 #include <iostream>
 #include <mutex>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
 
 
 SystemInfo* SystemInfo::instance_ = nullptr;
@@ -31,8 +35,14 @@ SystemInfo& SystemInfo::getInstance() {
 
 SystemInfo::SystemInfo() {
     initializeJiffiesInformation();
-    initNumCores();
-    initCpuUsage();
+    initCollectors();
+    initSnapshots();
+
+    // Pick up edits of the config file without a restart
+    ConfigManager& configManager = ConfigManager::getInstance();
+    if (configManager.getHotReloadEnabled() && !configManager.getConfigFile().empty()) {
+        configWatcher_.start(configManager.getConfigFile());
+    }
 }
 
 void SystemInfo::startPeriodicUpdates() {
@@ -56,296 +66,442 @@ void SystemInfo::stopPeriodicUpdates() {
     if (updateThread_.joinable()) {
         updateThread_.join();
     }
+
+    for (const std::unique_ptr<SinkWriter>& sink : sinks_) {
+        sink->flush();
+    }
+    ProcCapture::getInstance().flush();
+}
+
+// Wall clock time of a sample taken now
+static long long getTimeStampNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
 }
 
 void SystemInfo::periodicUpdate() {
-    while (running_) {
-        auto start = std::chrono::steady_clock::now();
+    if (ProcCapture::getInstance().isReplaying()) {
+        replayUpdates();
+        return;
+    }
+
+    // Drive the updates from absolute deadlines on the jiffy grid so jitter never turns into drift
+    long long nanosPerJiffy = getNanosPerJiffy();
+    DeadlineTimer timer;
+    long long startPeriodNs;
+    DeadlineTimer::OverrunPolicy startPolicy;
+    {
+        std::lock_guard<std::mutex> lock(updateMutex_);
+        startPeriodNs = static_cast<long long>(updatePeriodJiffies_) * nanosPerJiffy;
+        startPolicy = overrunPolicy_;
+    }
+    if (!timer.start(startPeriodNs, startPolicy, nanosPerJiffy)) {
+        PRINT_ERROR(-1, "Failed to create the update timer: " + std::string(strerror(errno)));
+        return;
+    }
+
+    // Stalls reported by the pressure triggers wake the thread before the next deadline
+    for (int fd : pressureCollector_.getTriggerFds()) {
+        if (!timer.addEventFd(fd)) {
+            PRINT_WARNING(-1, "Too many pressure triggers, only the first ones wake up the sampler.");
+            break;
+        }
+    }
+
+    TickInfo tick;
+    unsigned long long triggerEvents = 0;
+    while (running_ && timer.waitNextDeadline(tick, &triggerEvents)) {
+        if (!running_) {
+            break;
+        }
+        if (triggerEvents != 0) {
+            this->samplePressureEvent(triggerEvents, getTimeStampNanos());
+            continue;
+        }
+
+        if (tick.missedTicks > 0) {
+            PRINT_WARNING_RATE_LIMITED(2, "Missed " + std::to_string(tick.missedTicks) + " update(s), resuming " +
+                                       std::to_string(tick.latenessNs / 1e9) + " seconds after the latest deadline.");
+        }
 
         // Update system information
-        this->updateSystemInfo();
-
-        // Calculate the time to sleep
-        auto end = std::chrono::steady_clock::now();
-        std::chrono::duration<double> elapsed = end - start;
-        double elapsedSeconds = elapsed.count();
-        
-        // Calculate sleep time based on updatePeriodJiffies_
-        double updatePeriodSeconds = static_cast<double>(updatePeriodJiffies_) / jiffiesPerSecond_;
-        std::chrono::duration<double> sleepDuration = std::chrono::duration<double>(updatePeriodSeconds - elapsedSeconds);
-
-        // Sleep for the remaining duration
-        if (sleepDuration.count() > 0) {
-            std::this_thread::sleep_for(sleepDuration);
-        } else {
-            // If elapsed time exceeds the update period, log a warning or handle accordingly
-            Printer::getInstance().printWarning("Update period exceeded by " + std::to_string(-sleepDuration.count()) + " seconds.", __LINE__, __FILE__, -1);
+        this->sampleSystemInfo(tick, getTimeStampNanos());
+
+        // A reloaded config may have changed the period, which takes effect from the next deadline
+        long long periodNs;
+        DeadlineTimer::OverrunPolicy policy;
+        {
+            std::lock_guard<std::mutex> lock(updateMutex_);
+            periodNs = static_cast<long long>(updatePeriodJiffies_) * nanosPerJiffy;
+            policy = overrunPolicy_;
+        }
+        if (timer.getPeriodNs() != periodNs || timer.getOverrunPolicy() != policy) {
+            timer.setPeriod(periodNs, policy);
+        }
+
+        // The next deadline is fixed, so report if this update ran past it
+        long long overrunNs = DeadlineTimer::getMonotonicNanos() - (tick.deadlineNs + timer.getPeriodNs());
+        if (overrunNs > 0) {
+            PRINT_WARNING_RATE_LIMITED(-1, "Update period exceeded by " + std::to_string(overrunNs / 1e9) + " seconds.");
         }
     }
 }
 
+void SystemInfo::replayUpdates() {
+    // The recorded ticks are replayed at their recorded pace divided by replay_speed, or back to back at speed 0
+    ProcCapture& capture = ProcCapture::getInstance();
+    double speed = ConfigManager::getInstance().getReplaySpeed();
+    // Times are relative to the last read made while initializing, as the collectors were constructed then
+    long long startNs = DeadlineTimer::getMonotonicNanos();
+    long long recordedStartNs = capture.getSampleNanos();
+    unsigned long long ticks = 0;
+
+    TickInfo tick;
+    long long timeStampNs;
+    while (running_ && capture.nextTick(tick, timeStampNs)) {
+        if (ticks++ == 0 && recordedStartNs == 0) {
+            recordedStartNs = tick.deadlineNs;
+        }
+        if (speed > 0) {
+            long long dueNs = startNs + static_cast<long long>((tick.deadlineNs + tick.latenessNs - recordedStartNs) / speed);
+            long long remainingNs;
+            while (running_ && (remainingNs = dueNs - DeadlineTimer::getMonotonicNanos()) > 0) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(std::min(remainingNs, 100000000LL)));
+            }
+        }
+        this->sampleSystemInfo(tick, timeStampNs);
+    }
+    if (running_) {
+        PRINT_INFO(1, "Replay finished after " + std::to_string(ticks) + " ticks.");
+    }
+}
 
 void SystemInfo::updateSystemInfo() {
-    std::lock_guard<std::mutex> lock(dataMutex_);
-    Printer& printer = Printer::getInstance();
+    // A replay advances by one recorded tick per call, however much time passed
+    // The check and the sample happen under one lock, so concurrent callers never sample the same period twice
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    TickInfo replayedTick;
+    long long replayedTimeStampNs;
+    if (ProcCapture::getInstance().isReplaying()) {
+        if (ProcCapture::getInstance().nextTick(replayedTick, replayedTimeStampNs)) {
+            sampleSystemInfoLocked(replayedTick, replayedTimeStampNs);
+        }
+        return;
+    }
 
     // Get the current time in jiffies
     unsigned long long currentJiffies = getCurrentJiffy();
 
     // Check if the update period has passed
     if (currentJiffies - lastUpdateJiffies_ >= updatePeriodJiffies_) {
+        // Deadline of this update on the jiffy grid, relative to the previous update
+        TickInfo tick;
+        tick.deadlineNs = static_cast<long long>(lastUpdateJiffies_ + updatePeriodJiffies_) * getNanosPerJiffy();
+        tick.latenessNs = 0;
+        tick.missedTicks = 0;
+
         // Print a warning if the difference is greater than the update period
         if (lastUpdateJiffies_ != 0) {
+            tick.latenessNs = DeadlineTimer::getMonotonicNanos() - tick.deadlineNs;
             if (currentJiffies - lastUpdateJiffies_ > updatePeriodJiffies_) {
-                printer.printWarning("Missed an update. Time since last update: " + std::to_string(currentJiffies - lastUpdateJiffies_) +
-                                    " jiffies, which is greater than the update period of " + std::to_string(updatePeriodJiffies_) + " jiffies.", __LINE__, __FILE__, 2);
+                PRINT_WARNING_RATE_LIMITED(2, "Missed an update. Time since last update: " + std::to_string(currentJiffies - lastUpdateJiffies_) +
+                                           " jiffies, which is greater than the update period of " + std::to_string(updatePeriodJiffies_) + " jiffies.");
             }
-         }
-
-        struct sysinfo sys_info;
-        if (sysinfo(&sys_info) == 0) {
-            uptime_ = sys_info.uptime;
-            totalRam_ = sys_info.totalram;  
-            freeRam_ = sys_info.freeram;
-            usedRam_ = (sys_info.totalram - sys_info.freeram);
-            loadAvg1Min_ = sys_info.loads[0] / 65536.0;
-            loadAvg5Min_ = sys_info.loads[1] / 65536.0;
-            loadAvg15Min_ = sys_info.loads[2] / 65536.0;
         } else {
-            printer.printWarning("Failed to update CPU information.", __LINE__, __FILE__, -1);
+            tick.deadlineNs = DeadlineTimer::getMonotonicNanos();
         }
 
-        // Calculate CPU usage for a specified duration in config
-        setCpuUsageResult();
-
-        // Update the last update time
-        lastUpdateJiffies_ = currentJiffies;
+        sampleSystemInfoLocked(tick, getTimeStampNanos());
     }
 }
 
-void SystemInfo::initCpuUsage() {
-    Printer& printer = Printer::getInstance();
-    printer.print("Initializing CPU usage...", -1, "", 2);
-    // Open /proc/stat file
-    statFile_.open("/proc/stat");
-    if (statFile_.is_open()) {   
-        // Read CPU statistics from /proc/stat
-        statFile_ >> cpuLabel_ >> lastTotalUser_ >> lastTotalUserLow_ >> lastTotalSys_ >> lastTotalIdle_;
-        printer.print("Initial stats: lastTotalUser_: " + std::to_string(lastTotalUser_) +
-                                      ", lastTotalUserLow_: " + std::to_string(lastTotalUserLow_) +
-                                      ", lastTotalSys_: " + std::to_string(lastTotalSys_) +
-                                      ", lastTotalIdle_: " + std::to_string(lastTotalIdle_), -1, "", 2);
-        printer.print("CPU usage initialized.", -1, "", 2); 
-    } else {
-        printer.printWarning("Failed to open /proc/stat for initialization.", __LINE__, __FILE__, -1);
+// CPU time of the calling thread, counting only while it runs
+static long long getThreadCpuNanos() {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
     }
-    // Calculate CPU usage for a specified duration in config
-    addDataPointToBuffer();
+    return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
 }
 
-void SystemInfo::initializeJiffiesInformation() {
-    Printer& printer = Printer::getInstance();
-    printer.print("Initializing jiffies per second...", -1, "", 2);
+void SystemInfo::sampleSystemInfo(const TickInfo& tick, long long timeStampNs) {
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    sampleSystemInfoLocked(tick, timeStampNs);
+}
 
-    errno = 0; // Reset errno before sysconf
-    long tempJiffies = sysconf(_SC_CLK_TCK);
+void SystemInfo::sampleSystemInfoLocked(const TickInfo& tick, long long timeStampNs) {
+    long long cpuStartNs = getThreadCpuNanos();
 
-    if (tempJiffies == -1) {
-        // sysconf failed, handle the error
-        printer.printError("Error fetching jiffies per second: " + std::string(strerror(errno)), __LINE__, __FILE__, -1);
-        // Use default value
-        jiffiesPerSecond_ = 100ULL;
-        printer.printWarning("Fallback to default value: " + std::to_string(jiffiesPerSecond_), __LINE__, __FILE__, -1);
-    } else {
-        // Ensure tempJiffies is correctly cast to unsigned long long
-        jiffiesPerSecond_ = static_cast<unsigned long long>(tempJiffies);
-        printer.print("Jiffies per second: " + std::to_string(jiffiesPerSecond_), -1, "", 2);
+    // The watcher parsed the file already, so this only copies values and resizes buffers
+    if (configWatcher_.hasConfig()) {
+        applyReloadedConfig();
     }
 
-    updatePeriodJiffies_ = static_cast<unsigned long long>(ConfigManager::getInstance().getUpdatePeriodJiffies());
-    averagePeriodJiffies_ = static_cast<unsigned long long>(ConfigManager::getInstance().getAveragePeriodJiffies());
+    // The reads of the collectors follow their tick in a capture
+    ProcCapture::getInstance().recordTick(tick, timeStampNs);
 
-    // Check if average period is shorter than update period
-    if (averagePeriodJiffies_ < updatePeriodJiffies_) {
-        printer.printWarning(
-            "Warning: Average period (" + std::to_string(averagePeriodJiffies_) +
-            ") is shorter than update period (" + std::to_string(updatePeriodJiffies_) + ").",
-            __LINE__, __FILE__, -1
-        );
+    // Run the collectors whose period falls on this deadline, the others keep their previous values
+    unsigned long long deadlineJiffies = static_cast<unsigned long long>(tick.deadlineNs / getNanosPerJiffy());
+    long long collectStartNs = DeadlineTimer::getMonotonicNanos();
+    scheduler_.runDue(deadlineJiffies, timeStampNs, buildingSnapshot_);
+    long long collectNs = DeadlineTimer::getMonotonicNanos() - collectStartNs;
+    if (firstSampleNs_ == 0) {
+        firstSampleNs_ = collectStartNs;
     }
 
-    // Check if average period is not divisible by update period
-    if (updatePeriodJiffies_ != 0 && averagePeriodJiffies_ % updatePeriodJiffies_ != 0) {
-        printer.printWarning(
-            "Warning: Average period (" + std::to_string(averagePeriodJiffies_) +
-            ") is not divisible by update period (" + std::to_string(updatePeriodJiffies_) + ").",
-            __LINE__, __FILE__, -1
-        );
-    }
+    // Update the last update time and the timing of this sample
+    lastUpdateJiffies_ = getCurrentJiffy();
+    lastTick_ = tick;
+    missedUpdates_ += tick.missedTicks;
+
+    buildingSnapshot_.time_stamp_ns = timeStampNs;
+    buildingSnapshot_.sample_deadline_ns = lastTick_.deadlineNs;
+    buildingSnapshot_.sample_lateness_ns = lastTick_.latenessNs;
+    buildingSnapshot_.missed_updates = missedUpdates_;
+    updateMonitorStats(collectNs, tick.latenessNs);
+
+    // Make the new values visible to readers
+    publishSnapshot();
+    monitorCpuNs_ += getThreadCpuNanos() - cpuStartNs;
 }
 
-void SystemInfo::initNumCores() {
-    // Read the number of CPU cores from /proc/cpuinfo
-    int numCoresCpuInfo = 0;
-    std::ifstream cpuinfo("/proc/cpuinfo");
-    if (cpuinfo.is_open()) {
-        std::string line;
-        while (std::getline(cpuinfo, line)) {
-            if (line.substr(0, 9) == "processor") {
-                numCoresCpuInfo++;
-            }
-        }
-        cpuinfo.close();
-    } else {
-        Printer& printer = Printer::getInstance();
-        printer.printWarning("Failed to open /proc/cpuinfo to get the number of CPU cores.", __LINE__, __FILE__, -1);
-    }
-
-    // Read the number of CPU cores from /proc/stat
-    int numCoresProcStat = -1; //Start at -1 because we count the first line "cpu" which is just the total
-    std::ifstream procstat("/proc/stat");
-    if (procstat.is_open()) {
-        std::string line;
-        while (std::getline(procstat, line)) {
-            if (line.substr(0, 3) == "cpu") {
-                numCoresProcStat++;
-            }
-        }
-        procstat.close();
-    } else {
-        Printer& printer = Printer::getInstance();
-        printer.printWarning("Failed to open /proc/stat to get the number of CPU cores.", __LINE__, __FILE__, -1);
-    }
+void SystemInfo::samplePressureEvent(unsigned long long triggerEvents, long long timeStampNs) {
+    std::lock_guard<std::mutex> lock(updateMutex_);
 
-    // Check if the number of cores matches
-    if (numCoresProcStat != numCoresCpuInfo) {
-        Printer& printer = Printer::getInstance();
-        printer.printWarning("Number of CPU cores detected by /proc/cpuinfo is " + std::to_string(numCores_) + " and by /proc/stat is " + std::to_string(numCoresProcStat) + ".", __LINE__, __FILE__, -1);
+    // Only the pressure is sampled off the grid, and only readers of the snapshot see it right away. The ring, history,
+    // archive and sinks keep one snapshot per deadline and get the new values with the next one.
+    pressureCollector_.addTriggerEvents(triggerEvents);
+    scheduler_.runNow(&pressureCollector_, timeStampNs, buildingSnapshot_);
+    publishToReaders();
+}
+
+void SystemInfo::applyReloadedConfig() {
+    nlohmann::json fileContents;
+    if (!configWatcher_.takeConfig(fileContents)) {
+        return; // The watcher is storing a newer version, applied on the next sample
     }
 
-    // We will always chose to use /proc/stat
-    numCores_ = numCoresProcStat;
+    // A config with a period or window that is not positive is ignored as a whole, before any collector sees it
+    ConfigManager& configManager = ConfigManager::getInstance();
+    std::vector<std::string> ignoredSections;
+    if (!configManager.applyConfig(fileContents, ignoredSections)) {
+        return;
+    }
+    for (const std::string& section : ignoredSections) {
+        PRINT_WARNING(-1, "Config change in " + section + " takes effect after a restart.");
+    }
+    Printer::getInstance().reloadSettings();
 
+    // New periods keep the history each collector already has, as far as it fits
+    unsigned long long cpuPeriodJiffies = static_cast<unsigned long long>(configManager.getCollectorPeriodJiffies(cpuCollector_.getName()));
+    if (!cpuCollector_.reconfigure(cpuPeriodJiffies)) {
+        PRINT_WARNING(-1, "The number of CPU average windows changed, keeping the current windows until a restart.");
+    }
+    scheduler_.setCollectorPeriod(&cpuCollector_, cpuPeriodJiffies);
+    scheduler_.setCollectorPeriod(&memoryCollector_, static_cast<unsigned long long>(configManager.getCollectorPeriodJiffies(memoryCollector_.getName())));
+    scheduler_.setCollectorPeriod(&loadAverageCollector_, static_cast<unsigned long long>(configManager.getCollectorPeriodJiffies(loadAverageCollector_.getName())));
+    unsigned long long processPeriodJiffies = static_cast<unsigned long long>(configManager.getCollectorPeriodJiffies(processMonitor_.getName()));
+    if (!processMonitor_.reconfigure(processPeriodJiffies)) {
+        PRINT_WARNING(-1, "The number of process average windows changed, keeping the current windows until a restart.");
+    }
+    scheduler_.setCollectorPeriod(&processMonitor_, processPeriodJiffies);
+    unsigned long long networkPeriodJiffies = static_cast<unsigned long long>(configManager.getCollectorPeriodJiffies(networkCollector_.getName()));
+    if (!networkCollector_.reconfigure(networkPeriodJiffies)) {
+        PRINT_WARNING(-1, "The number of network average windows changed, keeping the current windows until a restart.");
+    }
+    scheduler_.setCollectorPeriod(&networkCollector_, networkPeriodJiffies);
+    unsigned long long diskPeriodJiffies = static_cast<unsigned long long>(configManager.getCollectorPeriodJiffies(diskCollector_.getName()));
+    if (!diskCollector_.reconfigure(diskPeriodJiffies)) {
+        PRINT_WARNING(-1, "The number of disk average windows changed, keeping the current windows until a restart.");
+    }
+    scheduler_.setCollectorPeriod(&diskCollector_, diskPeriodJiffies);
+    scheduler_.setCollectorPeriod(&pressureCollector_, static_cast<unsigned long long>(configManager.getCollectorPeriodJiffies(pressureCollector_.getName())));
+
+    // The update thread picks up the new base period after this sample
+    updatePeriodJiffies_ = scheduler_.getBasePeriodJiffies();
+    scheduler_.writePeriods(buildingSnapshot_, jiffiesPerSecond_);
+    overrunPolicy_ = DeadlineTimer::parseOverrunPolicy(configManager.getOverrunPolicy());
+    PRINT_INFO(1, "Reloaded " + configManager.getConfigFile() + ", update period: " + std::to_string(updatePeriodJiffies_) + " jiffies.");
 }
 
-double SystemInfo::getCpuUsage() const {
-    return getCpuUsageForCore(CpuUsageCalculator::TOTAL_CPU_USAGE_INDEX);
+void SystemInfo::updateMonitorStats(long long collectNs, long long latenessNs) {
+    ++samples_;
+    collectHistogram_.record(collectNs);
+    latenessHistogram_.record(latenessNs);
+
+    // One pass over each histogram for all of its percentiles
+    static const double percentiles[] = {50.0, 99.0};
+    long long values[2];
+    MonitorStats& monitor = buildingSnapshot_.monitor;
+    monitor.samples = samples_;
+    monitor.collect_ns = collectNs;
+    collectHistogram_.getValuesAtPercentiles(percentiles, 2, values);
+    monitor.collect_p50_ns = values[0];
+    monitor.collect_p99_ns = values[1];
+    monitor.collect_max_ns = collectHistogram_.getMax();
+    monitor.publish_lock_ns = lastPublishLockNs_;
+    publishLockHistogram_.getValuesAtPercentiles(percentiles, 2, values);
+    monitor.publish_lock_p50_ns = values[0];
+    monitor.publish_lock_p99_ns = values[1];
+    monitor.publish_lock_max_ns = publishLockHistogram_.getMax();
+    latenessHistogram_.getValuesAtPercentiles(percentiles, 2, values);
+    monitor.wakeup_lateness_p50_ns = values[0];
+    monitor.wakeup_lateness_p99_ns = values[1];
+    monitor.wakeup_lateness_max_ns = latenessHistogram_.getMax();
+    monitor.wakeup_jitter_ns = static_cast<long long>(latenessHistogram_.getStdDev());
+    monitor.cpu_time_ns = monitorCpuNs_;
+    long long wallNs = DeadlineTimer::getMonotonicNanos() - firstSampleNs_;
+    monitor.cpu_overhead_percent = wallNs > 0 ? 100.0 * static_cast<double>(monitorCpuNs_) / static_cast<double>(wallNs) : 0.0;
 }
 
-double SystemInfo::getTimeStep() const {
-    return getTimeStepForCore(CpuUsageCalculator::TOTAL_CPU_USAGE_INDEX);
-}
+void SystemInfo::initializeJiffiesInformation() {
+    PRINT_INFO(2, "Initializing jiffies per second...");
 
-double SystemInfo::getCpuUsageForCore(int core) const {
-    // Check if the core exists in the map
-    auto it = coreUsageResults_.find(core);
-    if (it != coreUsageResults_.end()) {
-        // Return the CPU usage percentage for the specified core
-        return it->second.usagePercent;
-    } else {
-        // Print a warning that the core wasn't found
-        Printer& printer = Printer::getInstance();
-        printer.printWarning("CPU usage for core " + std::to_string(core) + " not found.", __LINE__, __FILE__, -1);
-        return -1.0; // Default value
-    }
-}
+    errno = 0; // Reset errno before sysconf
+    long tempJiffies = sysconf(_SC_CLK_TCK);
 
-double SystemInfo::getTimeStepForCore(int core) const {
-    // Check if the core exists in the map
-    auto it = coreUsageResults_.find(core);
-    if (it != coreUsageResults_.end()) {
-        // Return the time step for the specified core
-        double secondsPassed = static_cast<double>(it->second.jiffiesPassed) / jiffiesPerSecond_;
-        return secondsPassed;
+    if (tempJiffies == -1) {
+        // sysconf failed, handle the error
+        PRINT_ERROR(-1, "Error fetching jiffies per second: " + std::string(strerror(errno)));
+        // Use default value
+        jiffiesPerSecond_ = 100ULL;
+        PRINT_WARNING(-1, "Fallback to default value: " + std::to_string(jiffiesPerSecond_));
     } else {
-        // Print a warning that the core wasn't found
-        Printer& printer = Printer::getInstance();
-        printer.printWarning("Time step for core " + std::to_string(core) + " not found.", __LINE__, __FILE__, -1);
-        return -1.0; // Default value
+        // Ensure tempJiffies is correctly cast to unsigned long long
+        jiffiesPerSecond_ = static_cast<unsigned long long>(tempJiffies);
+        PRINT_INFO(2, "Jiffies per second: " + std::to_string(jiffiesPerSecond_));
     }
 }
 
-
-double SystemInfo::getTotalRamMB() const {
-    return totalRam_ / 1024 /1024; // Convert to MB
+void SystemInfo::initCollectors() {
+    ConfigManager& configManager = ConfigManager::getInstance();
+
+    // Each collector runs at its own period, update_period_jiffies unless overridden in system_info.collectors
+    unsigned long long cpuPeriodJiffies = static_cast<unsigned long long>(configManager.getCollectorPeriodJiffies(cpuCollector_.getName()));
+    cpuCollector_.init(jiffiesPerSecond_, cpuPeriodJiffies);
+    scheduler_.addCollector(&cpuCollector_, cpuPeriodJiffies);
+    scheduler_.addCollector(&memoryCollector_, static_cast<unsigned long long>(configManager.getCollectorPeriodJiffies(memoryCollector_.getName())));
+    scheduler_.addCollector(&loadAverageCollector_, static_cast<unsigned long long>(configManager.getCollectorPeriodJiffies(loadAverageCollector_.getName())));
+    unsigned long long processPeriodJiffies = static_cast<unsigned long long>(configManager.getCollectorPeriodJiffies(processMonitor_.getName()));
+    processMonitor_.init(jiffiesPerSecond_, processPeriodJiffies);
+    scheduler_.addCollector(&processMonitor_, processPeriodJiffies);
+    unsigned long long networkPeriodJiffies = static_cast<unsigned long long>(configManager.getCollectorPeriodJiffies(networkCollector_.getName()));
+    networkCollector_.init(jiffiesPerSecond_, networkPeriodJiffies);
+    scheduler_.addCollector(&networkCollector_, networkPeriodJiffies);
+    unsigned long long diskPeriodJiffies = static_cast<unsigned long long>(configManager.getCollectorPeriodJiffies(diskCollector_.getName()));
+    diskCollector_.init(jiffiesPerSecond_, diskPeriodJiffies);
+    scheduler_.addCollector(&diskCollector_, diskPeriodJiffies);
+    pressureCollector_.init();
+    scheduler_.addCollector(&pressureCollector_, static_cast<unsigned long long>(configManager.getCollectorPeriodJiffies(pressureCollector_.getName())));
+
+    // The update thread ticks at the greatest common divisor of the collector periods
+    updatePeriodJiffies_ = scheduler_.getBasePeriodJiffies();
+    overrunPolicy_ = DeadlineTimer::parseOverrunPolicy(configManager.getOverrunPolicy());
+    PRINT_INFO(2, "Update period: " + std::to_string(updatePeriodJiffies_) + " jiffies.");
 }
 
-double SystemInfo::getFreeRamMB() const {
-    return freeRam_ / 1024 /1024; // Convert to MB;
-}
+void SystemInfo::initSnapshots() {
+    // Size both snapshots once, the writer never reallocates them afterwards
+    scheduler_.initSnapshot(buildingSnapshot_, jiffiesPerSecond_);
+    buildingSnapshot_.time_stamp_ns = 0;
+    buildingSnapshot_.sample_deadline_ns = 0;
+    buildingSnapshot_.sample_lateness_ns = 0;
+    buildingSnapshot_.missed_updates = 0;
+    copySystemInfoData(buildingSnapshot_, publishedSnapshot_);
+
+    // The shape is final, so is the serialized layout
+    snapshotSchema_.build(buildingSnapshot_);
+    ConfigManager& configManager = ConfigManager::getInstance();
+
+    // Optionally keep a compressed history of every metric within a fixed budget
+    if (configManager.getHistoryEnabled()) {
+        history_.init(snapshotSchema_, static_cast<size_t>(std::max(configManager.getHistoryMemoryBudgetBytes(), 0)),
+                      static_cast<size_t>(std::max(configManager.getHistoryBlockBytes(), 0)));
+        PRINT_INFO(2, "History of " + std::to_string(history_.getNumSeries()) + " metrics in " +
+                   std::to_string(history_.getMemoryBudget()) + " bytes.");
+    }
 
-double SystemInfo::getUsedRamMB() const {
-    return usedRam_ / 1024 /1024; // Convert to MB;
-}
+    // Optionally consolidate every snapshot into an archive file that outlives the process
+    if (configManager.getArchiveEnabled()) {
+        archive_.open(configManager.getArchivePath(), snapshotSchema_, configManager.getArchiveTiers());
+    }
 
-double SystemInfo::getTotalRam() const {
-    return totalRam_;
-}
+    // Stream snapshots to the configured output files
+    for (const SinkConfig& sinkConfig : configManager.getSinks()) {
+        std::unique_ptr<SinkWriter> sink(new SinkWriter(sinkConfig));
+        if (sink->start(snapshotSchema_)) {
+            sinks_.push_back(std::move(sink));
+        }
+    }
 
-double SystemInfo::getFreeRam() const {
-    return freeRam_;
+    // Optionally share every snapshot with the other processes on this node
+    if (configManager.getSharedMemoryEnabled()) {
+        int numSlots = configManager.getSharedMemorySlots();
+        sharedRing_.create(configManager.getSharedMemoryName(), snapshotSchema_, static_cast<unsigned int>(numSlots > 0 ? numSlots : 1));
+    }
 }
 
-double SystemInfo::getUsedRam() const {
-    return usedRam_; 
+void SystemInfo::publishSnapshot() {
+    publishToReaders();
+    if (sharedRing_.isOpen()) {
+        sharedRing_.publish(buildingSnapshot_);
+    }
+    history_.append(buildingSnapshot_);
+    archive_.append(buildingSnapshot_);
+    for (const std::unique_ptr<SinkWriter>& sink : sinks_) {
+        sink->submit(buildingSnapshot_);
+    }
 }
 
-double SystemInfo::getLoadAvg1Min() const {
-    return loadAvg1Min_;
+void SystemInfo::publishToReaders() {
+    // The snapshot was assembled outside the write section, so readers only wait for a plain copy
+    long long lockStartNs = DeadlineTimer::getMonotonicNanos();
+    snapshotLock_.writeBegin();
+    copySystemInfoData(buildingSnapshot_, publishedSnapshot_);
+    snapshotLock_.writeEnd();
+    lastPublishLockNs_ = DeadlineTimer::getMonotonicNanos() - lockStartNs;
+    publishLockHistogram_.record(lastPublishLockNs_);
 }
 
-double SystemInfo::getLoadAvg5Min() const {
-    return loadAvg5Min_;
+SystemInfoData SystemInfo::collectSystemInfo() const {
+    SystemInfoData data;
+    collectSystemInfo(data);
+    return data;
 }
 
-double SystemInfo::getLoadAvg15Min() const {
-    return loadAvg15Min_;
+void SystemInfo::collectSystemInfo(SystemInfoData& data) const {
+    // Copy optimistically and retry if the writer published while we were copying
+    unsigned long long sequence;
+    do {
+        sequence = snapshotLock_.readBegin();
+        copySystemInfoData(publishedSnapshot_, data);
+    } while (snapshotLock_.readRetry(sequence));
 }
 
-int SystemInfo::getNumCores() const {
-    return numCores_;
+size_t SystemInfo::writeSnapshot(void* buffer, size_t capacity) const {
+    // Serialize straight from the published snapshot and retry if the writer published meanwhile
+    size_t written;
+    unsigned long long sequence;
+    do {
+        sequence = snapshotLock_.readBegin();
+        written = snapshotSchema_.write(publishedSnapshot_, buffer, capacity);
+    } while (snapshotLock_.readRetry(sequence));
+    return written;
 }
 
-double SystemInfo::getLastUpdateTimestampNanos() const {
-    // Convert lastUpdate_ to nanoseconds since the Unix epoch
-    auto duration = lastUpdate_.time_since_epoch();
-    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+const SnapshotSchema& SystemInfo::getSnapshotSchema() const {
+    return snapshotSchema_;
 }
 
-SystemInfoData SystemInfo::collectSystemInfo() {
-    std::lock_guard<std::mutex> lock(dataMutex_);
-    SystemInfoData data;
-
-    // Populate data structure
-    data.total_ram = this->getTotalRam();
-    data.free_ram = this->getFreeRam();
-    data.total_ram_MB = this->getTotalRamMB();
-    data.free_ram_MB = this->getFreeRamMB();
-    data.cpu_usage_percent = this->getCpuUsage();
-    data.cpu_num_processors = this->getNumCores();
-    data.cpu_real_time_step = this->getTimeStep();
-
-    // Gather per-core data
-    data.cpu_usage_percent_per_core.resize(data.cpu_num_processors);
-    data.cpu_real_time_step_per_core.resize(data.cpu_num_processors);
-    for (int core = 0; core < data.cpu_num_processors; ++core) {
-        data.cpu_usage_percent_per_core[core] = this->getCpuUsageForCore(core);
-        data.cpu_real_time_step_per_core[core] = this->getTimeStepForCore(core);
-    }
-
-    // Load averages
-    data.load_avg_1min = this->getLoadAvg1Min();
-    data.load_avg_5min = this->getLoadAvg5Min();
-    data.load_avg_15min = this->getLoadAvg15Min();
-
-    //Timestamp
-    data.time_stamp_ns = getLastUpdateTimestampNanos();
+const HistoryStore& SystemInfo::getHistory() const {
+    return history_;
+}
 
-    return data;
+std::vector<double> SystemInfo::packageSystemInfoForMIDAS() const {
+    return packageSystemInfoForMIDAS(this->collectSystemInfo());
 }
 
-std::vector<double> SystemInfo::packageSystemInfoForMIDAS() {
-    SystemInfoData data = this->collectSystemInfo();
+std::vector<double> SystemInfo::packageSystemInfoForMIDAS(const SystemInfoData& data) {
     std::vector<double> packagedData;
 
     packagedData.push_back(static_cast<double>(0)); //Initialize with 0
@@ -362,139 +518,65 @@ std::vector<double> SystemInfo::packageSystemInfoForMIDAS() {
         packagedData.push_back(data.cpu_usage_percent_per_core[core]);
         packagedData.push_back(data.cpu_real_time_step_per_core[core]);
     }
-    packagedData[0] = static_cast<double>(packagedData.size()-1); 
-
-    return packagedData;
-}
-
-void SystemInfo::setCpuUsageResult() {
-    Printer& printer = Printer::getInstance(); // Initialize Printer for debug printing
-
-    // Check if the file is open
-    if (!statFile_.is_open()) {
-        printer.print("Error: statFile_ is not open.", -1, "", 2);
-        return;
-    }
-
-    // Move the stream cursor to the beginning of the file
-    statFile_.clear(); // Clear any EOF or fail flags
-    statFile_.seekg(0);
-
-    // Read total CPU usage information (first line)
-    std::string line;
-    if (!std::getline(statFile_, line)) {
-        printer.print("Error: Failed to read the first line from the file.", -1, "", 2);
-        return;
+    // Appended after the legacy layout so existing consumers keep their offsets
+    const MonitorStats& monitor = data.monitor;
+    packagedData.push_back(static_cast<double>(data.missed_updates));
+    packagedData.push_back(static_cast<double>(data.sample_lateness_ns));
+    packagedData.push_back(static_cast<double>(monitor.samples));
+    packagedData.push_back(static_cast<double>(monitor.collect_ns));
+    packagedData.push_back(static_cast<double>(monitor.collect_p50_ns));
+    packagedData.push_back(static_cast<double>(monitor.collect_p99_ns));
+    packagedData.push_back(static_cast<double>(monitor.collect_max_ns));
+    packagedData.push_back(static_cast<double>(monitor.publish_lock_ns));
+    packagedData.push_back(static_cast<double>(monitor.publish_lock_p50_ns));
+    packagedData.push_back(static_cast<double>(monitor.publish_lock_p99_ns));
+    packagedData.push_back(static_cast<double>(monitor.publish_lock_max_ns));
+    packagedData.push_back(static_cast<double>(monitor.wakeup_lateness_p50_ns));
+    packagedData.push_back(static_cast<double>(monitor.wakeup_lateness_p99_ns));
+    packagedData.push_back(static_cast<double>(monitor.wakeup_lateness_max_ns));
+    packagedData.push_back(static_cast<double>(monitor.wakeup_jitter_ns));
+    packagedData.push_back(static_cast<double>(monitor.cpu_time_ns));
+    packagedData.push_back(monitor.cpu_overhead_percent);
+    packagedData.push_back(static_cast<double>(data.network_interfaces.size()));
+    for (const NetworkInterfaceInfo& interface : data.network_interfaces) {
+        packagedData.push_back(interface.rx_bytes_per_second);
+        packagedData.push_back(interface.tx_bytes_per_second);
+        packagedData.push_back(interface.rx_packets_per_second);
+        packagedData.push_back(interface.tx_packets_per_second);
+        packagedData.push_back(interface.rx_errors_per_second);
+        packagedData.push_back(interface.tx_errors_per_second);
+        packagedData.push_back(interface.rx_dropped_per_second);
+        packagedData.push_back(interface.tx_dropped_per_second);
     }
-
-    std::istringstream totalCpuStream(line);
-    std::string cpuLabel;
-    unsigned long long totalUser, totalUserLow, totalSys, totalIdle;
-    totalCpuStream >> cpuLabel >> totalUser >> totalUserLow >> totalSys >> totalIdle;
-
-    // Get the current jiffy
-    unsigned long long currentJiffy = getCurrentJiffy();
-
-    // Calculate CPU Usage for the total CPU
-    CpuUsageCalculator& cpuUsageCalculator = CpuUsageCalculator::getInstanceForTotal();
-    cpuUsageCalculator.addDataPointForTotal(totalUser, totalUserLow, totalSys, totalIdle, currentJiffy);
-
-    // Calculate CPU usage result for the total CPU
-    coreUsageResults_[CpuUsageCalculator::TOTAL_CPU_USAGE_INDEX] = cpuUsageCalculator.calculateCpuUsagePercentForTotal();
-
-    // Read lines for each core, up to numCores_
-    std::vector<std::string> coreLines(numCores_); // Allocate space for core lines
-    int coreCount = 0;
-    
-    while (coreCount < numCores_ && std::getline(statFile_, line)) {
-        coreLines[coreCount] = line;
-        ++coreCount;
+    packagedData.push_back(static_cast<double>(data.disk_devices.size()));
+    for (const DiskDeviceInfo& device : data.disk_devices) {
+        packagedData.push_back(device.read_iops);
+        packagedData.push_back(device.write_iops);
+        packagedData.push_back(device.read_bytes_per_second);
+        packagedData.push_back(device.write_bytes_per_second);
+        packagedData.push_back(device.await_ms);
+        packagedData.push_back(device.queue_depth);
+        packagedData.push_back(device.utilization_percent);
     }
-
-    // Iterate over each core
-    for (int core = 0; core < numCores_; ++core) {
-        if (core >= coreLines.size() || coreLines[core].empty()) {
-            printer.print("Core " + std::to_string(core) + " data is not available.", -1, "", 2);
-            continue;
-        }
-
-        // Parse the line for the current core
-        std::istringstream coreStream(coreLines[core]);
-        coreStream >> cpuLabel >> totalUser >> totalUserLow >> totalSys >> totalIdle;
-
-        // Calculate CPU Usage for each core
-        CpuUsageCalculator& cpuUsageCalculator = CpuUsageCalculator::getInstanceForCore(core);
-        cpuUsageCalculator.addDataPointForCore(core, totalUser, totalUserLow, totalSys, totalIdle, currentJiffy);
-
-        // Calculate CPU usage result for the current core
-        coreUsageResults_[core] = cpuUsageCalculator.calculateCpuUsagePercentForCore(core);
+    for (const PressureInfo* pressure : { &data.pressure_cpu, &data.pressure_memory, &data.pressure_io }) {
+        packagedData.push_back(pressure->some_avg10);
+        packagedData.push_back(pressure->some_avg60);
+        packagedData.push_back(pressure->some_avg300);
+        packagedData.push_back(pressure->some_stall_percent);
+        packagedData.push_back(pressure->full_avg10);
+        packagedData.push_back(pressure->full_avg60);
+        packagedData.push_back(pressure->full_avg300);
+        packagedData.push_back(pressure->full_stall_percent);
     }
-    
-    lastUpdate_ = std::chrono::high_resolution_clock::now(); // Use high_resolution_clock for unix timestamp
+    packagedData[0] = static_cast<double>(packagedData.size()-1); 
 
+    return packagedData;
 }
 
-void SystemInfo::addDataPointToBuffer() {
-    Printer& printer = Printer::getInstance(); // Initialize Printer for debug printing
-
-    // Check if the file is open
-    if (!statFile_.is_open()) {
-        printer.print("Error: statFile_ is not open.", -1, "", 2);
-        return;
-    }
-
-    // Move the stream cursor to the beginning of the file
-    statFile_.clear(); // Clear any EOF or fail flags
-    statFile_.seekg(0);
-
-    // Read total CPU usage information (first line)
-    std::string line;
-    if (!std::getline(statFile_, line)) {
-        printer.print("Error: Failed to read the first line from the file.", -1, "", 2);
-        return;
-    }
-
-    std::istringstream totalCpuStream(line);
-    std::string cpuLabel;
-    unsigned long long totalUser, totalUserLow, totalSys, totalIdle;
-    totalCpuStream >> cpuLabel >> totalUser >> totalUserLow >> totalSys >> totalIdle;
-
-    // Get the current jiffy
-    unsigned long long currentJiffy = getCurrentJiffy();
-
-    // Calculate CPU Usage for the total CPU
-    CpuUsageCalculator& cpuUsageCalculator = CpuUsageCalculator::getInstanceForTotal();
-    cpuUsageCalculator.addDataPointForTotal(totalUser, totalUserLow, totalSys, totalIdle, currentJiffy);
-
-    // Read lines for each core, up to numCores_
-    std::vector<std::string> coreLines(numCores_); // Allocate space for core lines
-    int coreCount = 0;
-    
-    while (coreCount < numCores_ && std::getline(statFile_, line)) {
-        coreLines[coreCount] = line;
-        ++coreCount;
-    }
-
-    // Iterate over each core
-    for (int core = 0; core < numCores_; ++core) {
-        if (core >= coreLines.size() || coreLines[core].empty()) {
-            printer.print("Core " + std::to_string(core) + " data is not available.", -1, "", 2);
-            continue;
-        }
-
-        // Parse the line for the current core
-        std::istringstream coreStream(coreLines[core]);
-        coreStream >> cpuLabel >> totalUser >> totalUserLow >> totalSys >> totalIdle;
-
-        // Calculate CPU Usage for each core
-        CpuUsageCalculator& cpuUsageCalculator = CpuUsageCalculator::getInstanceForCore(core);
-        cpuUsageCalculator.addDataPointForCore(core, totalUser, totalUserLow, totalSys, totalIdle, currentJiffy);
-
-    }
+long long SystemInfo::getNanosPerJiffy() const {
+    return 1000000000LL / static_cast<long long>(jiffiesPerSecond_);
 }
 
-
-
 unsigned long long SystemInfo::getCurrentJiffy() {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
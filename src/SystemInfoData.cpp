@@ -0,0 +1,39 @@
+#include "SystemInfoData.h"
+
+void copySystemInfoData(const SystemInfoData& from, SystemInfoData& to) {
+    to.total_ram = from.total_ram;
+    to.free_ram = from.free_ram;
+    to.total_ram_MB = from.total_ram_MB;
+    to.free_ram_MB = from.free_ram_MB;
+    to.memory = from.memory;
+    to.cpu_usage_percent = from.cpu_usage_percent;
+    to.cpu_num_processors = from.cpu_num_processors;
+    to.cpu_real_time_step = from.cpu_real_time_step;
+    // assign() keeps the existing storage when the sizes match
+    to.cpu_usage_percent_per_core.assign(from.cpu_usage_percent_per_core.begin(), from.cpu_usage_percent_per_core.end());
+    to.cpu_real_time_step_per_core.assign(from.cpu_real_time_step_per_core.begin(), from.cpu_real_time_step_per_core.end());
+    to.cpu_window_jiffies.assign(from.cpu_window_jiffies.begin(), from.cpu_window_jiffies.end());
+    to.cpu_usage_percent_per_window.assign(from.cpu_usage_percent_per_window.begin(), from.cpu_usage_percent_per_window.end());
+    to.cpu_real_time_step_per_window.assign(from.cpu_real_time_step_per_window.begin(), from.cpu_real_time_step_per_window.end());
+    to.cpu_usage_percent_per_window_per_core.assign(from.cpu_usage_percent_per_window_per_core.begin(), from.cpu_usage_percent_per_window_per_core.end());
+    to.processes.assign(from.processes.begin(), from.processes.end());
+    to.process_cpu_usage_percent_per_window.assign(from.process_cpu_usage_percent_per_window.begin(), from.process_cpu_usage_percent_per_window.end());
+    to.load_avg_1min = from.load_avg_1min;
+    to.load_avg_5min = from.load_avg_5min;
+    to.load_avg_15min = from.load_avg_15min;
+    to.pressure_cpu = from.pressure_cpu;
+    to.pressure_memory = from.pressure_memory;
+    to.pressure_io = from.pressure_io;
+    to.time_stamp_ns = from.time_stamp_ns;
+    to.sample_deadline_ns = from.sample_deadline_ns;
+    to.sample_lateness_ns = from.sample_lateness_ns;
+    to.missed_updates = from.missed_updates;
+    to.source_freshness.assign(from.source_freshness.begin(), from.source_freshness.end());
+    to.monitor = from.monitor;
+    to.network_interfaces.assign(from.network_interfaces.begin(), from.network_interfaces.end());
+    to.network_rx_bytes_per_second_per_window.assign(from.network_rx_bytes_per_second_per_window.begin(), from.network_rx_bytes_per_second_per_window.end());
+    to.network_tx_bytes_per_second_per_window.assign(from.network_tx_bytes_per_second_per_window.begin(), from.network_tx_bytes_per_second_per_window.end());
+    to.disk_devices.assign(from.disk_devices.begin(), from.disk_devices.end());
+    to.disk_utilization_percent_per_window.assign(from.disk_utilization_percent_per_window.begin(), from.disk_utilization_percent_per_window.end());
+    to.disk_await_ms_per_window.assign(from.disk_await_ms_per_window.begin(), from.disk_await_ms_per_window.end());
+}
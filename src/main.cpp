@@ -3,21 +3,34 @@
 #include <chrono>
 #include <cstdlib>
 #include <cstring>
+#include <cstdio>
+#include <ctime>
 #include "ConfigManager.h"
 #include "Printer.h"
 #include "SystemInfo.h"
+#include "SharedSnapshotRing.h"
+#include "MetricArchive.h"
 
 void printHelp() {
     std::cout << "Usage: ./your_program [options]\n"
               << "Options:\n"
               << "  -i, --iterations <number>   Number of iterations (default: 10)\n"
               << "  -d, --delay <milliseconds>  Delay between iterations in milliseconds (default: 100)\n"
+              << "  -r, --read-shared <name>    Read the snapshots another process publishes to shared memory instead of sampling\n"
+              << "  -a, --read-archive <path>   Print the last <iterations> rows of every tier of an archive file and exit\n"
+              << "  -m, --metric <name>         Metric to print from the archive (default: cpu.usage_percent)\n"
+              << "      --record <path>         Record every procfs read into a capture file while sampling\n"
+              << "      --replay <path>         Sample from a capture file instead of procfs\n"
+              << "      --replay-speed <factor> Replay at this multiple of the recorded pace, 0 for as fast as possible (default: 1)\n"
+              << "      --procfs-root <dir>     Read the procfs files from this directory instead of /proc\n"
               << "  -h, --help                  Show this help message\n";
 }
 
-void parseCommandLineArgs(int argc, char* argv[], int& iterations, int& delayMilliseconds) {
+void parseCommandLineArgs(int argc, char* argv[], int& iterations, int& delayMilliseconds, std::string& sharedMemoryName,
+                          std::string& archivePath, std::string& metric) {
     iterations = 10;
     delayMilliseconds = 100;
+    metric = "cpu.usage_percent";
 
     for (int i = 1; i < argc; ++i) {
         if (std::strcmp(argv[i], "-i") == 0 || std::strcmp(argv[i], "--iterations") == 0) {
@@ -34,6 +47,51 @@ void parseCommandLineArgs(int argc, char* argv[], int& iterations, int& delayMil
                 std::cerr << "Error: --delay option requires a number.\n";
                 exit(1);
             }
+        } else if (std::strcmp(argv[i], "-r") == 0 || std::strcmp(argv[i], "--read-shared") == 0) {
+            if (i + 1 < argc) {
+                sharedMemoryName = argv[++i];
+            } else {
+                std::cerr << "Error: --read-shared option requires a shared memory name.\n";
+                exit(1);
+            }
+        } else if (std::strcmp(argv[i], "-a") == 0 || std::strcmp(argv[i], "--read-archive") == 0) {
+            if (i + 1 < argc) {
+                archivePath = argv[++i];
+            } else {
+                std::cerr << "Error: --read-archive option requires a file path.\n";
+                exit(1);
+            }
+        } else if (std::strcmp(argv[i], "-m") == 0 || std::strcmp(argv[i], "--metric") == 0) {
+            if (i + 1 < argc) {
+                metric = argv[++i];
+            } else {
+                std::cerr << "Error: --metric option requires a metric name.\n";
+                exit(1);
+            }
+        } else if (std::strcmp(argv[i], "--record") == 0 || std::strcmp(argv[i], "--replay") == 0) {
+            // Applied to the configuration before SystemInfo makes the first procfs read
+            if (i + 1 < argc) {
+                const char* mode = std::strcmp(argv[i], "--record") == 0 ? "record" : "replay";
+                ConfigManager::getInstance().setCapture(mode, argv[i + 1]);
+                ++i;
+            } else {
+                std::cerr << "Error: " << argv[i] << " option requires a file path.\n";
+                exit(1);
+            }
+        } else if (std::strcmp(argv[i], "--replay-speed") == 0) {
+            if (i + 1 < argc) {
+                ConfigManager::getInstance().setReplaySpeed(std::atof(argv[++i]));
+            } else {
+                std::cerr << "Error: --replay-speed option requires a number.\n";
+                exit(1);
+            }
+        } else if (std::strcmp(argv[i], "--procfs-root") == 0) {
+            if (i + 1 < argc) {
+                ConfigManager::getInstance().setProcfsRoot(argv[++i]);
+            } else {
+                std::cerr << "Error: --procfs-root option requires a directory.\n";
+                exit(1);
+            }
         } else if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0) {
             printHelp();
             exit(0);
@@ -45,11 +103,92 @@ void parseCommandLineArgs(int argc, char* argv[], int& iterations, int& delayMil
     }
 }
 
+// Prints a few metrics of the snapshots published by another process, without sampling anything here
+int readSharedSnapshots(const std::string& name, int iterations, int delayMilliseconds) {
+    Printer& printer = Printer::getInstance();
+    SharedSnapshotReader reader;
+    if (!reader.open(name)) {
+        printer.printError("No snapshot ring published under " + name + ".");
+        return 1;
+    }
+
+    const SnapshotSchema& schema = reader.getSchema();
+    std::vector<char> snapshotBuffer(schema.getSize());
+    const SnapshotSchema::Field* availableField = schema.findField("memory.available_bytes");
+    const SnapshotSchema::Field* cpuUsageField = schema.findField("cpu.usage_percent");
+    printer.print("Reading " + name + ": " + std::to_string(schema.getFields().size()) + " fields, " +
+                  std::to_string(reader.getNumSlots()) + " slots.");
+
+    for (int i = 0; i < iterations; ++i) {
+        unsigned long long index;
+        if (reader.readLatest(snapshotBuffer.data(), snapshotBuffer.size(), &index) != 0 && availableField && cpuUsageField) {
+            int64_t availableBytes;
+            double cpuUsage;
+            std::memcpy(&availableBytes, snapshotBuffer.data() + availableField->offset, sizeof(availableBytes));
+            std::memcpy(&cpuUsage, snapshotBuffer.data() + cpuUsageField->offset, sizeof(cpuUsage));
+            printer.print("Snapshot #" + std::to_string(index) + ": memory.available_bytes = " + std::to_string(availableBytes) +
+                          ", cpu.usage_percent = " + std::to_string(cpuUsage));
+        }
+        if (!reader.isWriterActive()) {
+            printer.printWarning("The writer of " + name + " stopped publishing.");
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(delayMilliseconds));
+    }
+    return 0;
+}
+
+// Prints the most recent rows of one metric in every tier of an archive file, e.g. after a crash or reboot
+int readArchive(const std::string& path, const std::string& metric, int numRows) {
+    MetricArchive archive;
+    if (!archive.openReadOnly(path)) {
+        std::cerr << "Error: " << path << " is not a readable archive.\n";
+        return 1;
+    }
+    const std::vector<SnapshotSchema::Field>& fields = archive.getSchema().getFields();
+    size_t field = 0;
+    while (field < fields.size() && fields[field].name != metric) {
+        ++field;
+    }
+    if (field == fields.size()) {
+        std::cerr << "Error: " << path << " has no metric " << metric << ".\n";
+        return 1;
+    }
+
+    std::vector<ArchiveRow> rows;
+    for (size_t tier = 0; tier < archive.getNumTiers(); ++tier) {
+        rows.clear();
+        archive.readRows(tier, field, rows);
+        std::printf("%s, tier %zu: %lld s x %zu rows, %zu written\n", metric.c_str(), tier,
+                    archive.getTierResolutionNs(tier) / 1000000000LL, archive.getTierRows(tier), rows.size());
+        std::printf("  %-19s %8s %16s %16s %16s\n", "start", "samples", "min", "avg", "max");
+        size_t first = rows.size() > static_cast<size_t>(numRows) ? rows.size() - static_cast<size_t>(numRows) : 0;
+        for (size_t i = first; i < rows.size(); ++i) {
+            time_t startSeconds = static_cast<time_t>(rows[i].startNs / 1000000000LL);
+            struct tm startTime;
+            char startText[32];
+            localtime_r(&startSeconds, &startTime);
+            std::strftime(startText, sizeof(startText), "%Y-%m-%d %H:%M:%S", &startTime);
+            std::printf("  %-19s %8u %16.6g %16.6g %16.6g\n", startText, rows[i].count, rows[i].min, rows[i].avg, rows[i].max);
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     int iterations;
     int delayMilliseconds;
+    std::string sharedMemoryName;
+    std::string archivePath;
+    std::string metric;
     
-    parseCommandLineArgs(argc, argv, iterations, delayMilliseconds);
+    parseCommandLineArgs(argc, argv, iterations, delayMilliseconds, sharedMemoryName, archivePath, metric);
+    if (!archivePath.empty()) {
+        return readArchive(archivePath, metric, iterations);
+    }
+    if (!sharedMemoryName.empty()) {
+        return readSharedSnapshots(sharedMemoryName, iterations, delayMilliseconds);
+    }
 
     // Get instance of Printer
     Printer& printer = Printer::getInstance(); 
@@ -58,7 +197,13 @@ int main(int argc, char* argv[]) {
     SystemInfo& systemInfo = SystemInfo::getInstance();
     systemInfo.startPeriodicUpdates();
 
-    
+    // Buffer for the serialized snapshots, sized once from the schema
+    const SnapshotSchema& schema = systemInfo.getSnapshotSchema();
+    std::vector<char> snapshotBuffer(schema.getSize());
+    const SnapshotSchema::Field* availableField = schema.findField("memory.available_bytes");
+    const SnapshotSchema::Field* cpuUsageField = schema.findField("cpu.usage_percent");
+    printer.print("Snapshot schema: " + std::to_string(schema.getFields().size()) + " fields, " + std::to_string(schema.getSize()) + " bytes.");
+
     for (int i = 0; i < iterations; ++i) {
         printer.print("-------------------------------");
         printer.print("Iteration #" + std::to_string(i+1));
@@ -72,6 +217,9 @@ int main(int argc, char* argv[]) {
         printer.print("Free RAM: " + std::to_string(data.free_ram) + " B");
         printer.print("Total RAM (MB): " + std::to_string(data.total_ram_MB) + " MB");
         printer.print("Free RAM (MB): " + std::to_string(data.free_ram_MB) + " MB");
+        printer.print("Available RAM (MB): " + std::to_string(data.memory.available_bytes / 1024 / 1024) + " MB, cached: " +
+                      std::to_string(data.memory.cached_bytes / 1024 / 1024) + " MB, dirty: " + std::to_string(data.memory.dirty_bytes / 1024) +
+                      " kB, swap used: " + std::to_string(data.memory.swap_used_bytes / 1024 / 1024) + " MB");
         printer.print("Total CPU Usage: " + std::to_string(data.cpu_usage_percent) + "%");
         printer.print("Time step for CPU Usage: " + std::to_string(data.cpu_real_time_step) + "s");
         printer.print("Number of CPU Processors: " + std::to_string(data.cpu_num_processors));
@@ -81,12 +229,98 @@ int main(int argc, char* argv[]) {
             printer.print("CPU Core " + std::to_string(core) + " Time step: " + std::to_string(data.cpu_real_time_step_per_core[core]) + "s");
         }
 
+        for (size_t window = 0; window < data.cpu_window_jiffies.size(); ++window) {
+            printer.print("Total CPU Usage over " + std::to_string(data.cpu_window_jiffies[window]) + " jiffies: " +
+                          std::to_string(data.cpu_usage_percent_per_window[window]) + "% (time step " +
+                          std::to_string(data.cpu_real_time_step_per_window[window]) + "s)");
+        }
+
+        // Summarize the recorded history of the total CPU usage over the last 10 seconds
+        const HistoryStore& history = systemInfo.getHistory();
+        std::vector<HistoryAggregate> cpuHistory;
+        if (history.queryAggregated(history.findSeries("cpu.usage_percent"), data.time_stamp_ns - 10000000000LL,
+                                    data.time_stamp_ns + 1, 10000000000LL, cpuHistory) > 0) {
+            printer.print("Total CPU Usage over the last 10 s of history: min " + std::to_string(cpuHistory[0].min) + "%, mean " +
+                          std::to_string(cpuHistory[0].mean) + "%, max " + std::to_string(cpuHistory[0].max) + "% (" +
+                          std::to_string(cpuHistory[0].count) + " samples)");
+        }
+
         // Print load averages
         printer.print("Load Average (1 min, 5 min, 15 min): " +
                       std::to_string(data.load_avg_1min) + " " +
                       std::to_string(data.load_avg_5min) + " " +
                       std::to_string(data.load_avg_15min));
 
+        // Print pressure stall information, -1 where the kernel does not report it
+        const char* pressureNames[] = { "CPU", "Memory", "I/O" };
+        const PressureInfo* pressures[] = { &data.pressure_cpu, &data.pressure_memory, &data.pressure_io };
+        for (int resource = 0; resource < 3; ++resource) {
+            const PressureInfo& pressure = *pressures[resource];
+            printer.print(std::string(pressureNames[resource]) + " Pressure (avg10, avg60, avg300, stall rate): some " +
+                          std::to_string(pressure.some_avg10) + " " + std::to_string(pressure.some_avg60) + " " +
+                          std::to_string(pressure.some_avg300) + " " + std::to_string(pressure.some_stall_percent) + "%, full " +
+                          std::to_string(pressure.full_avg10) + " " + std::to_string(pressure.full_avg60) + " " +
+                          std::to_string(pressure.full_avg300) + " " + std::to_string(pressure.full_stall_percent) + "%, triggers " +
+                          std::to_string(pressure.trigger_events));
+        }
+
+        // Print watched processes
+        for (const ProcessInfo& process : data.processes) {
+            if (process.pid != 0) {
+                printer.print("Process " + std::string(process.name) + " (" + std::to_string(process.pid) + "): CPU " +
+                              std::to_string(process.cpu_usage_percent) + "%, RSS " + std::to_string(process.rss_bytes / 1024) +
+                              " kB, threads " + std::to_string(process.num_threads));
+            }
+        }
+
+        // Print network interfaces
+        for (const NetworkInterfaceInfo& interface : data.network_interfaces) {
+            if (interface.name[0] != '\0') {
+                printer.print("Network " + std::string(interface.name) + ": rx " + std::to_string(interface.rx_bytes_per_second / 1024) +
+                              " kB/s " + std::to_string(interface.rx_packets_per_second) + " pkt/s, tx " +
+                              std::to_string(interface.tx_bytes_per_second / 1024) + " kB/s " + std::to_string(interface.tx_packets_per_second) +
+                              " pkt/s, errors " + std::to_string(interface.rx_errors_per_second + interface.tx_errors_per_second) +
+                              "/s, drops " + std::to_string(interface.rx_dropped_per_second + interface.tx_dropped_per_second) + "/s");
+            }
+        }
+
+        // Print block devices
+        for (const DiskDeviceInfo& device : data.disk_devices) {
+            if (device.name[0] != '\0') {
+                printer.print("Disk " + std::string(device.name) + ": read " + std::to_string(device.read_iops) + " IOPS " +
+                              std::to_string(device.read_bytes_per_second / 1024 / 1024) + " MB/s, write " + std::to_string(device.write_iops) +
+                              " IOPS " + std::to_string(device.write_bytes_per_second / 1024 / 1024) + " MB/s, await " +
+                              std::to_string(device.await_ms) + " ms, queue " + std::to_string(device.queue_depth) + ", util " +
+                              std::to_string(device.utilization_percent) + "%");
+            }
+        }
+
+        // Print sampling timing
+        printer.print("Sample lateness: " + std::to_string(data.sample_lateness_ns / 1000.0) + " us, missed updates: " +
+                      std::to_string(data.missed_updates));
+        for (const SourceFreshness& freshness : data.source_freshness) {
+            printer.print("Source " + std::string(freshness.name) + ": period " + std::to_string(freshness.period_ns / 1000000) +
+                          " ms, last sampled at " + std::to_string(freshness.time_stamp_ns) + " ns");
+        }
+
+        // Print the monitor's own cost
+        const MonitorStats& monitor = data.monitor;
+        printer.print("Monitor: " + std::to_string(monitor.samples) + " samples, collect p50/p99/max " +
+                      std::to_string(monitor.collect_p50_ns / 1000.0) + "/" + std::to_string(monitor.collect_p99_ns / 1000.0) + "/" +
+                      std::to_string(monitor.collect_max_ns / 1000.0) + " us, lock held p99 " + std::to_string(monitor.publish_lock_p99_ns / 1000.0) +
+                      " us, wake-up lateness p99 " + std::to_string(monitor.wakeup_lateness_p99_ns / 1000.0) + " us (jitter " +
+                      std::to_string(monitor.wakeup_jitter_ns / 1000.0) + " us), CPU " + std::to_string(monitor.cpu_overhead_percent) + "%");
+
+        // Serialize the snapshot as a MIDAS frontend would into its bank, and read two metrics back by name
+        if (systemInfo.writeSnapshot(snapshotBuffer.data(), snapshotBuffer.size()) != 0 && availableField && cpuUsageField) {
+            int64_t availableBytes;
+            double cpuUsage;
+            std::memcpy(&availableBytes, snapshotBuffer.data() + availableField->offset, sizeof(availableBytes));
+            std::memcpy(&cpuUsage, snapshotBuffer.data() + cpuUsageField->offset, sizeof(cpuUsage));
+            printer.print("Serialized snapshot: memory.available_bytes = " + std::to_string(availableBytes) +
+                          ", cpu.usage_percent = " + std::to_string(cpuUsage));
+        }
+
         // Package system information for MIDAS
         std::vector<double> systemInfoData = systemInfo.packageSystemInfoForMIDAS();
         printer.print("System Info for MIDAS: ");
@@ -98,6 +332,9 @@ int main(int argc, char* argv[]) {
         std::this_thread::sleep_for(std::chrono::milliseconds(delayMilliseconds));
     }
 
+    // Stop sampling and let the output sinks write out what they have queued
+    systemInfo.stopPeriodicUpdates();
+
 
     return 0;
 }